@@ -0,0 +1,188 @@
+// arena.h - aligned, optionally huge-page backed arena allocator
+// ------------------------------------------------------------
+// Single-header library in the style of stb_image: include it
+// anywhere for the declarations, and in exactly one C or C++ file
+//
+//     #define ARENA_IMPLEMENTATION
+//     #include "arena.h"
+//
+// to compile the implementation (C files need _GNU_SOURCE for the
+// mmap / madvise flags).
+//
+// One anonymous mapping is reserved up front and handed out by bumping
+// a pointer, every block 64-byte (cache line) aligned or page aligned
+// on request. With ARENA_HUGE the mapping is backed by 2 MiB pages:
+// MAP_HUGETLB when the kernel has a huge page pool, otherwise a 2 MiB
+// aligned mapping advised with MADV_HUGEPAGE (transparent huge pages),
+// otherwise plain 4 KiB pages. arena_reset() makes the whole arena
+// available again without unmapping it, so repeated runs reuse pages
+// that are already faulted in.
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ARENA_ALIGN      64
+#define ARENA_HUGE_PAGE  (2u << 20)
+
+// arena_init flags
+#define ARENA_HUGE    1  // back with 2 MiB pages (with fallback)
+#define ARENA_NO_HUGE 2  // force 4 KiB pages (MADV_NOHUGEPAGE), for comparisons
+
+// How the arena is actually backed.
+typedef enum {
+    ARENA_PAGES_4K,       // regular pages
+    ARENA_PAGES_THP,      // transparent huge pages requested (madvise)
+    ARENA_PAGES_HUGETLB   // explicit huge page pool (MAP_HUGETLB)
+} arena_pages_t;
+
+typedef struct {
+    unsigned char *base;   // aligned start handed out
+    size_t capacity;       // usable bytes from base
+    size_t used;
+    void *map;             // mapping to unmap
+    size_t map_size;
+    arena_pages_t pages;
+} arena_t;
+
+// Reserve 'capacity' bytes. Returns 0 on success.
+int arena_init(arena_t *a, size_t capacity, int flags);
+
+// 'bytes' from the arena, ARENA_ALIGN aligned, or NULL when full.
+void *arena_alloc(arena_t *a, size_t bytes);
+
+// Same with an explicit power-of-two alignment (e.g. 4096 or
+// ARENA_HUGE_PAGE).
+void *arena_alloc_aligned(arena_t *a, size_t bytes, size_t align);
+
+// Forget every allocation but keep the mapping (and its faulted pages).
+void arena_reset(arena_t *a);
+
+void arena_release(arena_t *a);
+
+// "4k", "thp" or "hugetlb".
+const char *arena_pages_name(const arena_t *a);
+
+// Bytes of the arena the kernel currently backs with huge pages (from
+// /proc/self/smaps); 0 if unknown.
+size_t arena_huge_bytes(const arena_t *a);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ARENA_H
+
+#if defined(ARENA_IMPLEMENTATION) && !defined(ARENA_IMPLEMENTED)
+#define ARENA_IMPLEMENTED
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+static size_t arena__round_up(size_t v, size_t align) {
+    return (v + align - 1) & ~(align - 1);
+}
+
+int arena_init(arena_t *a, size_t capacity, int flags) {
+    memset(a, 0, sizeof(*a));
+    int prot = PROT_READ | PROT_WRITE;
+    int map_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+    if (flags & ARENA_HUGE) {
+        capacity = arena__round_up(capacity, ARENA_HUGE_PAGE);
+#ifdef MAP_HUGETLB
+        void *p = mmap(NULL, capacity, prot, map_flags | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            a->map = a->base = (unsigned char *)p;
+            a->map_size = a->capacity = capacity;
+            a->pages = ARENA_PAGES_HUGETLB;
+            return 0;
+        }
+#endif
+        // No huge page pool: over-allocate so the start can be 2 MiB
+        // aligned, then ask for transparent huge pages.
+        size_t size = capacity + ARENA_HUGE_PAGE;
+        void *q = mmap(NULL, size, prot, map_flags, -1, 0);
+        if (q == MAP_FAILED) return -1;
+        a->map = q;
+        a->map_size = size;
+        a->base = (unsigned char *)arena__round_up((uintptr_t)q, ARENA_HUGE_PAGE);
+        a->capacity = capacity;
+        a->pages = ARENA_PAGES_4K;
+#ifdef MADV_HUGEPAGE
+        if (madvise(a->base, capacity, MADV_HUGEPAGE) == 0) a->pages = ARENA_PAGES_THP;
+#endif
+        return 0;
+    }
+
+    capacity = arena__round_up(capacity, 4096);
+    void *p = mmap(NULL, capacity, prot, map_flags, -1, 0);
+    if (p == MAP_FAILED) return -1;
+    a->map = a->base = (unsigned char *)p;
+    a->map_size = a->capacity = capacity;
+    a->pages = ARENA_PAGES_4K;
+#ifdef MADV_NOHUGEPAGE
+    if (flags & ARENA_NO_HUGE) madvise(p, capacity, MADV_NOHUGEPAGE);
+#endif
+    return 0;
+}
+
+void *arena_alloc_aligned(arena_t *a, size_t bytes, size_t align) {
+    if (align < ARENA_ALIGN) align = ARENA_ALIGN;
+    size_t start = arena__round_up(a->used, align);
+    if (!a->base || start + bytes > a->capacity) return NULL;
+    a->used = start + bytes;
+    return a->base + start;
+}
+
+void *arena_alloc(arena_t *a, size_t bytes) {
+    return arena_alloc_aligned(a, bytes, ARENA_ALIGN);
+}
+
+void arena_reset(arena_t *a) {
+    a->used = 0;
+}
+
+void arena_release(arena_t *a) {
+    if (a->map) munmap(a->map, a->map_size);
+    memset(a, 0, sizeof(*a));
+}
+
+const char *arena_pages_name(const arena_t *a) {
+    switch (a->pages) {
+    case ARENA_PAGES_HUGETLB: return "hugetlb";
+    case ARENA_PAGES_THP: return "thp";
+    default: return "4k";
+    }
+}
+
+size_t arena_huge_bytes(const arena_t *a) {
+    if (a->pages == ARENA_PAGES_HUGETLB) return a->capacity;
+    FILE *f = fopen("/proc/self/smaps", "r");
+    if (!f) return 0;
+    // Sum AnonHugePages over the mappings that overlap the arena.
+    uintptr_t lo = (uintptr_t)a->base, hi = lo + a->capacity;
+    size_t total = 0;
+    int inside = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long start, end;
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2 && strchr(line, '-') < strchr(line, ' ')) {
+            inside = start < hi && end > lo;
+        } else if (inside && strncmp(line, "AnonHugePages:", 14) == 0) {
+            unsigned long kb = 0;
+            if (sscanf(line + 14, "%lu", &kb) == 1) total += (size_t)kb * 1024;
+        }
+    }
+    fclose(f);
+    return total;
+}
+
+#endif // ARENA_IMPLEMENTATION
@@ -0,0 +1,243 @@
+// bench - repeated timing of a command with robust statistics
+// ------------------------------------------------------------
+// Runs a command (or two, to compare them) several times after warmup
+// runs, reads the time each run prints, rejects outliers and reports the
+// median with a bootstrap confidence interval (benchstat.h). With two
+// commands the runs alternate A B A B ... so slow drift of the machine
+// hits both alike, and the result says whether B differs from A beyond
+// the noise.
+//
+//   bench [options] "cmd A" ["cmd B"]
+//   bench [options] --samples < times.txt     (one time per line)
+//   bench --check [--baseline=REV] [--threshold=PCT]
+//
+//   --runs=R           measured runs per command (default 10)
+//   --warmup=W         discarded runs per command first (default 1)
+//   --label=TEXT       the time follows TEXT in the output (default
+//                      "Execution time:" or "CONV_TIME")
+//   --confidence=C     interval level (default 0.95)
+//   --resamples=B      bootstrap resamples (default 10000)
+//   --outliers=K       reject beyond K scaled MADs, 0 keeps all (default 3)
+//   --cpu=C            pin to one logical CPU (inherited by the commands)
+//   --strict           fail if the system check finds a noise source
+//   --echo             show the commands' output
+//   --record=VARIANT   append the result of the single command to the
+//                      results store (resultdb.h), keyed by VARIANT,
+//                      --params=TEXT, this host and the git revision
+//   --db=PATH          results store (default $RESULTDB)
+//   --check            compare this host's latest results against the
+//                      baseline revision (--baseline=REV, default the
+//                      previous one) and fail on a slowdown beyond
+//                      --threshold=PCT (default 5) outside the noise
+//
+// Exit status: 0, or 1 if a run failed, a significance test could not be
+// made, --strict found noise, or --check could not read the store, found
+// no results for this host or found a regression.
+// Build: cc -O2 -I. bench.c -lm -pthread.
+#define _GNU_SOURCE
+#define BENCHSTAT_IMPLEMENTATION
+#include "benchstat.h"
+#define TOPOLOGY_IMPLEMENTATION
+#include "topology.h"
+#define TUNEDB_IMPLEMENTATION
+#include "tunedb.h"
+#define RESULTDB_IMPLEMENTATION
+#include "resultdb.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    int runs, warmup, resamples, cpu, strict, echo, samples, check;
+    double confidence, outliers, threshold;
+    const char *label, *record, *params, *db, *baseline;
+} bench_opts;
+
+static void print_stats(const char *tag, const char *cmd, const bench_stats_t *s,
+                        const bench_opts *o) {
+    printf("%s: %s\n", tag, cmd);
+    printf("  median %.6f s  %g%% CI [%.6f, %.6f]\n", s->median, 100.0 * o->confidence,
+           s->ci_lo, s->ci_hi);
+    printf("  mean %.6f s  sd %.6f (%.1f%%)  min %.6f  max %.6f  kept %d/%d\n", s->mean,
+           s->stddev, s->mean > 0 ? 100.0 * s->stddev / s->mean : 0.0, s->min, s->max, s->n,
+           s->n + s->rejected);
+}
+
+// Reject outliers in x[0 .. n) and summarize the rest.
+static void summarize(double *x, int n, const bench_opts *o, uint64_t seed, bench_stats_t *s) {
+    int kept = bench_reject(x, n, o->outliers);
+    bench_summarize(x, kept, o->confidence, o->resamples, seed, s);
+    s->rejected = n - kept;
+}
+
+static int read_samples(const bench_opts *o) {
+    int cap = 64, n = 0;
+    double *x = malloc((size_t)cap * sizeof(double)), v;
+    if (!x) return 1;
+    while (scanf("%lf", &v) == 1) {
+        if (n == cap) {
+            double *grown = realloc(x, (size_t)(cap *= 2) * sizeof(double));
+            if (!grown) {
+                free(x);
+                return 1;
+            }
+            x = grown;
+        }
+        x[n++] = v;
+    }
+    if (n == 0) {
+        fprintf(stderr, "Error: no samples on stdin\n");
+        free(x);
+        return 1;
+    }
+    bench_stats_t s;
+    summarize(x, n, o, 1, &s);
+    print_stats("Samples", "stdin", &s, o);
+    free(x);
+    return 0;
+}
+
+static int record(const bench_opts *o, const bench_stats_t *s) {
+    resultdb_rec_t r;
+    memset(&r, 0, sizeof(r));
+    r.time = (long long)time(NULL);
+    resultdb_git_rev(r.rev, sizeof(r.rev));
+    tunedb_host_key(r.host, sizeof(r.host));
+    snprintf(r.variant, sizeof(r.variant), "%s", o->record);
+    snprintf(r.params, sizeof(r.params), "%s", o->params);
+    r.runs = s->n;
+    r.median = s->median;
+    r.ci_lo = s->ci_lo;
+    r.ci_hi = s->ci_hi;
+    r.mean = s->mean;
+    r.stddev = s->stddev;
+    r.min = s->min;
+    if (resultdb_append(o->db, &r) != 0) {
+        fprintf(stderr, "Error: cannot append to %s\n", o->db);
+        return 1;
+    }
+    printf("Recorded %s [%s] at %s in %s\n", r.variant, r.params, r.rev, o->db);
+    return 0;
+}
+
+static int check(const bench_opts *o) {
+    resultdb_rec_t *recs;
+    int n = resultdb_load(o->db, &recs);
+    if (n < 0) {
+        fprintf(stderr, "Error: cannot read results store %s\n", o->db);
+        return 1;
+    }
+    char host[RESULTDB_FIELD];
+    tunedb_host_key(host, sizeof(host));
+    printf("Results: %s, host %s\n", o->db, host);
+    int regressions = resultdb_compare(recs, n, host, o->baseline, o->threshold, stdout);
+    free(recs);
+    return regressions ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    bench_opts o = {10, 1, 10000, -1, 0, 0, 0, 0, 0.95, 3.0, 0.05,
+                    NULL, NULL, "", resultdb_default_path(), NULL};
+    const char *cmd[2] = {NULL, NULL};
+    int ncmd = 0;
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        if (strncmp(a, "--runs=", 7) == 0) o.runs = atoi(a + 7);
+        else if (strncmp(a, "--warmup=", 9) == 0) o.warmup = atoi(a + 9);
+        else if (strncmp(a, "--label=", 8) == 0) o.label = a + 8;
+        else if (strncmp(a, "--confidence=", 13) == 0) o.confidence = atof(a + 13);
+        else if (strncmp(a, "--resamples=", 12) == 0) o.resamples = atoi(a + 12);
+        else if (strncmp(a, "--outliers=", 11) == 0) o.outliers = atof(a + 11);
+        else if (strncmp(a, "--cpu=", 6) == 0) o.cpu = atoi(a + 6);
+        else if (strcmp(a, "--strict") == 0) o.strict = 1;
+        else if (strcmp(a, "--echo") == 0) o.echo = 1;
+        else if (strcmp(a, "--samples") == 0) o.samples = 1;
+        else if (strncmp(a, "--record=", 9) == 0) o.record = a + 9;
+        else if (strncmp(a, "--params=", 9) == 0) o.params = a + 9;
+        else if (strncmp(a, "--db=", 5) == 0) o.db = a + 5;
+        else if (strcmp(a, "--check") == 0) o.check = 1;
+        else if (strncmp(a, "--baseline=", 11) == 0) o.baseline = a + 11;
+        else if (strncmp(a, "--threshold=", 12) == 0) o.threshold = atof(a + 12) / 100.0;
+        else if (a[0] == '-' && a[1] == '-') {
+            fprintf(stderr, "Error: unknown option %s\n", a);
+            return 1;
+        } else if (ncmd < 2) cmd[ncmd++] = a;
+        else {
+            fprintf(stderr, "Error: at most two commands\n");
+            return 1;
+        }
+    }
+    if (o.confidence <= 0 || o.confidence >= 1 || o.runs < 1 || o.warmup < 0) {
+        fprintf(stderr, "Error: need --runs >= 1, --warmup >= 0, 0 < --confidence < 1\n");
+        return 1;
+    }
+    if (o.check) return check(&o);
+    if (o.samples) return read_samples(&o);
+    if (ncmd == 0) {
+        fprintf(stderr, "Usage: %s [options] \"cmd A\" [\"cmd B\"]\n", argv[0]);
+        return 1;
+    }
+    if (o.record && ncmd != 1) {
+        fprintf(stderr, "Error: --record takes a single command\n");
+        return 1;
+    }
+
+    int noisy = bench_check_system(stdout);
+    if (noisy && o.strict) {
+        fprintf(stderr, "Error: noisy system (--strict)\n");
+        return 1;
+    }
+    if (o.cpu >= 0) {
+        if (topo_pin_thread(o.cpu) != 0) {
+            fprintf(stderr, "Error: cannot pin to CPU %d\n", o.cpu);
+            return 1;
+        }
+        printf("Pinned to CPU %d\n", o.cpu);
+    }
+    printf("Runs: %d per command after %d warmup, outliers beyond %g MAD rejected\n", o.runs,
+           o.warmup, o.outliers);
+
+    double *x[2];
+    for (int c = 0; c < ncmd; ++c) {
+        x[c] = malloc((size_t)o.runs * sizeof(double));
+        if (!x[c]) return 1;
+    }
+    for (int r = -o.warmup; r < o.runs; ++r) {
+        for (int c = 0; c < ncmd; ++c) {
+            double t;
+            if (bench_run_once(cmd[c], o.label, o.echo, &t) != 0) {
+                fprintf(stderr, "Error: '%s' failed or printed no time\n", cmd[c]);
+                return 1;
+            }
+            if (r >= 0) x[c][r] = t;
+        }
+    }
+
+    bench_stats_t s[2];
+    for (int c = 0; c < ncmd; ++c) summarize(x[c], o.runs, &o, 1 + (uint64_t)c, &s[c]);
+    print_stats("A", cmd[0], &s[0], &o);
+    int rc = o.record ? record(&o, &s[0]) : 0;
+    if (ncmd == 2) {
+        print_stats("B", cmd[1], &s[1], &o);
+        bench_compare_t cmp;
+        bench_compare(x[0], s[0].n, x[1], s[1].n, o.confidence, o.resamples, 3, &cmp);
+        if (cmp.ratio <= 0) {
+            fprintf(stderr, "Error: comparison failed\n");
+            rc = 1;
+        } else {
+            double pct = 100.0 * (1.0 - cmp.ratio);
+            printf("B/A time: %.4f  %g%% CI [%.4f, %.4f]\n", cmp.ratio, 100.0 * o.confidence,
+                   cmp.lo, cmp.hi);
+            if (cmp.significant)
+                printf("Result: B is %.1f%% %s than A (significant)\n", pct < 0 ? -pct : pct,
+                       pct > 0 ? "faster" : "slower");
+            else
+                printf("Result: no significant difference (interval contains 1)\n");
+        }
+    }
+    if (noisy) printf("Note: %d noise source(s) above; intervals may be optimistic\n", noisy);
+    for (int c = 0; c < ncmd; ++c) free(x[c]);
+    return rc;
+}
@@ -0,0 +1,280 @@
+// benchstat.h - repeated timing runs with robust statistics
+// ------------------------------------------------------------
+// Single-header library in the style of stb_image: include it
+// anywhere for the declarations, and in exactly one C or C++ file
+//
+//     #define BENCHSTAT_IMPLEMENTATION
+//     #include "benchstat.h"
+//
+// to compile the implementation (C files need _GNU_SOURCE or
+// _POSIX_C_SOURCE for popen). bench.c wraps it into the command line
+// runner used by the `bench` targets of both homeworks.
+//
+//   bench_run_once      runs a shell command and reads the time it
+//                       prints ("Execution time: X", "CONV_TIME X" or
+//                       any other label)
+//   bench_reject        drops samples further than k scaled MADs from
+//                       the median (robust against one-off stalls)
+//   bench_summarize     median, mean, spread and a percentile bootstrap
+//                       confidence interval of the median
+//   bench_compare       bootstrap interval of the ratio of two medians;
+//                       the difference is significant when the interval
+//                       excludes 1
+//   bench_check_system  reports what makes timings noisy here: a
+//                       frequency governor other than performance,
+//                       turbo / boost enabled, other load on the machine
+//
+// Medians rather than means throughout: run times are skewed (a run can
+// be slowed down, never sped up, by interference).
+
+#ifndef BENCHSTAT_H
+#define BENCHSTAT_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int n;              // samples kept
+    int rejected;       // outliers dropped by bench_reject
+    double median, mean, stddev, min, max;
+    double ci_lo, ci_hi;  // bootstrap interval of the median
+} bench_stats_t;
+
+typedef struct {
+    double ratio;       // median(b) / median(a)
+    double lo, hi;      // bootstrap interval of the ratio
+    int significant;    // interval excludes 1
+} bench_compare_t;
+
+// Run 'cmd' through the shell and parse the number following the first
+// occurrence of 'label' in its output (NULL tries "Execution time:"
+// then "CONV_TIME"). Output is echoed to stdout when 'echo' is set.
+// Returns 0, or -1 if the command failed or printed no time.
+int bench_run_once(const char *cmd, const char *label, int echo, double *seconds);
+
+// Sort x and keep the samples within k * 1.4826 * MAD of the median
+// (k <= 0 keeps all). Returns the new count; x[0 .. count) are kept.
+int bench_reject(double *x, int n, double k);
+
+// Statistics of x[0 .. n) with a 'conf' (e.g. 0.95) interval from
+// 'resamples' bootstrap resamples.
+void bench_summarize(const double *x, int n, double conf, int resamples, uint64_t seed,
+                     bench_stats_t *s);
+
+void bench_compare(const double *a, int na, const double *b, int nb, double conf,
+                   int resamples, uint64_t seed, bench_compare_t *c);
+
+// Print the noise sources found to 'f'; returns how many there are.
+int bench_check_system(FILE *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCHSTAT_H
+
+#if defined(BENCHSTAT_IMPLEMENTATION) && !defined(BENCHSTAT_IMPLEMENTED)
+#define BENCHSTAT_IMPLEMENTED
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+int bench_run_once(const char *cmd, const char *label, int echo, double *seconds) {
+    FILE *p = popen(cmd, "r");
+    if (!p) return -1;
+    static const char *defaults[] = {"Execution time:", "CONV_TIME"};
+    char line[1024];
+    int found = 0;
+    while (fgets(line, sizeof(line), p)) {
+        if (echo) fputs(line, stdout);
+        for (int i = 0; i < (label ? 1 : 2) && !found; ++i) {
+            const char *key = label ? label : defaults[i];
+            const char *at = strstr(line, key);
+            char *end = NULL;
+            double v = at ? strtod(at + strlen(key), &end) : 0.0;
+            if (at && end != at + strlen(key)) {
+                *seconds = v;
+                found = 1;
+            }
+        }
+    }
+    int status = pclose(p);
+    return (status == 0 && found) ? 0 : -1;
+}
+
+static int bench__cmp(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Median of a sorted array.
+static double bench__median_sorted(const double *x, int n) {
+    return n % 2 ? x[n / 2] : 0.5 * (x[n / 2 - 1] + x[n / 2]);
+}
+
+static double bench__median(double *x, int n) {
+    qsort(x, (size_t)n, sizeof(double), bench__cmp);
+    return bench__median_sorted(x, n);
+}
+
+int bench_reject(double *x, int n, double k) {
+    if (n < 3 || k <= 0) {
+        qsort(x, (size_t)n, sizeof(double), bench__cmp);
+        return n;
+    }
+    double med = bench__median(x, n);
+    double *dev = (double *)malloc((size_t)n * sizeof(double));
+    if (!dev) return n;
+    for (int i = 0; i < n; ++i) dev[i] = fabs(x[i] - med);
+    double mad = 1.4826 * bench__median(dev, n);
+    free(dev);
+    int kept = 0;
+    for (int i = 0; i < n; ++i)
+        if (mad == 0.0 || fabs(x[i] - med) <= k * mad) x[kept++] = x[i];
+    return kept;
+}
+
+static uint64_t bench__next(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// Median of one bootstrap resample of x into 'buf'.
+static double bench__resample_median(const double *x, int n, double *buf, uint64_t *state) {
+    for (int i = 0; i < n; ++i) buf[i] = x[bench__next(state) % (uint64_t)n];
+    return bench__median(buf, n);
+}
+
+// Percentile interval of r[0 .. m).
+static void bench__interval(double *r, int m, double conf, double *lo, double *hi) {
+    qsort(r, (size_t)m, sizeof(double), bench__cmp);
+    double tail = 0.5 * (1.0 - conf);
+    int i = (int)floor(tail * (m - 1)), j = (int)ceil((1.0 - tail) * (m - 1));
+    *lo = r[i];
+    *hi = r[j];
+}
+
+void bench_summarize(const double *x, int n, double conf, int resamples, uint64_t seed,
+                     bench_stats_t *s) {
+    memset(s, 0, sizeof(*s));
+    s->n = n;
+    if (n <= 0) return;
+    double *sorted = (double *)malloc((size_t)n * sizeof(double));
+    double *buf = (double *)malloc((size_t)n * sizeof(double));
+    double *r = (double *)malloc((size_t)(resamples > 0 ? resamples : 1) * sizeof(double));
+    if (!sorted || !buf || !r) {
+        free(sorted);
+        free(buf);
+        free(r);
+        return;
+    }
+    memcpy(sorted, x, (size_t)n * sizeof(double));
+    s->median = bench__median(sorted, n);
+    s->min = sorted[0];
+    s->max = sorted[n - 1];
+    for (int i = 0; i < n; ++i) s->mean += x[i] / n;
+    for (int i = 0; i < n; ++i) s->stddev += (x[i] - s->mean) * (x[i] - s->mean);
+    s->stddev = n > 1 ? sqrt(s->stddev / (n - 1)) : 0.0;
+    uint64_t state = seed;
+    for (int b = 0; b < resamples; ++b) r[b] = bench__resample_median(x, n, buf, &state);
+    if (resamples > 0)
+        bench__interval(r, resamples, conf, &s->ci_lo, &s->ci_hi);
+    else
+        s->ci_lo = s->ci_hi = s->median;
+    free(sorted);
+    free(buf);
+    free(r);
+}
+
+void bench_compare(const double *a, int na, const double *b, int nb, double conf,
+                   int resamples, uint64_t seed, bench_compare_t *c) {
+    memset(c, 0, sizeof(*c));
+    if (na <= 0 || nb <= 0 || resamples <= 0) return;
+    double *buf = (double *)malloc((size_t)(na > nb ? na : nb) * sizeof(double));
+    double *r = (double *)malloc((size_t)resamples * sizeof(double));
+    if (!buf || !r) {
+        free(buf);
+        free(r);
+        return;
+    }
+    memcpy(buf, a, (size_t)na * sizeof(double));
+    double ma = bench__median(buf, na);
+    memcpy(buf, b, (size_t)nb * sizeof(double));
+    double mb = bench__median(buf, nb);
+    c->ratio = mb / ma;
+    uint64_t state = seed;
+    for (int i = 0; i < resamples; ++i) {
+        double ra = bench__resample_median(a, na, buf, &state);
+        double rb = bench__resample_median(b, nb, buf, &state);
+        r[i] = rb / ra;
+    }
+    bench__interval(r, resamples, conf, &c->lo, &c->hi);
+    c->significant = c->lo > 1.0 || c->hi < 1.0;
+    free(buf);
+    free(r);
+}
+
+static int bench__read_line(const char *path, char *buf, size_t size) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    int ok = fgets(buf, (int)size, f) != NULL;
+    fclose(f);
+    if (!ok) return -1;
+    buf[strcspn(buf, "\n")] = '\0';
+    return 0;
+}
+
+int bench_check_system(FILE *f) {
+    int issues = 0;
+    char buf[128];
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) cpus = 1;
+
+    int governors = 0, slow = 0;
+    for (long c = 0; c < cpus; ++c) {
+        char path[128];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%ld/cpufreq/scaling_governor", c);
+        if (bench__read_line(path, buf, sizeof(buf)) != 0) continue;
+        ++governors;
+        if (strcmp(buf, "performance") != 0) ++slow;
+    }
+    if (governors == 0) {
+        fprintf(f, "System: cpufreq not exposed (virtual machine?), frequency not controlled\n");
+        ++issues;
+    } else if (slow > 0) {
+        fprintf(f, "System: %d of %d CPUs use a governor other than 'performance' "
+                   "(cpupower frequency-set -g performance)\n", slow, governors);
+        ++issues;
+    }
+
+    if (bench__read_line("/sys/devices/system/cpu/intel_pstate/no_turbo", buf, sizeof(buf)) == 0 &&
+        strcmp(buf, "0") == 0) {
+        fprintf(f, "System: turbo enabled (echo 1 > /sys/devices/system/cpu/intel_pstate/no_turbo)\n");
+        ++issues;
+    }
+    if (bench__read_line("/sys/devices/system/cpu/cpufreq/boost", buf, sizeof(buf)) == 0 &&
+        strcmp(buf, "1") == 0) {
+        fprintf(f, "System: boost enabled (echo 0 > /sys/devices/system/cpu/cpufreq/boost)\n");
+        ++issues;
+    }
+
+    double load = 0.0;
+    if (bench__read_line("/proc/loadavg", buf, sizeof(buf)) == 0 && sscanf(buf, "%lf", &load) == 1 &&
+        load > 0.5 * (double)cpus) {
+        fprintf(f, "System: load average %.2f on %ld CPU(s), other work competes for the machine\n",
+                load, cpus);
+        ++issues;
+    }
+    if (issues == 0) fprintf(f, "System: fixed frequency, no turbo, idle\n");
+    return issues;
+}
+
+#endif // BENCHSTAT_IMPLEMENTATION
@@ -0,0 +1,268 @@
+// resultdb.h - append-only store of benchmark results across commits
+// ------------------------------------------------------------
+// Single-header library in the style of stb_image: include it
+// anywhere for the declarations, and in exactly one C or C++ file
+//
+//     #define RESULTDB_IMPLEMENTATION
+//     #include "resultdb.h"
+//
+// to compile the implementation (C files need _GNU_SOURCE or
+// _POSIX_C_SOURCE for popen).
+//
+// The store is a JSON Lines file, one timing summary per line:
+//
+//     {"time":1760880000,"rev":"db64d7a","host":"Intel Xeon|L1d=48K|...",
+//      "variant":"matmul_tiling","params":"N=1024 --threads=1","runs":10,
+//      "median":0.51,"ci_lo":0.50,"ci_hi":0.53,"mean":0.51,"stddev":0.01,
+//      "min":0.50}
+//
+// A result is identified by (host, variant, params) and the git
+// revision it was measured at ("+dirty" when the tree had local
+// changes). Lines are only appended, so the file is the history of
+// every kernel; any JSON Lines reader (jq, pandas) can read it too.
+//
+// resultdb_compare takes the latest result of every (variant, params)
+// on this host and checks it against a baseline result of the same key:
+// the latest one at the given revision, or by default the latest one
+// measured at any other revision. A result is a regression when its
+// median is more than 'threshold' slower than the baseline's and the
+// two confidence intervals do not overlap, so noise alone is not
+// flagged.
+
+#ifndef RESULTDB_H
+#define RESULTDB_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RESULTDB_FIELD 256
+
+typedef struct {
+    long long time;               // seconds since the epoch
+    char rev[64];
+    char host[RESULTDB_FIELD];
+    char variant[RESULTDB_FIELD];
+    char params[RESULTDB_FIELD];
+    int runs;                     // samples behind the statistics
+    double median, ci_lo, ci_hi, mean, stddev, min;
+} resultdb_rec_t;
+
+// Path of the store: $RESULTDB, or "results/results.jsonl".
+const char *resultdb_default_path(void);
+
+// Short git revision of the working directory, with "+dirty" if
+// tracked files were modified; "unknown" outside a git tree.
+void resultdb_git_rev(char *buf, size_t size);
+
+// Append one result line. Returns 0 on success.
+int resultdb_append(const char *path, const resultdb_rec_t *r);
+
+// Read every result into a malloc'ed array (free it). Returns the count,
+// or -1 if the file cannot be opened or memory runs out. Lines that do
+// not parse are skipped.
+int resultdb_load(const char *path, resultdb_rec_t **recs);
+
+// Print the comparison of this host's latest results against the
+// baseline (a revision prefix, or NULL for "the previous revision") and
+// return the number of regressions, or -1 if there are no results for
+// this host. 'threshold' is a fraction (0.05).
+int resultdb_compare(const resultdb_rec_t *recs, int n, const char *host,
+                     const char *baseline, double threshold, FILE *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RESULTDB_H
+
+#if defined(RESULTDB_IMPLEMENTATION) && !defined(RESULTDB_IMPLEMENTED)
+#define RESULTDB_IMPLEMENTED
+
+#include <stdlib.h>
+#include <string.h>
+
+const char *resultdb_default_path(void) {
+    const char *env = getenv("RESULTDB");
+    return (env && *env) ? env : "results/results.jsonl";
+}
+
+// First line of a shell command's output, or "" if it printed nothing.
+static void resultdb__command(const char *cmd, char *buf, size_t size) {
+    buf[0] = '\0';
+    FILE *p = popen(cmd, "r");
+    if (!p) return;
+    if (!fgets(buf, (int)size, p)) buf[0] = '\0';
+    buf[strcspn(buf, "\n")] = '\0';
+    pclose(p);
+}
+
+void resultdb_git_rev(char *buf, size_t size) {
+    char rev[64], dirty[8];
+    resultdb__command("git rev-parse --short HEAD 2>/dev/null", rev, sizeof(rev));
+    if (!rev[0]) {
+        snprintf(buf, size, "unknown");
+        return;
+    }
+    resultdb__command("git status --porcelain --untracked-files=no 2>/dev/null", dirty,
+                      sizeof(dirty));
+    snprintf(buf, size, "%s%s", rev, dirty[0] ? "+dirty" : "");
+}
+
+static void resultdb__string(FILE *f, const char *key, const char *s) {
+    fprintf(f, "\"%s\":\"", key);
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        if ((unsigned char)*s >= 0x20) fputc(*s, f);
+    }
+    fputs("\",", f);
+}
+
+int resultdb_append(const char *path, const resultdb_rec_t *r) {
+    FILE *f = fopen(path, "a");
+    if (!f) return -1;
+    fprintf(f, "{\"time\":%lld,", r->time);
+    resultdb__string(f, "rev", r->rev);
+    resultdb__string(f, "host", r->host);
+    resultdb__string(f, "variant", r->variant);
+    resultdb__string(f, "params", r->params);
+    fprintf(f, "\"runs\":%d,\"median\":%.9g,\"ci_lo\":%.9g,\"ci_hi\":%.9g,\"mean\":%.9g,"
+               "\"stddev\":%.9g,\"min\":%.9g}\n",
+            r->runs, r->median, r->ci_lo, r->ci_hi, r->mean, r->stddev, r->min);
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+// Start of the value of "key" in a JSON object line, or NULL.
+static const char *resultdb__value(const char *line, const char *key) {
+    char pat[64];
+    snprintf(pat, sizeof(pat), "\"%s\":", key);
+    const char *at = strstr(line, pat);
+    return at ? at + strlen(pat) : NULL;
+}
+
+static int resultdb__get_string(const char *line, const char *key, char *out, size_t size) {
+    const char *v = resultdb__value(line, key);
+    if (!v || *v != '"') return -1;
+    size_t n = 0;
+    for (++v; *v && *v != '"'; ++v) {
+        if (*v == '\\' && v[1]) ++v;
+        if (n + 1 < size) out[n++] = *v;
+    }
+    out[n] = '\0';
+    return *v == '"' ? 0 : -1;
+}
+
+static int resultdb__get_number(const char *line, const char *key, double *out) {
+    const char *v = resultdb__value(line, key);
+    char *end;
+    if (!v) return -1;
+    *out = strtod(v, &end);
+    return end == v ? -1 : 0;
+}
+
+static int resultdb__parse(const char *line, resultdb_rec_t *r) {
+    double time, runs;
+    memset(r, 0, sizeof(*r));
+    if (resultdb__get_number(line, "time", &time) || resultdb__get_number(line, "runs", &runs) ||
+        resultdb__get_string(line, "rev", r->rev, sizeof(r->rev)) ||
+        resultdb__get_string(line, "host", r->host, sizeof(r->host)) ||
+        resultdb__get_string(line, "variant", r->variant, sizeof(r->variant)) ||
+        resultdb__get_string(line, "params", r->params, sizeof(r->params)) ||
+        resultdb__get_number(line, "median", &r->median) ||
+        resultdb__get_number(line, "ci_lo", &r->ci_lo) ||
+        resultdb__get_number(line, "ci_hi", &r->ci_hi))
+        return -1;
+    r->time = (long long)time;
+    r->runs = (int)runs;
+    resultdb__get_number(line, "mean", &r->mean);
+    resultdb__get_number(line, "stddev", &r->stddev);
+    resultdb__get_number(line, "min", &r->min);
+    return 0;
+}
+
+int resultdb_load(const char *path, resultdb_rec_t **recs) {
+    *recs = NULL;
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    int n = 0, cap = 0;
+    char line[2048];
+    while (fgets(line, sizeof(line), f)) {
+        resultdb_rec_t r;
+        if (resultdb__parse(line, &r) != 0) continue;
+        if (n == cap) {
+            cap = cap ? 2 * cap : 64;
+            resultdb_rec_t *grown = (resultdb_rec_t *)realloc(*recs, (size_t)cap * sizeof(r));
+            if (!grown) {
+                free(*recs);
+                *recs = NULL;
+                fclose(f);
+                return -1;
+            }
+            *recs = grown;
+        }
+        (*recs)[n++] = r;
+    }
+    fclose(f);
+    return n;
+}
+
+static int resultdb__same_key(const resultdb_rec_t *a, const resultdb_rec_t *b) {
+    return strcmp(a->host, b->host) == 0 && strcmp(a->variant, b->variant) == 0 &&
+           strcmp(a->params, b->params) == 0;
+}
+
+int resultdb_compare(const resultdb_rec_t *recs, int n, const char *host,
+                     const char *baseline, double threshold, FILE *f) {
+    int regressions = 0, keys = 0;
+    fprintf(f, "%-18s %-14s %10s %-14s %10s %8s  %-22s %s\n", "variant", "baseline", "median s",
+            "current", "median s", "change", "verdict", "params");
+    for (int i = 0; i < n; ++i) {
+        const resultdb_rec_t *cur = &recs[i];
+        if (strcmp(cur->host, host) != 0) continue;
+        // Only the latest result of each key is current.
+        int newer = 0;
+        for (int j = i + 1; j < n && !newer; ++j) newer = resultdb__same_key(&recs[j], cur);
+        if (newer) continue;
+        ++keys;
+        const resultdb_rec_t *base = NULL;
+        for (int j = i - 1; j >= 0 && !base; --j) {
+            const resultdb_rec_t *r = &recs[j];
+            if (!resultdb__same_key(r, cur)) continue;
+            if (baseline ? strncmp(r->rev, baseline, strlen(baseline)) == 0
+                         : strcmp(r->rev, cur->rev) != 0)
+                base = r;
+        }
+        if (!base) {
+            fprintf(f, "%-18s %-14s %10s %-14s %10.6f %8s  %-22s %s\n", cur->variant, "-", "-",
+                    cur->rev, cur->median, "-", "no baseline", cur->params);
+            continue;
+        }
+        double change = cur->median / base->median - 1.0;
+        const char *verdict = "ok";
+        if (change > threshold) {
+            if (cur->ci_lo > base->ci_hi) {
+                verdict = "REGRESSION";
+                ++regressions;
+            } else {
+                verdict = "slower, within noise";
+            }
+        } else if (change < -threshold) {
+            verdict = cur->ci_hi < base->ci_lo ? "improved" : "faster, within noise";
+        }
+        fprintf(f, "%-18s %-14s %10.6f %-14s %10.6f %+7.1f%%  %-22s %s\n", cur->variant,
+                base->rev, base->median, cur->rev, cur->median, 100.0 * change, verdict,
+                cur->params);
+    }
+    if (keys == 0) {
+        fprintf(f, "No results for this host\n");
+        return -1;
+    }
+    fprintf(f, "Regressions: %d beyond %.1f%% (intervals disjoint)\n", regressions,
+            100.0 * threshold);
+    return regressions;
+}
+
+#endif // RESULTDB_IMPLEMENTATION
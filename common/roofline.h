@@ -0,0 +1,427 @@
+// roofline.h - machine roofs and roofline placement of kernel runs
+// ------------------------------------------------------------
+// Single-header library in the style of stb_image: include it
+// anywhere for the declarations, and in exactly one C or C++ file
+//
+//     #define ROOFLINE_IMPLEMENTATION
+//     #include "roofline.h"
+//
+// to compile the implementation (after topology.h; C files need
+// _GNU_SOURCE for pthread barriers).
+//
+// roof_measure() measures the roofs of this host on 'threads' threads:
+//
+//   - peak FLOP/s (double and float) with a register-only loop of 12
+//     independent multiply-add chains on the widest vectors the
+//     translation unit is compiled for;
+//   - bandwidth of L1, L2, L3 and DRAM with the STREAM triad
+//     a[i] = b[i] + s * c[i] on working sets of half of each cache (per
+//     thread for L1 / L2, shared for L3) and of twice L3 (at least
+//     256 MiB, at most 1 GiB) for DRAM, counting 24 bytes per element
+//     as STREAM does.
+//
+// The roofs are appended to a text file ($ROOFLINE or
+// results/roofline.txt), one line per measurement:
+//
+//     host <TAB> threads <TAB> gflops_f64 gflops_f32 <TAB> GB/s L1 L2 L3 DRAM <TAB> set bytes
+//
+// with 'host' the CPU model and cache sizes as in tunedb.h plus the
+// vector width the peak was measured with, so later runs only load
+// them; the last matching line wins.
+//
+// A kernel run is a roof_point_t: flops, modelled bytes and measured
+// seconds. The bytes are counted at one level: ROOF_L1 for the loads
+// and stores the kernel issues (the cache-aware roofline, where one
+// intensity is compared against every roof), or a slower level for
+// traffic that must come from there (e.g. compulsory DRAM traffic).
+// roof_report() prints the arithmetic intensity, the attainable
+// performance min(peak, bandwidth x intensity) at that level, whether
+// that is the memory or the compute roof, the headroom (attainable /
+// achieved), and the slowest level whose roof still covers the achieved
+// rate, i.e. where the data could be streaming from.
+// roof_write_csv() writes the roofs and the points as CSV for plotting.
+
+#ifndef ROOFLINE_H
+#define ROOFLINE_H
+
+#include <stdio.h>
+
+#include "topology.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum { ROOF_L1, ROOF_L2, ROOF_L3, ROOF_DRAM, ROOF_LEVELS };
+
+typedef struct {
+    char host[256];
+    int threads;
+    double gflops_f64, gflops_f32;   // peak, all threads
+    double bw[ROOF_LEVELS];          // GB/s, all threads
+    double set_bytes[ROOF_LEVELS];   // working set of each bandwidth test
+} roof_machine_t;
+
+typedef struct {
+    const char *name;
+    double flops;
+    double bytes;      // modelled traffic at 'level'
+    double seconds;
+    int level;         // level 'bytes' are counted at, ROOF_L1 .. ROOF_DRAM
+    int f32;           // 1 = compare with the float peak
+} roof_point_t;
+
+const char *roof_level_name(int level);
+
+// Path of the roof file: $ROOFLINE, or "results/roofline.txt".
+const char *roof_default_path(void);
+
+void roof_measure(roof_machine_t *m, const topo_t *t, int threads);
+
+// Load the roofs last measured on this host with the same thread count.
+// Returns 0 on success, -1 if there are none.
+int roof_load(roof_machine_t *m, const topo_t *t, int threads, const char *path);
+int roof_save(const roof_machine_t *m, const char *path);   // appends
+
+// Roofs loaded from 'path' if possible, else measured (and saved).
+void roof_get(roof_machine_t *m, const topo_t *t, int threads, const char *path, int remeasure);
+
+// Smallest level whose capacity holds 'bytes' (where a working set of
+// that size streams from).
+int roof_level_for(const topo_t *t, double bytes);
+
+double roof_attainable(const roof_machine_t *m, double intensity, int level, int f32);
+
+void roof_print_machine(const roof_machine_t *m, FILE *f);
+void roof_report(const roof_machine_t *m, const roof_point_t *p, int n, FILE *f);
+
+// Slowest level whose roof at the point's intensity covers its achieved
+// rate (ROOF_L1 if none does).
+int roof_served_by(const roof_machine_t *m, const roof_point_t *p);
+
+// "roof,<threads>,<level>,<GB/s>,<peak GFLOP/s f64>,<f32>" lines, then
+// "point,<threads>,<name>,<level>,<flop/byte>,<GFLOP/s>,<attainable>,<served by>"
+// lines; several machines (thread counts) can go to the same file.
+void roof_write_csv(const roof_machine_t *m, const roof_point_t *p, int n, FILE *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ROOFLINE_H
+
+#if defined(ROOFLINE_IMPLEMENTATION) && !defined(ROOFLINE_IMPLEMENTED)
+#define ROOFLINE_IMPLEMENTED
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char *roof__names[ROOF_LEVELS] = {"L1", "L2", "L3", "DRAM"};
+
+const char *roof_level_name(int level) {
+    return level >= 0 && level < ROOF_LEVELS ? roof__names[level] : "?";
+}
+
+const char *roof_default_path(void) {
+    const char *env = getenv("ROOFLINE");
+    return (env && *env) ? env : "results/roofline.txt";
+}
+
+static double roof__now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Widest vectors this translation unit is compiled for; the peak
+// depends on it, so it is part of the host key.
+#if defined(__AVX512F__)
+#define ROOF__VBYTES 64
+#elif defined(__AVX__)
+#define ROOF__VBYTES 32
+#else
+#define ROOF__VBYTES 16
+#endif
+
+static void roof__host(const topo_t *t, char *buf, size_t size) {
+    snprintf(buf, size, "%s|L1d=%ldK|L2=%ldK|L3=%ldK|simd=%d", t->model, t->l1d >> 10,
+             t->l2 >> 10, t->l3 >> 10, ROOF__VBYTES * 8);
+}
+
+// Register-only multiply-add chains. V is the widest vector type the
+// translation unit targets; 12 chains cover the FMA latency x ports.
+typedef double roof__vd __attribute__((vector_size(ROOF__VBYTES)));
+typedef float roof__vf __attribute__((vector_size(ROOF__VBYTES)));
+
+#define ROOF__CHAINS 12
+#define ROOF__FMA_BODY(V, T)                                               \
+    V x[ROOF__CHAINS], m, a;                                               \
+    volatile T mv = (T)0.999999, av = (T)1e-7;                             \
+    for (int l = 0; l < (int)(sizeof(V) / sizeof(T)); ++l) {               \
+        m[l] = mv;                                                         \
+        a[l] = av;                                                         \
+    }                                                                      \
+    for (int c = 0; c < ROOF__CHAINS; ++c) x[c] = a * (T)(c + 1);          \
+    for (long it = 0; it < iters; ++it) {                                  \
+        _Pragma("GCC unroll 12")                                           \
+        for (int c = 0; c < ROOF__CHAINS; ++c) x[c] = x[c] * m + a;        \
+    }                                                                      \
+    T s = 0;                                                               \
+    for (int c = 0; c < ROOF__CHAINS; ++c)                                 \
+        for (int l = 0; l < (int)(sizeof(V) / sizeof(T)); ++l) s += x[c][l]; \
+    return (double)s;
+
+static double roof__fma_f64(long iters) { ROOF__FMA_BODY(roof__vd, double) }
+static double roof__fma_f32(long iters) { ROOF__FMA_BODY(roof__vf, float) }
+
+typedef struct {
+    int kind;            // 0 = f64 FMA, 1 = f32 FMA, 2 = triad
+    long iters;          // FMA iterations or triad passes
+    size_t elems;        // triad vectors per array
+    roof__vd *shared;    // 3 * elems vectors shared by all threads, or NULL
+    int tid, threads;
+    pthread_barrier_t *barrier;
+    double start, end;
+    double sink;
+} roof__job;
+
+// Three arrays of n vectors, aligned for them.
+static roof__vd *roof__alloc(size_t n) {
+    return (roof__vd *)aligned_alloc(ROOF__VBYTES, 3 * n * ROOF__VBYTES);
+}
+
+static void *roof__worker(void *arg) {
+    roof__job *j = (roof__job *)arg;
+    roof__vd *buf = j->shared;
+    size_t n = j->elems, lo = 0, hi = n;
+    if (j->kind == 2) {
+        if (buf) {
+            lo = n * j->tid / j->threads;
+            hi = n * (j->tid + 1) / j->threads;
+        } else {
+            buf = roof__alloc(n);
+            if (!buf) return NULL;
+        }
+        // First touch (and warm-up) by the thread that streams it.
+        roof__vd zero = {0}, one = zero + 1.0, two = zero + 2.0;
+        for (size_t i = lo; i < hi; ++i) buf[i] = zero, buf[n + i] = one, buf[2 * n + i] = two;
+    }
+    pthread_barrier_wait(j->barrier);
+    j->start = roof__now();
+    if (j->kind == 0) {
+        j->sink = roof__fma_f64(j->iters);
+    } else if (j->kind == 1) {
+        j->sink = roof__fma_f32(j->iters);
+    } else {
+        roof__vd *a = buf, *b = buf + n, *c = buf + 2 * n;
+        for (long r = 0; r < j->iters; ++r) {
+            double s = 1.0 + r * 1e-9;
+            for (size_t i = lo; i < hi; ++i) a[i] = b[i] + s * c[i];
+        }
+        j->sink = a[lo][0];
+    }
+    j->end = roof__now();
+    if (!j->shared) free(buf);
+    return NULL;
+}
+
+// Run one job kind on all threads; returns the time from the first
+// thread starting to the last one finishing (right even when threads
+// share a core and run one after the other).
+static double roof__run(int kind, long iters, size_t elems, int shared, int threads) {
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, (unsigned)threads);
+    roof__job *jobs = (roof__job *)calloc((size_t)threads, sizeof(roof__job));
+    pthread_t *tids = (pthread_t *)calloc((size_t)threads, sizeof(pthread_t));
+    roof__vd *buf = shared ? roof__alloc(elems) : NULL;
+    for (int t = 0; t < threads; ++t) {
+        jobs[t].kind = kind;
+        jobs[t].iters = iters;
+        jobs[t].elems = elems;
+        jobs[t].shared = buf;
+        jobs[t].tid = t;
+        jobs[t].threads = threads;
+        jobs[t].barrier = &barrier;
+        pthread_create(&tids[t], NULL, roof__worker, &jobs[t]);
+    }
+    double first = 0.0, last = 0.0, sink = 0.0;
+    for (int t = 0; t < threads; ++t) {
+        pthread_join(tids[t], NULL);
+        if (t == 0 || jobs[t].start < first) first = jobs[t].start;
+        if (jobs[t].end > last) last = jobs[t].end;
+        sink += jobs[t].sink;
+    }
+    pthread_barrier_destroy(&barrier);
+    free(buf);
+    free(tids);
+    free(jobs);
+    volatile double keep = sink;
+    (void)keep;
+    return last - first;
+}
+
+// Best GFLOP/s of 3 runs of about 0.1 s per thread each.
+static double roof__peak(int kind, int threads) {
+    double lanes = ROOF__VBYTES / (kind == 0 ? 8.0 : 4.0);
+    long iters = 1 << 16;
+    while (roof__run(kind, iters, 0, 0, 1) < 0.02) iters *= 2;
+    iters *= 5;
+    double best = 0.0;
+    for (int r = 0; r < 3; ++r) {
+        double s = roof__run(kind, iters, 0, 0, threads);
+        double g = threads * (double)iters * ROOF__CHAINS * lanes * 2.0 / s * 1e-9;
+        if (g > best) best = g;
+    }
+    return best;
+}
+
+// Triad over 'bytes' of working set (3 arrays); best GB/s of 3 runs
+// of about 0.1 s per thread each.
+static double roof__bandwidth(double bytes, int shared, int threads) {
+    size_t elems = (size_t)(bytes / (3.0 * ROOF__VBYTES));
+    if (elems < 32) elems = 32;
+    size_t per = shared ? elems / threads : elems;
+    long passes = 1;
+    while (roof__run(2, passes, per, 0, 1) < 0.02) passes *= 2;
+    passes *= 5;
+    double best = 0.0;
+    for (int r = 0; r < 3; ++r) {
+        double s = roof__run(2, passes, elems, shared, threads);
+        double total = 3.0 * ROOF__VBYTES * (double)elems * passes * (shared ? 1 : threads);
+        double g = total / s * 1e-9;
+        if (g > best) best = g;
+    }
+    return best;
+}
+
+void roof_measure(roof_machine_t *m, const topo_t *t, int threads) {
+    memset(m, 0, sizeof(*m));
+    if (threads < 1) threads = 1;
+    roof__host(t, m->host, sizeof(m->host));
+    m->threads = threads;
+    m->gflops_f64 = roof__peak(0, threads);
+    m->gflops_f32 = roof__peak(1, threads);
+    double l3 = t->l3 > 0 ? (double)t->l3 : 8.0 * t->l2;
+    double dram = 2.0 * l3;
+    if (dram < 256.0 * (1 << 20)) dram = 256.0 * (1 << 20);
+    if (dram > 1024.0 * (1 << 20)) dram = 1024.0 * (1 << 20);
+    m->set_bytes[ROOF_L1] = t->l1d / 2.0;
+    m->set_bytes[ROOF_L2] = t->l2 / 2.0;
+    m->set_bytes[ROOF_L3] = l3 / 2.0;
+    m->set_bytes[ROOF_DRAM] = dram;
+    for (int l = 0; l < ROOF_LEVELS; ++l) {
+        int shared = l >= ROOF_L3;
+        m->bw[l] = roof__bandwidth(m->set_bytes[l], shared, threads);
+    }
+}
+
+int roof_save(const roof_machine_t *m, const char *path) {
+    FILE *f = fopen(path, "a");
+    if (!f) {
+        fprintf(stderr, "Warning: could not append to roof file '%s'\n", path);
+        return -1;
+    }
+    fprintf(f, "%s\t%d\t%.6g %.6g\t", m->host, m->threads, m->gflops_f64, m->gflops_f32);
+    for (int l = 0; l < ROOF_LEVELS; ++l)
+        fprintf(f, "%.6g%c", m->bw[l], l + 1 < ROOF_LEVELS ? ' ' : '\t');
+    for (int l = 0; l < ROOF_LEVELS; ++l)
+        fprintf(f, "%.0f%c", m->set_bytes[l], l + 1 < ROOF_LEVELS ? ' ' : '\n');
+    fclose(f);
+    return 0;
+}
+
+int roof_load(roof_machine_t *m, const topo_t *t, int threads, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    char host[256], line[1024];
+    roof__host(t, host, sizeof(host));
+    size_t hl = strlen(host);
+    int found = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, host, hl) != 0 || line[hl] != '\t') continue;
+        roof_machine_t r;
+        memset(&r, 0, sizeof(r));
+        int got = sscanf(line + hl + 1, "%d %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf", &r.threads,
+                         &r.gflops_f64, &r.gflops_f32, &r.bw[0], &r.bw[1], &r.bw[2], &r.bw[3],
+                         &r.set_bytes[0], &r.set_bytes[1], &r.set_bytes[2], &r.set_bytes[3]);
+        if (got != 11 || r.threads != threads) continue;
+        snprintf(r.host, sizeof(r.host), "%s", host);
+        *m = r;   // last match wins, like the tuning database
+        found = 0;
+    }
+    fclose(f);
+    return found;
+}
+
+void roof_get(roof_machine_t *m, const topo_t *t, int threads, const char *path, int remeasure) {
+    if (!remeasure && roof_load(m, t, threads, path) == 0) {
+        printf("Roofs loaded from %s\n", path);
+        return;
+    }
+    printf("Measuring roofs on %d thread(s)...\n", threads);
+    roof_measure(m, t, threads);
+    if (roof_save(m, path) == 0) printf("Saved roofs to %s\n", path);
+}
+
+int roof_level_for(const topo_t *t, double bytes) {
+    if (bytes <= t->l1d) return ROOF_L1;
+    if (bytes <= t->l2) return ROOF_L2;
+    if (t->l3 > 0 && bytes <= t->l3) return ROOF_L3;
+    return ROOF_DRAM;
+}
+
+double roof_attainable(const roof_machine_t *m, double intensity, int level, int f32) {
+    double peak = f32 ? m->gflops_f32 : m->gflops_f64;
+    double mem = m->bw[level] * intensity;
+    return mem < peak ? mem : peak;
+}
+
+void roof_print_machine(const roof_machine_t *m, FILE *f) {
+    fprintf(f, "Roofs (%d thread(s)): peak %.1f GFLOP/s double, %.1f float; bandwidth", m->threads,
+            m->gflops_f64, m->gflops_f32);
+    for (int l = 0; l < ROOF_LEVELS; ++l)
+        fprintf(f, " %s %.1f", roof__names[l], m->bw[l]);
+    fprintf(f, " GB/s\n");
+    fprintf(f, "Ridge points (flop/byte, double):");
+    for (int l = 0; l < ROOF_LEVELS; ++l)
+        fprintf(f, " %s %.2f", roof__names[l], m->gflops_f64 / m->bw[l]);
+    fprintf(f, "\n");
+}
+
+int roof_served_by(const roof_machine_t *m, const roof_point_t *p) {
+    double ai = p->flops / p->bytes, got = p->flops / p->seconds * 1e-9;
+    for (int l = ROOF_DRAM; l > ROOF_L1; --l)
+        if (m->bw[l] * ai >= got) return l;
+    return ROOF_L1;
+}
+
+void roof_report(const roof_machine_t *m, const roof_point_t *p, int n, FILE *f) {
+    fprintf(f, "%-18s %6s %10s %10s %9s %10s %8s %9s %7s\n", "kernel", "level", "flop/byte",
+            "GFLOP/s", "bound", "roof", "% roof", "headroom", "served");
+    for (int i = 0; i < n; ++i) {
+        double ai = p[i].flops / p[i].bytes;
+        double got = p[i].flops / p[i].seconds * 1e-9;
+        double peak = p[i].f32 ? m->gflops_f32 : m->gflops_f64;
+        double roof = roof_attainable(m, ai, p[i].level, p[i].f32);
+        fprintf(f, "%-18s %6s %10.3f %10.2f %9s %10.2f %7.1f%% %8.1fx %7s\n", p[i].name,
+                roof__names[p[i].level], ai, got, roof < peak ? "memory" : "compute", roof,
+                100.0 * got / roof, roof / got, roof__names[roof_served_by(m, &p[i])]);
+    }
+}
+
+void roof_write_csv(const roof_machine_t *m, const roof_point_t *p, int n, FILE *f) {
+    for (int l = 0; l < ROOF_LEVELS; ++l)
+        fprintf(f, "roof,%d,%s,%.6g,%.6g,%.6g\n", m->threads, roof__names[l], m->bw[l],
+                m->gflops_f64, m->gflops_f32);
+    for (int i = 0; i < n; ++i) {
+        double ai = p[i].flops / p[i].bytes;
+        fprintf(f, "point,%d,%s,%s,%.6g,%.6g,%.6g,%s\n", m->threads, p[i].name,
+                roof__names[p[i].level], ai, p[i].flops / p[i].seconds * 1e-9,
+                roof_attainable(m, ai, p[i].level, p[i].f32),
+                roof__names[roof_served_by(m, &p[i])]);
+    }
+}
+
+#endif // ROOFLINE_IMPLEMENTATION
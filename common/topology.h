@@ -0,0 +1,458 @@
+// topology.h - cache hierarchy and CPU topology discovery
+// ------------------------------------------------------------
+// Single-header library in the style of stb_image: include it
+// anywhere for the declarations, and in exactly one C or C++ file
+//
+//     #define TOPOLOGY_IMPLEMENTATION
+//     #include "topology.h"
+//
+// to compile the implementation.
+//
+// Reads L1d/L2/L3 sizes, the cache line size, the core / SMT layout
+// and the NUMA nodes from Linux sysfs (falling back to cpuid for the
+// caches on x86), and derives default blocking parameters for the
+// matmul and convolution engines from them, so a new machine gets
+// sensible tile / panel / band sizes without a tuning sweep.
+//
+// It also places threads and pages: affinity policies (compact,
+// scatter, explicit CPU list), pinning of the calling thread and a
+// report of the NUMA node each page of a buffer landed on. Pinning and
+// the page report need _GNU_SOURCE in the implementation file (g++
+// defines it; C files define it before their first #include).
+
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    char model[128];
+    long l1d, l2, l3;        // bytes (0 if unknown)
+    int line_size;           // bytes
+    int logical_cpus;        // online CPUs
+    int physical_cores;      // distinct (package, core) pairs
+    int smt;                 // hardware threads per core
+    int packages;
+    int numa_nodes;
+    int *cpu_core;           // [logical_cpus] core index (0 .. physical_cores-1)
+    int *cpu_package;        // [logical_cpus] package id
+    int *cpu_node;           // [logical_cpus] NUMA node
+} topo_t;
+
+// Fill 't' for the current machine. Never fails: unknown values get
+// conservative defaults (32 KiB L1d, 1 MiB L2, 64-byte lines, ...).
+void topo_discover(topo_t *t);
+void topo_free(topo_t *t);
+void topo_print(const topo_t *t, FILE *f);
+
+// Square tile for the ii-kk-jj / ikj tiled matmul: the T x T tile of B
+// is reused across a block of rows, so it should use about half of L1d.
+int topo_matmul_tile(const topo_t *t, int elem_size);
+
+// BLIS-style GEMM blocking for an mr x nr micro-kernel:
+//   kc: an mr x kc panel of A plus a kc x nr panel of B fill ~half L1d,
+//   mc: the mc x kc block of A fills ~half L2,
+//   nc: the kc x nc panel of B fills ~half of this core's L3 share
+//       (at most 4096 columns).
+void topo_gemm_blocking(const topo_t *t, int elem_size, int mr, int nr,
+                        int *mc, int *kc, int *nc);
+
+// Square output tile for the tiled convolution: the input footprint
+// (tile + kh - 1) x (tile + kw - 1) x ch bytes fits in ~half L1d.
+int topo_conv_tile(const topo_t *t, int ch, int kh, int kw);
+
+// Output rows per band so the band's input rows fit in ~half L2.
+int topo_conv_band_rows(const topo_t *t, int w, int ch, int kh);
+
+// One compute thread per physical core.
+int topo_default_threads(const topo_t *t);
+
+// Default placement for n threads: one thread per physical core,
+// alternating NUMA nodes, before SMT siblings are used. Writes n
+// logical CPU ids to cpus.
+void topo_default_placement(const topo_t *t, int n, int *cpus);
+
+// CPUs for n threads under an affinity spec:
+//   "compact"   fill all hardware threads of a core, then the next core,
+//               one NUMA node at a time,
+//   "scatter"   topo_default_placement,
+//   "0,2,4-7"   explicit CPU list (reused round-robin if shorter than n),
+//   "none"      no pinning.
+// Returns 0 with cpus[0..n) filled, 1 for "none", -1 for a bad spec.
+int topo_affinity_cpus(const topo_t *t, const char *spec, int n, int *cpus);
+
+// Pin the calling thread to one logical CPU. Returns 0 on success.
+int topo_pin_thread(int cpu);
+
+// NUMA node of the page holding 'addr' (must already be touched), or
+// -1 if unknown.
+int topo_page_node(const void *addr);
+
+// Print which NUMA nodes the pages of a buffer landed on, e.g.
+// "Buffer C: node0 50.0% node1 50.0%".
+void topo_print_buffer_nodes(const topo_t *t, const char *name,
+                             const void *buf, size_t bytes, FILE *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TOPOLOGY_H
+
+#if defined(TOPOLOGY_IMPLEMENTATION) && !defined(TOPOLOGY_IMPLEMENTED)
+#define TOPOLOGY_IMPLEMENTED
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if defined(__linux__) && defined(_GNU_SOURCE)
+#include <sched.h>
+#include <sys/syscall.h>
+#define TOPO__LINUX_AFFINITY 1
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+static long topo__read_long(const char *path, long fallback) {
+    FILE *f = fopen(path, "r");
+    if (!f) return fallback;
+    long v = 0;
+    char unit = 0;
+    int n = fscanf(f, "%ld%c", &v, &unit);
+    fclose(f);
+    if (n < 1) return fallback;
+    if (unit == 'K') v *= 1024;
+    if (unit == 'M') v *= 1024 * 1024;
+    return v;
+}
+
+// Parse a sysfs cpulist such as "0-3,8-11" and set map[cpu] = value for
+// each listed cpu below ncpu.
+static void topo__parse_cpulist(const char *s, int *map, int ncpu, int value) {
+    while (*s) {
+        char *end;
+        long a = strtol(s, &end, 10);
+        if (end == s) break;
+        long b = a;
+        s = end;
+        if (*s == '-') {
+            b = strtol(s + 1, &end, 10);
+            s = end;
+        }
+        for (long c = a; c <= b; ++c)
+            if (c >= 0 && c < ncpu) map[c] = value;
+        if (*s == ',') ++s;
+        else break;
+    }
+}
+
+static void topo__caches_sysfs(topo_t *t) {
+    for (int i = 0; i < 16; ++i) {
+        char path[128], type[32] = "";
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", i);
+        FILE *f = fopen(path, "r");
+        if (!f) break;
+        if (fscanf(f, "%31s", type) != 1) type[0] = '\0';
+        fclose(f);
+        if (strcmp(type, "Instruction") == 0) continue;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", i);
+        long level = topo__read_long(path, 0);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", i);
+        long size = topo__read_long(path, 0);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/coherency_line_size", i);
+        long line = topo__read_long(path, 0);
+        if (level == 1) t->l1d = size;
+        if (level == 2) t->l2 = size;
+        if (level == 3) t->l3 = size;
+        if (line > 0) t->line_size = (int)line;
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Deterministic cache parameters: leaf 4 (Intel) / 0x8000001D (AMD).
+static void topo__caches_cpuid(topo_t *t) {
+    unsigned int a, b, c, d;
+    if (!__get_cpuid(0, &a, &b, &c, &d)) return;
+    unsigned int leaf = (b == 0x68747541u) ? 0x8000001Du : 4u;  // "Auth"enticAMD
+    for (unsigned int i = 0; i < 16; ++i) {
+        __cpuid_count(leaf, i, a, b, c, d);
+        unsigned int type = a & 0x1f;
+        if (type == 0) break;
+        if (type == 2) continue;  // instruction cache
+        unsigned int level = (a >> 5) & 0x7;
+        long line = (b & 0xfff) + 1;
+        long parts = ((b >> 12) & 0x3ff) + 1;
+        long ways = ((b >> 22) & 0x3ff) + 1;
+        long sets = (long)c + 1;
+        long size = ways * parts * line * sets;
+        if (level == 1 && !t->l1d) t->l1d = size;
+        if (level == 2 && !t->l2) t->l2 = size;
+        if (level == 3 && !t->l3) t->l3 = size;
+        if (!t->line_size) t->line_size = (int)line;
+    }
+}
+#endif
+
+static void topo__model(topo_t *t) {
+    snprintf(t->model, sizeof(t->model), "unknown");
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    if (!f) return;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "model name", 10) == 0) {
+            char *p = strchr(line, ':');
+            if (p) {
+                p += 1 + strspn(p + 1, " \t");
+                p[strcspn(p, "\n")] = '\0';
+                snprintf(t->model, sizeof(t->model), "%s", p);
+            }
+            break;
+        }
+    }
+    fclose(f);
+}
+
+void topo_discover(topo_t *t) {
+    memset(t, 0, sizeof(*t));
+    topo__model(t);
+    topo__caches_sysfs(t);
+#if defined(__x86_64__) || defined(__i386__)
+    if (!t->l1d || !t->l2 || !t->line_size) topo__caches_cpuid(t);
+#endif
+    if (!t->l1d) t->l1d = 32 * 1024;
+    if (!t->l2) t->l2 = 1024 * 1024;
+    if (!t->line_size) t->line_size = 64;
+
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    t->logical_cpus = n > 0 ? (int)n : 1;
+    int ncpu = t->logical_cpus;
+    t->cpu_core = (int *)calloc((size_t)ncpu, sizeof(int));
+    t->cpu_package = (int *)calloc((size_t)ncpu, sizeof(int));
+    t->cpu_node = (int *)calloc((size_t)ncpu, sizeof(int));
+    int *core_id = (int *)calloc((size_t)ncpu, sizeof(int));
+
+    // Physical cores are distinct (package, core_id) pairs.
+    int max_pkg = 0;
+    for (int c = 0; c < ncpu; ++c) {
+        char path[128];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", c);
+        t->cpu_package[c] = (int)topo__read_long(path, 0);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", c);
+        core_id[c] = (int)topo__read_long(path, c);
+        if (t->cpu_package[c] > max_pkg) max_pkg = t->cpu_package[c];
+        t->cpu_core[c] = -1;
+        for (int p = 0; p < c; ++p) {
+            if (t->cpu_package[p] == t->cpu_package[c] && core_id[p] == core_id[c]) {
+                t->cpu_core[c] = t->cpu_core[p];
+                break;
+            }
+        }
+        if (t->cpu_core[c] < 0) t->cpu_core[c] = t->physical_cores++;
+    }
+    free(core_id);
+    t->packages = max_pkg + 1;
+    if (t->physical_cores < 1) t->physical_cores = 1;
+    t->smt = (ncpu + t->physical_cores - 1) / t->physical_cores;
+
+    t->numa_nodes = 0;
+    for (int node = 0; node < 256; ++node) {
+        char path[128], list[1024];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE *f = fopen(path, "r");
+        if (!f) continue;
+        if (fgets(list, sizeof(list), f)) topo__parse_cpulist(list, t->cpu_node, ncpu, node);
+        fclose(f);
+        t->numa_nodes = node + 1;
+    }
+    if (t->numa_nodes < 1) t->numa_nodes = 1;
+}
+
+void topo_free(topo_t *t) {
+    free(t->cpu_core);
+    free(t->cpu_package);
+    free(t->cpu_node);
+    t->cpu_core = t->cpu_package = t->cpu_node = NULL;
+}
+
+void topo_print(const topo_t *t, FILE *f) {
+    fprintf(f, "CPU: %s\n", t->model);
+    fprintf(f, "Caches: L1d %ld KiB, L2 %ld KiB, L3 %ld KiB, line %d B\n",
+            t->l1d / 1024, t->l2 / 1024, t->l3 / 1024, t->line_size);
+    fprintf(f, "Cores: %d logical, %d physical (SMT %d), %d package(s), %d NUMA node(s)\n",
+            t->logical_cpus, t->physical_cores, t->smt, t->packages, t->numa_nodes);
+}
+
+// Largest multiple of 'step' not above v, but at least 'step'.
+static int topo__round_down(double v, int step) {
+    int r = ((int)v / step) * step;
+    return r < step ? step : r;
+}
+
+int topo_matmul_tile(const topo_t *t, int elem_size) {
+    double tile = sqrt(t->l1d / 2.0 / elem_size);
+    int step = t->line_size / elem_size;
+    if (step < 1) step = 1;
+    return topo__round_down(tile, step);
+}
+
+void topo_gemm_blocking(const topo_t *t, int elem_size, int mr, int nr,
+                        int *mc, int *kc, int *nc) {
+    int k = topo__round_down(t->l1d / 2.0 / ((double)(mr + nr) * elem_size), 8);
+    long l3_share = t->l3 ? t->l3 / t->physical_cores : 4 * t->l2;
+    *kc = k;
+    *mc = topo__round_down(t->l2 / 2.0 / ((double)k * elem_size), mr);
+    *nc = topo__round_down(l3_share / 2.0 / ((double)k * elem_size), nr);
+    // Huge (or virtualised) L3 sizes would give panels wider than any
+    // matrix; beyond a few thousand columns there is nothing to gain.
+    if (*nc > 4096) *nc = topo__round_down(4096, nr);
+}
+
+int topo_conv_tile(const topo_t *t, int ch, int kh, int kw) {
+    // (tile + kh - 1)(tile + kw - 1) ch <= l1d / 2, solved for tile.
+    double budget = t->l1d / 2.0 / (ch > 0 ? ch : 1);
+    double halo = (kh + kw - 2) / 2.0;
+    double tile = sqrt(budget) - halo;
+    return topo__round_down(tile, 8);
+}
+
+int topo_conv_band_rows(const topo_t *t, int w, int ch, int kh) {
+    double row_bytes = (double)w * (ch > 0 ? ch : 1);
+    double rows = t->l2 / 2.0 / row_bytes - (kh - 1);
+    return rows < 1.0 ? 1 : (int)rows;
+}
+
+int topo_default_threads(const topo_t *t) {
+    return t->physical_cores;
+}
+
+void topo_default_placement(const topo_t *t, int n, int *cpus) {
+    int ncpu = t->logical_cpus;
+    char *used = (char *)calloc((size_t)ncpu, 1);
+    int *core_taken = (int *)calloc((size_t)t->physical_cores, sizeof(int));
+    int placed = 0;
+    // Pass s takes the s-th hardware thread of each core; within a pass
+    // the nodes are visited round-robin so both sockets fill evenly.
+    for (int pass = 0; pass < t->smt && placed < n; ++pass) {
+        int progress = 1;
+        while (placed < n && progress) {
+            progress = 0;
+            for (int node = 0; node < t->numa_nodes && placed < n; ++node) {
+                for (int c = 0; c < ncpu; ++c) {
+                    if (used[c] || t->cpu_node[c] != node) continue;
+                    if (core_taken[t->cpu_core[c]] > pass) continue;
+                    used[c] = 1;
+                    core_taken[t->cpu_core[c]]++;
+                    cpus[placed++] = c;
+                    progress = 1;
+                    break;
+                }
+            }
+        }
+    }
+    // More threads than CPUs: wrap around.
+    for (int i = placed; i < n; ++i) cpus[i] = cpus[i % (placed ? placed : 1)];
+    if (placed == 0)
+        for (int i = 0; i < n; ++i) cpus[i] = i % ncpu;
+    free(used);
+    free(core_taken);
+}
+
+int topo_affinity_cpus(const topo_t *t, const char *spec, int n, int *cpus) {
+    int ncpu = t->logical_cpus;
+    if (!spec || !*spec || strcmp(spec, "none") == 0) return 1;
+    if (strcmp(spec, "scatter") == 0) {
+        topo_default_placement(t, n, cpus);
+        return 0;
+    }
+    if (strcmp(spec, "compact") == 0) {
+        // Order CPUs by (node, core, cpu): siblings of a core are adjacent.
+        int placed = 0;
+        for (int node = 0; node < t->numa_nodes && placed < n; ++node)
+            for (int core = 0; core < t->physical_cores && placed < n; ++core)
+                for (int c = 0; c < ncpu && placed < n; ++c)
+                    if (t->cpu_node[c] == node && t->cpu_core[c] == core) cpus[placed++] = c;
+        for (int i = placed; i < n; ++i) cpus[i] = placed ? cpus[i % placed] : i % ncpu;
+        return 0;
+    }
+
+    // Explicit list: mark the listed CPUs, then hand them out in order.
+    int *listed = (int *)calloc((size_t)ncpu, sizeof(int));
+    if (!listed) return -1;
+    for (const char *p = spec; *p; ++p) {
+        if (!strchr("0123456789,-", *p)) {
+            free(listed);
+            return -1;
+        }
+    }
+    topo__parse_cpulist(spec, listed, ncpu, 1);
+    int count = 0;
+    for (int c = 0; c < ncpu && count < n; ++c)
+        if (listed[c]) cpus[count++] = c;
+    free(listed);
+    if (count == 0) return -1;
+    for (int i = count; i < n; ++i) cpus[i] = cpus[i % count];
+    return 0;
+}
+
+int topo_pin_thread(int cpu) {
+#ifdef TOPO__LINUX_AFFINITY
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return -1;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0 ? 0 : -1;
+#else
+    (void)cpu;
+    return -1;
+#endif
+}
+
+int topo_page_node(const void *addr) {
+#if defined(TOPO__LINUX_AFFINITY) && defined(SYS_move_pages)
+    // move_pages without target nodes only reports the current node.
+    void *page = (void *)addr;
+    int status = -1;
+    if (syscall(SYS_move_pages, 0, 1UL, &page, NULL, &status, 0) != 0) return -1;
+    return status >= 0 ? status : -1;
+#else
+    (void)addr;
+    return -1;
+#endif
+}
+
+void topo_print_buffer_nodes(const topo_t *t, const char *name,
+                             const void *buf, size_t bytes, FILE *f) {
+    long page = sysconf(_SC_PAGESIZE);
+    if (page <= 0) page = 4096;
+    size_t pages = (bytes + (size_t)page - 1) / (size_t)page;
+    // Sample at most 1024 evenly spaced pages.
+    size_t samples = pages < 1024 ? pages : 1024;
+    int nodes = t->numa_nodes > 0 ? t->numa_nodes : 1;
+    size_t *count = (size_t *)calloc((size_t)nodes, sizeof(size_t));
+    size_t known = 0;
+    for (size_t i = 0; count && i < samples; ++i) {
+        size_t off = (pages * i / samples) * (size_t)page;
+        int node = topo_page_node((const char *)buf + off);
+        if (node >= 0 && node < nodes) {
+            count[node]++;
+            known++;
+        }
+    }
+    fprintf(f, "Buffer %s:", name);
+    if (known == 0) {
+        fprintf(f, " node unknown\n");
+    } else {
+        for (int n = 0; n < nodes; ++n)
+            if (count[n]) fprintf(f, " node%d %.1f%%", n, 100.0 * count[n] / known);
+        fprintf(f, " (%zu pages sampled)\n", known);
+    }
+    free(count);
+}
+
+#endif // TOPOLOGY_IMPLEMENTATION
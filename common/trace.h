@@ -0,0 +1,306 @@
+// trace.h - scoped timers with Chrome / Perfetto trace export
+// ------------------------------------------------------------
+// Single-header library in the style of stb_image: include it
+// anywhere for the declarations, and in exactly one C or C++ file
+//
+//     #define TRACE_IMPLEMENTATION
+//     #include "trace.h"
+//
+// to compile the implementation (C files need _GNU_SOURCE or
+// _POSIX_C_SOURCE for clock_gettime).
+//
+// Usage:
+//
+//     trace_init(NULL);                 // records if $TRACE names a file
+//     ...
+//     {
+//         TRACE_SCOPE("pack B");        // C++ destructor, C cleanup attribute
+//         ...
+//     }
+//     trace_scope_t s = trace_begin_arg("band", y0);   // explicit pair
+//     ...
+//     trace_end(&s);
+//     ...
+//     trace_finish();                   // writes the JSON file
+//
+// Every scope becomes one complete ("ph":"X") event in the Chrome trace
+// event format, which chrome://tracing and ui.perfetto.dev open
+// directly: one row per thread, nested scopes stacked, gaps visible.
+//
+// Recording is cheap: timestamps are rdtsc ticks on x86 (CLOCK_MONOTONIC
+// elsewhere), converted to microseconds only when the file is written,
+// and each thread appends to its own ring buffer of $TRACE_EVENTS
+// events (default 16384) with no locking. A full ring overwrites its
+// oldest events; trace_finish() reports how many were lost. While
+// tracing is off (no trace_init, or $TRACE unset) a scope costs one
+// load and branch.
+//
+// Scope names must be string literals (or otherwise outlive
+// trace_finish); only the pointer is stored.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    const char *name;   // NULL when tracing was off at trace_begin
+    uint64_t t0;
+    long arg;
+} trace_scope_t;
+
+// Nonzero while recording.
+extern volatile int trace_on;
+
+// Start recording to 'path', or to $TRACE if path is NULL. Returns 1
+// if tracing is on, 0 if there is no path. Names the calling thread
+// "main".
+int trace_init(const char *path);
+
+// Name the calling thread's row in the viewer (copied, up to 31 chars).
+void trace_thread_name(const char *name);
+
+// Write the trace file and stop recording. Returns 0 on success (or
+// when tracing is off), -1 if the file could not be written.
+int trace_finish(void);
+
+void trace__record(const char *name, uint64_t t0, uint64_t t1, long arg);
+
+static inline uint64_t trace_ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+// 'arg' is shown as args.arg in the viewer (a row, tile or block index).
+static inline trace_scope_t trace_begin_arg(const char *name, long arg) {
+    trace_scope_t s = {0, 0, arg};
+    if (trace_on) {
+        s.name = name;
+        s.t0 = trace_ticks();
+    }
+    return s;
+}
+
+static inline trace_scope_t trace_begin(const char *name) { return trace_begin_arg(name, -1); }
+
+static inline void trace_end(trace_scope_t *s) {
+    if (s->name) trace__record(s->name, s->t0, trace_ticks(), s->arg);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#define TRACE__CAT2(a, b) a##b
+#define TRACE__CAT(a, b) TRACE__CAT2(a, b)
+
+#ifdef __cplusplus
+struct trace_guard {
+    trace_scope_t s;
+    explicit trace_guard(const char *name, long arg = -1) : s(trace_begin_arg(name, arg)) {}
+    ~trace_guard() { trace_end(&s); }
+    trace_guard(const trace_guard &) = delete;
+    trace_guard &operator=(const trace_guard &) = delete;
+};
+#define TRACE_SCOPE(name) trace_guard TRACE__CAT(trace__scope_, __LINE__)(name)
+#define TRACE_SCOPE_ARG(name, arg) trace_guard TRACE__CAT(trace__scope_, __LINE__)(name, arg)
+#else
+#define TRACE_SCOPE(name)                                                      \
+    trace_scope_t TRACE__CAT(trace__scope_, __LINE__)                          \
+        __attribute__((cleanup(trace_end), unused)) = trace_begin(name)
+#define TRACE_SCOPE_ARG(name, arg)                                             \
+    trace_scope_t TRACE__CAT(trace__scope_, __LINE__)                          \
+        __attribute__((cleanup(trace_end), unused)) = trace_begin_arg(name, arg)
+#endif
+
+#endif // TRACE_H
+
+#if defined(TRACE_IMPLEMENTATION) && !defined(TRACE_IMPLEMENTED)
+#define TRACE_IMPLEMENTED
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+    const char *name;
+    uint64_t t0, t1;
+    long arg;
+} trace__event;
+
+typedef struct trace__ring {
+    trace__event *ev;
+    size_t cap;
+    uint64_t count;   // events written, including overwritten ones
+    int tid;
+    char name[32];
+    struct trace__ring *next;
+} trace__ring;
+
+volatile int trace_on = 0;
+
+static pthread_mutex_t trace__lock = PTHREAD_MUTEX_INITIALIZER;
+static trace__ring *trace__rings = NULL;
+static int trace__next_tid = 0;
+static size_t trace__cap = 16384;
+static char trace__path[512];
+static uint64_t trace__tick0;
+static double trace__ns0;
+// trace_finish frees every ring and bumps the generation; a thread's
+// cached ring from an earlier generation is stale and is re-registered.
+static volatile unsigned trace__gen = 0;
+static __thread trace__ring *trace__mine = NULL;
+static __thread unsigned trace__mine_gen = 0;
+
+static double trace__ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// The calling thread's ring, registered on first use.
+static trace__ring *trace__ring_get(void) {
+    if (trace__mine && trace__mine_gen == trace__gen) return trace__mine;
+    trace__ring *r = (trace__ring *)calloc(1, sizeof(trace__ring));
+    if (!r) return NULL;
+    r->ev = (trace__event *)malloc(trace__cap * sizeof(trace__event));
+    if (!r->ev) {
+        free(r);
+        return NULL;
+    }
+    r->cap = trace__cap;
+    pthread_mutex_lock(&trace__lock);
+    r->tid = trace__next_tid++;
+    snprintf(r->name, sizeof(r->name), "thread %d", r->tid);
+    r->next = trace__rings;
+    trace__rings = r;
+    trace__mine_gen = trace__gen;
+    pthread_mutex_unlock(&trace__lock);
+    trace__mine = r;
+    return r;
+}
+
+void trace__record(const char *name, uint64_t t0, uint64_t t1, long arg) {
+    if (!trace_on) return;   // scope still open at trace_finish
+    trace__ring *r = trace__ring_get();
+    if (!r) return;
+    trace__event *e = &r->ev[r->count % r->cap];
+    e->name = name;
+    e->t0 = t0;
+    e->t1 = t1;
+    e->arg = arg;
+    r->count++;
+}
+
+int trace_init(const char *path) {
+    if (!path) path = getenv("TRACE");
+    if (!path || !*path) return 0;
+    snprintf(trace__path, sizeof(trace__path), "%s", path);
+    const char *cap = getenv("TRACE_EVENTS");
+    if (cap && atol(cap) > 0) trace__cap = (size_t)atol(cap);
+    trace__tick0 = trace_ticks();
+    trace__ns0 = trace__ns();
+    trace_on = 1;
+    trace_thread_name("main");
+    return 1;
+}
+
+void trace_thread_name(const char *name) {
+    if (!trace_on) return;
+    trace__ring *r = trace__ring_get();
+    if (r) snprintf(r->name, sizeof(r->name), "%s", name);
+}
+
+static void trace__string(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        if ((unsigned char)*s >= 0x20) fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+int trace_finish(void) {
+    if (!trace_on) return 0;
+    trace_on = 0;
+    // Ticks per microsecond over the whole run (at least 10 ms).
+    while (trace__ns() - trace__ns0 < 1e7) {
+    }
+    double per_us = (double)(trace_ticks() - trace__tick0) / ((trace__ns() - trace__ns0) * 1e-3);
+    if (per_us <= 0) per_us = 1.0;
+
+    int rc = 0;
+    uint64_t lost = 0, total = 0;
+    FILE *f = fopen(trace__path, "w");
+    if (!f) {
+        fprintf(stderr, "Warning: could not write trace '%s'\n", trace__path);
+        rc = -1;
+    }
+    if (f) {
+        int pid = (int)getpid();
+        fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+        int first = 1;
+        for (trace__ring *r = trace__rings; r; r = r->next) {
+            fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                       "\"args\":{\"name\":",
+                    first ? "" : ",\n", pid, r->tid);
+            trace__string(f, r->name);
+            fprintf(f, "}}");
+            first = 0;
+            uint64_t begin = r->count > r->cap ? r->count - r->cap : 0;
+            for (uint64_t i = begin; i < r->count; ++i) {
+                const trace__event *e = &r->ev[i % r->cap];
+                fprintf(f, ",\n{\"name\":");
+                trace__string(f, e->name);
+                fprintf(f, ",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f", pid,
+                        r->tid, (double)(int64_t)(e->t0 - trace__tick0) / per_us,
+                        (double)(e->t1 - e->t0) / per_us);
+                if (e->arg >= 0) fprintf(f, ",\"args\":{\"arg\":%ld}", e->arg);
+                fputc('}', f);
+            }
+            lost += begin;
+            total += r->count;
+        }
+        fprintf(f, "\n]}\n");
+        if (fclose(f) != 0) rc = -1;
+    }
+    if (rc == 0)
+        printf("Trace: %llu events from %d thread(s) written to %s\n",
+               (unsigned long long)(total - lost), trace__next_tid, trace__path);
+    if (lost)
+        fprintf(stderr, "Warning: trace rings overflowed, %llu oldest events lost "
+                        "(raise TRACE_EVENTS)\n", (unsigned long long)lost);
+
+    pthread_mutex_lock(&trace__lock);
+    while (trace__rings) {
+        trace__ring *r = trace__rings;
+        trace__rings = r->next;
+        free(r->ev);
+        free(r);
+    }
+    trace__next_tid = 0;
+    trace__gen++;
+    pthread_mutex_unlock(&trace__lock);
+    trace__mine = NULL;
+    return rc;
+}
+
+#endif // TRACE_IMPLEMENTATION
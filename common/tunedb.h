@@ -0,0 +1,242 @@
+// tunedb.h - autotuning search and persisted tuning database
+// ------------------------------------------------------------
+// Single-header library in the style of stb_image: include it
+// anywhere for the declarations, and in exactly one C or C++ file
+//
+//     #define TUNEDB_IMPLEMENTATION
+//     #include "tunedb.h"
+//
+// to compile the implementation.
+//
+// The database is a plain text file with one result per line:
+//
+//     host <TAB> kernel <TAB> problem <TAB> params <TAB> seconds
+//
+// e.g.
+//
+//     Intel Xeon|L1d=48K|L2=2048K|L3=307200K  conv_direct  512x384x3 k=15x15  tile=16 unroll=0 threads=4  0.0123
+//
+// 'host' identifies the CPU model and its cache sizes, so results
+// never leak between different machines. Lines are only appended;
+// a lookup returns the last matching line, so re-tuning simply
+// overrides older results.
+//
+// The search helper implements successive halving over a grid of
+// candidates: every candidate is first measured on a small fraction
+// of the problem, only the best half survives each round, and the
+// fraction doubles until one candidate is left or the full problem
+// has been measured.
+
+#ifndef TUNEDB_H
+#define TUNEDB_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TUNEDB_FIELD 256
+
+// Path of the tuning database: $TUNEDB, or "results/tuning.db".
+const char *tunedb_default_path(void);
+
+// "<cpu model>|L1d=..K|L2=..K|L3=..K" for the current machine.
+void tunedb_host_key(char *buf, size_t size);
+
+// Find the tuned parameters for (host, kernel, problem). Returns 0 for
+// an exact problem match, 1 if only another problem size of the same
+// kernel on this host was found (its params are returned), -1 if
+// nothing matches.
+int tunedb_lookup(const char *path, const char *host, const char *kernel,
+                  const char *problem, char *params, size_t size);
+
+// Append one result line. Returns 0 on success.
+int tunedb_append(const char *path, const char *host, const char *kernel,
+                  const char *problem, const char *params, double seconds);
+
+// Read "name=<int>" out of a params string such as "tile=16 threads=4".
+int tunedb_param_int(const char *params, const char *name, int fallback);
+
+// Cost of candidate 'cand' measured on 'budget' (0 < budget <= 1) of
+// the problem, scaled to seconds for the whole problem.
+typedef double (*tunedb_eval_fn)(void *ctx, int cand, double budget);
+
+// Successive halving over candidates 0 .. ncand-1. 'min_budget' is the
+// smallest fraction worth measuring. Returns the best candidate and
+// stores its full-problem estimate in *best_seconds.
+int tunedb_successive_halving(int ncand, tunedb_eval_fn eval, void *ctx,
+                              double min_budget, double *best_seconds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TUNEDB_H
+
+#if defined(TUNEDB_IMPLEMENTATION) && !defined(TUNEDB_IMPLEMENTED)
+#define TUNEDB_IMPLEMENTED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char *tunedb_default_path(void) {
+    const char *env = getenv("TUNEDB");
+    return (env && *env) ? env : "results/tuning.db";
+}
+
+static long tunedb__read_long(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+    long v = 0;
+    char unit = 0;
+    if (fscanf(f, "%ld%c", &v, &unit) < 1) v = 0;
+    fclose(f);
+    if (unit == 'M') v *= 1024;
+    return v;
+}
+
+void tunedb_host_key(char *buf, size_t size) {
+    char model[128] = "unknown";
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    if (f) {
+        char line[256];
+        while (fgets(line, sizeof(line), f)) {
+            if (strncmp(line, "model name", 10) == 0) {
+                char *p = strchr(line, ':');
+                if (p) {
+                    p += 1 + strspn(p + 1, " \t");
+                    p[strcspn(p, "\n")] = '\0';
+                    snprintf(model, sizeof(model), "%s", p);
+                }
+                break;
+            }
+        }
+        fclose(f);
+    }
+
+    // Data/unified caches of cpu0, reported in KiB by sysfs.
+    long l1 = 0, l2 = 0, l3 = 0;
+    for (int i = 0; i < 8; ++i) {
+        char path[128], type[32] = "";
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", i);
+        FILE *t = fopen(path, "r");
+        if (!t) break;
+        if (fscanf(t, "%31s", type) != 1) type[0] = '\0';
+        fclose(t);
+        if (strcmp(type, "Instruction") == 0) continue;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", i);
+        long level = tunedb__read_long(path);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", i);
+        long kib = tunedb__read_long(path);
+        if (level == 1) l1 = kib;
+        if (level == 2) l2 = kib;
+        if (level == 3) l3 = kib;
+    }
+    snprintf(buf, size, "%s|L1d=%ldK|L2=%ldK|L3=%ldK", model, l1, l2, l3);
+}
+
+// Split a database line in place into its 5 tab-separated fields.
+static int tunedb__split(char *line, char **fields) {
+    int n = 0;
+    line[strcspn(line, "\r\n")] = '\0';
+    fields[n++] = line;
+    for (char *p = line; *p && n < 5; ++p) {
+        if (*p == '\t') {
+            *p = '\0';
+            fields[n++] = p + 1;
+        }
+    }
+    return n;
+}
+
+int tunedb_lookup(const char *path, const char *host, const char *kernel,
+                  const char *problem, char *params, size_t size) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    int found = -1;
+    char line[4 * TUNEDB_FIELD];
+    while (fgets(line, sizeof(line), f)) {
+        char *fields[5];
+        if (line[0] == '#' || tunedb__split(line, fields) < 4) continue;
+        if (strcmp(fields[0], host) != 0 || strcmp(fields[1], kernel) != 0) continue;
+        int exact = strcmp(fields[2], problem) == 0;
+        if (exact || found != 0) {
+            snprintf(params, size, "%s", fields[3]);
+            found = exact ? 0 : 1;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+int tunedb_append(const char *path, const char *host, const char *kernel,
+                  const char *problem, const char *params, double seconds) {
+    FILE *f = fopen(path, "a");
+    if (!f) {
+        fprintf(stderr, "Warning: could not append to tuning database '%s'\n", path);
+        return -1;
+    }
+    fprintf(f, "%s\t%s\t%s\t%s\t%.6g\n", host, kernel, problem, params, seconds);
+    fclose(f);
+    return 0;
+}
+
+int tunedb_param_int(const char *params, const char *name, int fallback) {
+    size_t len = strlen(name);
+    const char *p = params;
+    while ((p = strstr(p, name)) != NULL) {
+        int at_word = (p == params || p[-1] == ' ');
+        if (at_word && p[len] == '=') return atoi(p + len + 1);
+        p += len;
+    }
+    return fallback;
+}
+
+int tunedb_successive_halving(int ncand, tunedb_eval_fn eval, void *ctx,
+                              double min_budget, double *best_seconds) {
+    int *alive = (int *)malloc((size_t)ncand * sizeof(int));
+    double *cost = (double *)malloc((size_t)ncand * sizeof(double));
+    if (!alive || !cost || ncand <= 0) {
+        free(alive);
+        free(cost);
+        return -1;
+    }
+    for (int i = 0; i < ncand; ++i) alive[i] = i;
+
+    // Start small enough that the last round measures the full problem.
+    int rounds = 1;
+    while ((1 << (rounds - 1)) < ncand) ++rounds;
+    double budget = 1.0 / (double)(1 << (rounds - 1));
+    if (budget < min_budget) budget = min_budget;
+
+    int n = ncand;
+    for (;;) {
+        for (int i = 0; i < n; ++i) cost[i] = eval(ctx, alive[i], budget);
+        // Sort survivors by cost (insertion sort; the grids are small).
+        for (int i = 1; i < n; ++i) {
+            double c = cost[i];
+            int a = alive[i], j = i - 1;
+            while (j >= 0 && cost[j] > c) {
+                cost[j + 1] = cost[j];
+                alive[j + 1] = alive[j];
+                --j;
+            }
+            cost[j + 1] = c;
+            alive[j + 1] = a;
+        }
+        if (n == 1 || budget >= 1.0) break;
+        n = (n + 1) / 2;
+        budget *= 2.0;
+        if (budget > 1.0) budget = 1.0;
+    }
+
+    int best = alive[0];
+    if (best_seconds) *best_seconds = cost[0];
+    free(alive);
+    free(cost);
+    return best;
+}
+
+#endif // TUNEDB_IMPLEMENTATION
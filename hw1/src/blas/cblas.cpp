@@ -0,0 +1,86 @@
+// cblas_sgemm / cblas_dgemm on top of gemm.hpp, built as a shared
+// library (make blas -> bin/libmatmul_blas.so).
+//
+// Threads: $GEMM_NUM_THREADS, else one per physical core.
+//
+// Built with -fvisibility=hidden and without -ffast-math (see the
+// Makefile): only the two entry points below are exported, and loading
+// the library leaves the host's floating-point modes alone.
+#include <cstdio>
+#include <cstdlib>
+
+#include "cblas.h"
+#define TOPOLOGY_IMPLEMENTATION
+#include "topology.h"
+#define TRACE_IMPLEMENTATION
+#include "trace.h"
+#include "../gemm.hpp"
+
+#define CBLAS_EXPORT __attribute__((visibility("default")))
+
+static int gemm_threads() {
+    static const int threads = [] {
+        const char* env = getenv("GEMM_NUM_THREADS");
+        if (env && atoi(env) > 0) return atoi(env);
+        topo_t topo;
+        topo_discover(&topo);
+        int n = topo_default_threads(&topo);
+        topo_free(&topo);
+        return n;
+    }();
+    return threads;
+}
+
+// Argument checks of the reference CBLAS: report the first bad
+// parameter (1-based, as cblas_xerbla does) and do nothing.
+template <typename T>
+static void cblas_gemm(const char* name, CBLAS_ORDER order, CBLAS_TRANSPOSE ta,
+                       CBLAS_TRANSPOSE tb, int m, int n, int k, T alpha, const T* A,
+                       int lda, const T* B, int ldb, T beta, T* C, int ldc) {
+    bool trans_a = ta != CblasNoTrans;
+    bool trans_b = tb != CblasNoTrans;
+    bool row = order == CblasRowMajor;
+    // Columns of the stored matrices in row-major terms.
+    int a_cols = row ? (trans_a ? m : k) : (trans_a ? k : m);
+    int b_cols = row ? (trans_b ? k : n) : (trans_b ? n : k);
+    int c_cols = row ? n : m;
+
+    int bad = 0;
+    if (order != CblasRowMajor && order != CblasColMajor) bad = 1;
+    else if (ta < CblasNoTrans || ta > CblasConjTrans) bad = 2;
+    else if (tb < CblasNoTrans || tb > CblasConjTrans) bad = 3;
+    else if (m < 0) bad = 4;
+    else if (n < 0) bad = 5;
+    else if (k < 0) bad = 6;
+    else if (lda < std::max(1, a_cols)) bad = 9;
+    else if (ldb < std::max(1, b_cols)) bad = 11;
+    else if (ldc < std::max(1, c_cols)) bad = 14;
+    if (bad) {
+        fprintf(stderr, "Parameter %d to routine %s was incorrect\n", bad, name);
+        return;
+    }
+
+    if (row) {
+        gemm(trans_a, trans_b, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, gemm_threads());
+    } else {
+        // A column-major matrix is its transpose in row-major terms:
+        // C^T = op(B)^T * op(A)^T, with the transpose flags unchanged.
+        gemm(trans_b, trans_a, n, m, k, alpha, B, ldb, A, lda, beta, C, ldc, gemm_threads());
+    }
+}
+
+extern "C" CBLAS_EXPORT void cblas_sgemm(
+    const CBLAS_ORDER Order, const CBLAS_TRANSPOSE TransA, const CBLAS_TRANSPOSE TransB,
+    const int m, const int n, const int k, const float alpha, const float* A, const int lda,
+    const float* B, const int ldb, const float beta, float* C, const int ldc) {
+    cblas_gemm("cblas_sgemm", Order, TransA, TransB, m, n, k, alpha, A, lda, B, ldb, beta,
+               C, ldc);
+}
+
+extern "C" CBLAS_EXPORT void cblas_dgemm(
+    const CBLAS_ORDER Order, const CBLAS_TRANSPOSE TransA, const CBLAS_TRANSPOSE TransB,
+    const int m, const int n, const int k, const double alpha, const double* A, const int lda,
+    const double* B, const int ldb, const double beta, double* C, const int ldc) {
+    cblas_gemm("cblas_dgemm", Order, TransA, TransB, m, n, k, alpha, A, lda, B, ldb, beta,
+               C, ldc);
+}
@@ -0,0 +1,30 @@
+/* CBLAS-compatible GEMM entry points backed by ../gemm.hpp.
+ * (Lower-case m, n, k: the hw1 build defines N as a macro.)
+ * Same prototypes and enum values as the reference cblas.h, so
+ * applications can link against libmatmul_blas.so, or keep their
+ * binary and LD_PRELOAD it in front of their BLAS. */
+#ifndef MATMUL_CBLAS_H
+#define MATMUL_CBLAS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum CBLAS_ORDER { CblasRowMajor = 101, CblasColMajor = 102 };
+enum CBLAS_TRANSPOSE { CblasNoTrans = 111, CblasTrans = 112, CblasConjTrans = 113 };
+
+void cblas_sgemm(const enum CBLAS_ORDER Order, const enum CBLAS_TRANSPOSE TransA,
+                 const enum CBLAS_TRANSPOSE TransB, const int m, const int n, const int k,
+                 const float alpha, const float *A, const int lda, const float *B,
+                 const int ldb, const float beta, float *C, const int ldc);
+
+void cblas_dgemm(const enum CBLAS_ORDER Order, const enum CBLAS_TRANSPOSE TransA,
+                 const enum CBLAS_TRANSPOSE TransB, const int m, const int n, const int k,
+                 const double alpha, const double *A, const int lda, const double *B,
+                 const int ldb, const double beta, double *C, const int ldc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MATMUL_CBLAS_H */
@@ -0,0 +1,350 @@
+// Point-to-point byte transport between the worker processes of a
+// distributed run (ranks 0 .. size - 1 on one host, standing in for
+// nodes). Between each ordered pair of ranks, bytes arrive in the order
+// they were sent; recv(src, ...) takes the next bytes from src.
+//
+// Every rank runs a progress ("drain") thread that moves incoming bytes
+// into per-source inboxes as soon as they arrive, so send() never waits
+// for the receiver to call recv() and no send/recv ordering between
+// ranks can deadlock. Backends:
+//
+//   dist_shm_transport  one POSIX shared-memory segment (shm_open) with
+//                       a single-producer ring per ordered pair and
+//                       process-shared semaphores as doorbells
+//   dist_tcp_transport  a full mesh of TCP connections on 127.0.0.1
+//
+// Both are set up in the parent before fork() (dist_shm_setup /
+// dist_tcp_setup) and attached in each child with its rank. A worker
+// that loses its peers cannot continue, so I/O errors end the process
+// (perror, then _exit(1)).
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+inline void dist_fail(const char* what) {
+    perror(what);
+    _exit(1);
+}
+
+class dist_transport {
+public:
+    int rank = 0, size = 1;
+    std::atomic<unsigned long long> bytes_sent{0};
+
+    virtual ~dist_transport() {}
+    virtual void send(int dst, const void* data, size_t bytes) = 0;
+
+    // Blocks until 'bytes' bytes from src have arrived.
+    void recv(int src, void* data, size_t bytes) {
+        inbox& in = inboxes_[src];
+        std::unique_lock<std::mutex> lock(in.mu);
+        char* out = (char*)data;
+        while (bytes > 0) {
+            in.cv.wait(lock, [&] { return !in.chunks.empty(); });
+            std::vector<char>& front = in.chunks.front();
+            size_t len = std::min(bytes, front.size() - in.offset);
+            std::memcpy(out, front.data() + in.offset, len);
+            out += len;
+            bytes -= len;
+            in.offset += len;
+            if (in.offset == front.size()) {
+                in.chunks.pop_front();
+                in.offset = 0;
+            }
+        }
+    }
+
+    // All ranks wait for each other (through rank 0).
+    void barrier() {
+        char token = 0;
+        if (rank == 0) {
+            for (int r = 1; r < size; ++r) recv(r, &token, 1);
+            for (int r = 1; r < size; ++r) send(r, &token, 1);
+        } else {
+            send(0, &token, 1);
+            recv(0, &token, 1);
+        }
+    }
+
+protected:
+    struct inbox {
+        std::mutex mu;
+        std::condition_variable cv;
+        std::deque<std::vector<char>> chunks;
+        size_t offset = 0;   // consumed bytes of chunks.front()
+    };
+    std::vector<inbox> inboxes_;
+
+    void init_inboxes() { inboxes_ = std::vector<inbox>(size); }
+
+    void deliver(int src, const char* data, size_t bytes) {
+        inbox& in = inboxes_[src];
+        {
+            std::lock_guard<std::mutex> lock(in.mu);
+            in.chunks.emplace_back(data, data + bytes);
+        }
+        in.cv.notify_one();
+    }
+};
+
+// Shared segment: a doorbell per rank, then per ordered pair (src, dst)
+// a ring of 'ring_bytes' with its head (advanced by dst), tail
+// (advanced by src) and a 'space' semaphore posted when dst frees room.
+struct dist_shm_ring {
+    std::atomic<uint64_t> head;
+    char pad0[56];
+    std::atomic<uint64_t> tail;
+    char pad1[56];
+    sem_t space;
+};
+
+struct dist_shm_segment {
+    void* base = nullptr;
+    size_t bytes = 0, ring_bytes = 0;
+    int size = 0;
+
+    sem_t* doorbell(int r) const { return (sem_t*)((char*)base + 64 * r); }
+    size_t ring_offset(int src, int dst) const {
+        size_t header = 64 * (size_t)size;
+        return header + (size_t)(src * size + dst) * (sizeof(dist_shm_ring) + ring_bytes);
+    }
+    dist_shm_ring* ring(int src, int dst) const {
+        return (dist_shm_ring*)((char*)base + ring_offset(src, dst));
+    }
+    char* ring_data(int src, int dst) const { return (char*)(ring(src, dst) + 1); }
+};
+
+// Create and initialize the segment; the name is unlinked right away,
+// so the mapping (inherited over fork) is its only reference.
+inline bool dist_shm_setup(dist_shm_segment& seg, int size, size_t ring_bytes = 1 << 20) {
+    static_assert(sizeof(sem_t) <= 64, "doorbell slots are 64 bytes");
+    seg.size = size;
+    seg.ring_bytes = ring_bytes;
+    seg.bytes = seg.ring_offset(size - 1, size - 1) + sizeof(dist_shm_ring) + ring_bytes;
+    char name[64];
+    snprintf(name, sizeof(name), "/gemm_dist_%d", (int)getpid());
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) return false;
+    shm_unlink(name);
+    bool ok = ftruncate(fd, (off_t)seg.bytes) == 0;
+    if (ok) {
+        seg.base = mmap(nullptr, seg.bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ok = seg.base != MAP_FAILED;
+    }
+    close(fd);
+    if (!ok) return false;
+    for (int r = 0; r < size; ++r) sem_init(seg.doorbell(r), 1, 0);
+    for (int s = 0; s < size; ++s)
+        for (int d = 0; d < size; ++d) {
+            dist_shm_ring* q = new (seg.ring(s, d)) dist_shm_ring;
+            q->head.store(0);
+            q->tail.store(0);
+            sem_init(&q->space, 1, 0);
+        }
+    return true;
+}
+
+// Destroy the semaphores and unmap the segment, once no rank uses it.
+inline void dist_shm_teardown(dist_shm_segment& seg) {
+    if (!seg.base) return;
+    for (int r = 0; r < seg.size; ++r) sem_destroy(seg.doorbell(r));
+    for (int s = 0; s < seg.size; ++s)
+        for (int d = 0; d < seg.size; ++d) sem_destroy(&seg.ring(s, d)->space);
+    munmap(seg.base, seg.bytes);
+    seg.base = nullptr;
+}
+
+class dist_shm_transport : public dist_transport {
+public:
+    dist_shm_transport(const dist_shm_segment& seg, int rank) : seg_(seg) {
+        this->rank = rank;
+        size = seg.size;
+        init_inboxes();
+        drain_ = std::thread([this] { drain(); });
+    }
+    ~dist_shm_transport() override {
+        stop_ = true;
+        sem_post(seg_.doorbell(rank));
+        drain_.join();
+    }
+
+    void send(int dst, const void* data, size_t bytes) override {
+        std::lock_guard<std::mutex> lock(send_mu_);
+        dist_shm_ring* q = seg_.ring(rank, dst);
+        const char* in = (const char*)data;
+        const uint64_t cap = seg_.ring_bytes;
+        bytes_sent += bytes;
+        while (bytes > 0) {
+            uint64_t tail = q->tail.load(std::memory_order_relaxed);
+            uint64_t used = tail - q->head.load(std::memory_order_acquire);
+            if (used == cap) {
+                while (sem_wait(&q->space) != 0) {}
+                continue;
+            }
+            size_t at = tail % cap;
+            size_t len = std::min({(uint64_t)bytes, cap - used, cap - at});
+            std::memcpy(seg_.ring_data(rank, dst) + at, in, len);
+            q->tail.store(tail + len, std::memory_order_release);
+            sem_post(seg_.doorbell(dst));
+            in += len;
+            bytes -= len;
+        }
+    }
+
+private:
+    dist_shm_segment seg_;
+    std::mutex send_mu_;   // one writer per ring
+    std::thread drain_;
+    std::atomic<bool> stop_{false};
+
+    void drain() {
+        const uint64_t cap = seg_.ring_bytes;
+        while (!stop_) {
+            while (sem_wait(seg_.doorbell(rank)) != 0) {}
+            for (int src = 0; src < size; ++src) {
+                dist_shm_ring* q = seg_.ring(src, rank);
+                for (;;) {
+                    uint64_t head = q->head.load(std::memory_order_relaxed);
+                    uint64_t avail = q->tail.load(std::memory_order_acquire) - head;
+                    if (avail == 0) break;
+                    size_t at = head % cap;
+                    size_t len = std::min(avail, cap - at);
+                    deliver(src, seg_.ring_data(src, rank) + at, len);
+                    q->head.store(head + len, std::memory_order_release);
+                    sem_post(&q->space);
+                }
+            }
+        }
+    }
+};
+
+// One listening socket per rank on 127.0.0.1 (ephemeral ports), made
+// before fork so the children know each other's ports.
+struct dist_tcp_listeners {
+    std::vector<int> fds;
+    std::vector<int> ports;
+};
+
+inline bool dist_tcp_setup(dist_tcp_listeners& L, int size) {
+    for (int r = 0; r < size; ++r) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        socklen_t len = sizeof(addr);
+        if (fd < 0 || bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, size) != 0 ||
+            getsockname(fd, (sockaddr*)&addr, &len) != 0)
+            return false;
+        L.fds.push_back(fd);
+        L.ports.push_back(ntohs(addr.sin_port));
+    }
+    return true;
+}
+
+class dist_tcp_transport : public dist_transport {
+public:
+    // Connects to every lower rank and accepts every higher one; each
+    // connection starts with the connecting rank's number.
+    dist_tcp_transport(const dist_tcp_listeners& L, int rank) {
+        this->rank = rank;
+        size = (int)L.fds.size();
+        init_inboxes();
+        fds_.assign(size, -1);
+        send_mu_ = std::vector<std::mutex>(size);
+        for (int r = 0; r < size; ++r)
+            if (r != rank) close(L.fds[r]);
+        for (int peer = 0; peer < rank; ++peer) {
+            int fd = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons(L.ports[peer]);
+            if (fd < 0 || connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) dist_fail("connect");
+            write_all(fd, &rank, sizeof(rank));
+            fds_[peer] = fd;
+        }
+        for (int n = rank + 1; n < size; ++n) {
+            int fd = accept(L.fds[rank], nullptr, nullptr);
+            int peer = -1;
+            if (fd < 0 || !read_all(fd, &peer, sizeof(peer)) || peer <= rank || peer >= size)
+                dist_fail("accept");
+            fds_[peer] = fd;
+        }
+        close(L.fds[rank]);
+        int one = 1;
+        for (int peer = 0; peer < size; ++peer) {
+            if (peer == rank) continue;
+            setsockopt(fds_[peer], IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            drains_.emplace_back([this, peer] { drain(peer); });
+        }
+    }
+    // Closing our write side ends the peers' drain threads; ours end
+    // when the peers do the same.
+    ~dist_tcp_transport() override {
+        for (int peer = 0; peer < size; ++peer)
+            if (peer != rank) shutdown(fds_[peer], SHUT_WR);
+        for (auto& t : drains_) t.join();
+        for (int peer = 0; peer < size; ++peer)
+            if (peer != rank) close(fds_[peer]);
+    }
+
+    void send(int dst, const void* data, size_t bytes) override {
+        std::lock_guard<std::mutex> lock(send_mu_[dst]);
+        bytes_sent += bytes;
+        write_all(fds_[dst], data, bytes);
+    }
+
+private:
+    std::vector<int> fds_;
+    std::vector<std::mutex> send_mu_;
+    std::vector<std::thread> drains_;
+
+    static void write_all(int fd, const void* data, size_t bytes) {
+        const char* p = (const char*)data;
+        while (bytes > 0) {
+            ssize_t n = write(fd, p, bytes);
+            if (n <= 0) dist_fail("write");
+            p += n;
+            bytes -= n;
+        }
+    }
+    static bool read_all(int fd, void* data, size_t bytes) {
+        char* p = (char*)data;
+        while (bytes > 0) {
+            ssize_t n = read(fd, p, bytes);
+            if (n <= 0) return false;
+            p += n;
+            bytes -= n;
+        }
+        return true;
+    }
+
+    void drain(int peer) {
+        std::vector<char> buf(1 << 20);
+        for (;;) {
+            ssize_t n = read(fds_[peer], buf.data(), buf.size());
+            if (n == 0) return;
+            if (n < 0) dist_fail("read");
+            deliver(peer, buf.data(), (size_t)n);
+        }
+    }
+};
@@ -0,0 +1,563 @@
+// General matrix multiply for rectangular row-major matrices:
+//
+//     C = alpha * op(A) * op(B) + beta * C
+//
+// op(A) is M x K, op(B) is K x N, C is M x N; lda / ldb / ldc are the
+// row strides of the stored matrices, so sub-matrices and transposed
+// operands work without copies. The structure follows BLIS / GotoBLAS:
+// B is packed in kc x nc blocks into NR-column panels, A in mc x kc
+// blocks into MR-row panels, and an MR x NR register-tile micro-kernel
+// multiplies one pair of panels. The block sizes come from the cache
+// topology (topology.h), so the translation unit must also define
+// TOPOLOGY_IMPLEMENTATION. Bands, packing and the tile loops are
+// trace.h scopes (TRACE_IMPLEMENTATION as well), recorded when the
+// program calls trace_init.
+//
+// Two memory-access switches ride along with the blocking and are off
+// by default: gemm_blocking::prefetch issues software prefetches
+// 'prefetch' k-steps ahead in the A and B panels (running on into the
+// next panels near the end) and for the C tile before it is updated;
+// gemm_blocking::stream_c writes the last update of each C tile with
+// non-temporal stores (the vector-aligned middle of each tile row; the
+// head and tail use ordinary stores), and with beta == 0 and K in one
+// block writes C without reading it at all. gemm_streamed_tiles counts
+// the tiles that actually got non-temporal stores.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "topology.h"
+#include "trace.h"
+
+// Vector width of the build, in bytes.
+#if defined(__AVX512F__)
+#define GEMM_VEC_BYTES 64
+#elif defined(__AVX__)
+#define GEMM_VEC_BYTES 32
+#else
+#define GEMM_VEC_BYTES 16
+#endif
+
+// Register tile of the micro-kernel: MR rows of accumulators, each
+// NR_VECS vectors wide. With AVX-512 (32 registers) that is three
+// 64-byte vectors (6 x 24 doubles, 6 x 48 floats / ints), the fastest
+// shape measured for all three types with GCC -O3 -march=native;
+// narrower tiles were not kept in registers and ran up to 10x slower.
+// AVX2 and SSE have 16 registers, so the tile is two vectors wide
+// (6 x 16 floats on AVX2): 12 accumulators, a B row and a broadcast A.
+template <typename T>
+struct gemm_shape {
+    static constexpr int NR_VECS = GEMM_VEC_BYTES == 64 ? 3 : 2;
+    static constexpr int MR = 6;
+    static constexpr int NR = NR_VECS * GEMM_VEC_BYTES / sizeof(T);
+};
+
+struct gemm_blocking {
+    int mc, kc, nc;
+    int prefetch = 0;        // prefetch distance in k-steps, 0 = off
+    bool stream_c = false;   // non-temporal stores for the final C
+};
+
+// Cache blocking for element type T, derived once per process.
+template <typename T>
+gemm_blocking gemm_default_blocking() {
+    static const gemm_blocking blocking = [] {
+        topo_t topo;
+        topo_discover(&topo);
+        gemm_blocking b;
+        topo_gemm_blocking(&topo, sizeof(T), gemm_shape<T>::MR, gemm_shape<T>::NR,
+                           &b.mc, &b.kc, &b.nc);
+        topo_free(&topo);
+        return b;
+    }();
+    return blocking;
+}
+
+// Element (r, c) of op(X) for a row-major X with leading dimension ld.
+template <typename T>
+inline T gemm_at(const T* X, int ld, bool trans, int r, int c) {
+    return trans ? X[(size_t)c * ld + r] : X[(size_t)r * ld + c];
+}
+
+// Rows [i0, i0 + mc) x columns [p0, p0 + kc) of op(A) as MR-row panels:
+// panel r holds Ap[r * MR * kc + p * MR + i], zero padded to MR rows.
+template <typename T>
+void gemm_pack_a(const T* A, int lda, bool trans, int i0, int mc, int p0, int kc, T* Ap) {
+    constexpr int MR = gemm_shape<T>::MR;
+    for (int ir = 0; ir < mc; ir += MR) {
+        int m = std::min(MR, mc - ir);
+        for (int p = 0; p < kc; ++p) {
+            for (int i = 0; i < MR; ++i)
+                Ap[p * MR + i] = i < m ? gemm_at(A, lda, trans, i0 + ir + i, p0 + p) : T(0);
+        }
+        Ap += MR * kc;
+    }
+}
+
+// Rows [p0, p0 + kc) x columns [j0, j0 + nc) of op(B) as NR-column
+// panels: panel r holds Bp[r * NR * kc + p * NR + j], zero padded.
+template <typename T>
+void gemm_pack_b(const T* B, int ldb, bool trans, int p0, int kc, int j0, int nc, T* Bp) {
+    constexpr int NR = gemm_shape<T>::NR;
+    for (int jr = 0; jr < nc; jr += NR) {
+        int n = std::min(NR, nc - jr);
+        for (int p = 0; p < kc; ++p) {
+            for (int j = 0; j < NR; ++j)
+                Bp[p * NR + j] = j < n ? gemm_at(B, ldb, trans, p0 + p, j0 + jr + j) : T(0);
+        }
+        Bp += NR * kc;
+    }
+}
+
+// How a micro-tile reaches C: C += alpha * acc with ordinary stores,
+// the same with non-temporal stores, or C = alpha * acc with
+// non-temporal stores (C not read).
+enum gemm_store { GEMM_STORE_ADD, GEMM_STORE_ADD_STREAM, GEMM_STORE_SET_STREAM };
+
+struct gemm_tile_mode {
+    int prefetch;
+    gemm_store store;
+    long long* streamed = nullptr;   // incremented per tile with streaming stores
+};
+
+// Tiles whose final store used non-temporal stores, over all gemm()
+// calls of the process.
+inline std::atomic<long long> gemm_streamed_tiles{0};
+
+// Store v[0, n) to Ci: the part aligned to the vector width with
+// non-temporal stores, the head and tail around it with ordinary ones.
+// True if anything was streamed.
+template <typename T>
+inline bool gemm_stream_row(T* Ci, const T* v, int n) {
+#if defined(__AVX512F__)
+    constexpr size_t VB = 64;
+#elif defined(__AVX__)
+    constexpr size_t VB = 32;
+#elif defined(__SSE2__)
+    constexpr size_t VB = 16;
+#else
+    constexpr size_t VB = 0;
+#endif
+    char* dst = (char*)Ci;
+    const char* src = (const char*)v;
+    size_t bytes = (size_t)n * sizeof(T);
+    size_t head = VB ? std::min(bytes, (VB - (uintptr_t)dst % VB) % VB) : bytes;
+    size_t end = VB ? head + (bytes - head) / VB * VB : bytes;
+    std::memcpy(dst, src, head);
+    for (size_t o = head; o < end; o += VB) {
+#if defined(__AVX512F__)
+        _mm512_stream_si512((__m512i*)(dst + o), _mm512_loadu_si512(src + o));
+#elif defined(__AVX__)
+        _mm256_stream_si256((__m256i*)(dst + o), _mm256_loadu_si256((const __m256i*)(src + o)));
+#elif defined(__SSE2__)
+        _mm_stream_si128((__m128i*)(dst + o), _mm_loadu_si128((const __m128i*)(src + o)));
+#endif
+    }
+    std::memcpy(dst + end, src + end, bytes - end);
+    return end > head;
+}
+
+// Drain the write-combining buffers after streaming stores.
+inline void gemm_stream_fence() {
+#if defined(__SSE2__)
+    _mm_sfence();
+#endif
+}
+
+// C[0..m) x [0..n) += alpha * Ap * Bp for one MR-row and one NR-column
+// panel of depth kc. The accumulators have compile-time extents, so
+// the compiler keeps them in vector registers. Prefetch adds prefetches
+// mode.prefetch k-steps ahead (one per cache line of the A and B
+// slices) and of the C tile.
+template <typename T, bool Prefetch = false>
+inline void gemm_micro_kernel(int kc, const T* Ap, const T* Bp, T* C, int ldc, T alpha,
+                              int m, int n, gemm_tile_mode mode = {0, GEMM_STORE_ADD}) {
+    constexpr int MR = gemm_shape<T>::MR;
+    constexpr int NR = gemm_shape<T>::NR;
+    if (Prefetch && mode.store != GEMM_STORE_SET_STREAM)
+        for (int i = 0; i < m; ++i)
+            for (int j = 0; j < n; j += 64 / sizeof(T))
+                __builtin_prefetch(C + (size_t)i * ldc + j, 1, 3);
+    // One accumulator array per vector column: GCC keeps small arrays of
+    // vectors in registers, but not a single MR x NR_VECS one.
+    constexpr int NV = gemm_shape<T>::NR_VECS, W = NR / NV;
+    static_assert(NV == 2 || NV == 3, "tile is two or three vectors wide");
+    typedef T vec __attribute__((vector_size(GEMM_VEC_BYTES)));
+    vec c0[MR] = {}, c1[MR] = {}, c2[MR] = {};
+    for (int p = 0; p < kc; ++p) {
+        const T* a = Ap + p * MR;
+        const T* b = Bp + p * NR;
+        if (Prefetch) {
+            __builtin_prefetch(a + mode.prefetch * MR);
+            for (int j = 0; j < NR; j += 64 / sizeof(T))
+                __builtin_prefetch(b + mode.prefetch * NR + j);
+        }
+        vec b0, b1, b2;
+        std::memcpy(&b0, b, sizeof(vec));
+        std::memcpy(&b1, b + W, sizeof(vec));
+        if (NV == 3) std::memcpy(&b2, b + 2 * W, sizeof(vec));
+        for (int i = 0; i < MR; ++i) {
+            T ai = a[i];
+            c0[i] += ai * b0;
+            c1[i] += ai * b1;
+            if (NV == 3) c2[i] += ai * b2;
+        }
+    }
+    T acc[MR][NR];
+    for (int i = 0; i < MR; ++i) {
+        std::memcpy(&acc[i][0], &c0[i], sizeof(vec));
+        std::memcpy(&acc[i][W], &c1[i], sizeof(vec));
+        if (NV == 3) std::memcpy(&acc[i][2 * W], &c2[i], sizeof(vec));
+    }
+    bool streamed = false;
+    for (int i = 0; i < m; ++i) {
+        T* Ci = C + (size_t)i * ldc;
+        if (mode.store == GEMM_STORE_ADD) {
+            for (int j = 0; j < n; ++j) Ci[j] += alpha * acc[i][j];
+            continue;
+        }
+        T v[NR];
+        for (int j = 0; j < NR; ++j)
+            v[j] = mode.store == GEMM_STORE_SET_STREAM ? alpha * acc[i][j]
+                                                       : Ci[j < n ? j : 0] + alpha * acc[i][j];
+        streamed |= gemm_stream_row(Ci, v, n);
+    }
+    if (streamed && mode.streamed) ++*mode.streamed;
+}
+
+// Same into a double C with double products and sums. A full float
+// tile would need twice the vectors as doubles, so the panel is done in
+// slices of W columns that take as many registers as the T tile
+// (6 x 24 doubles on AVX-512), re-reading the A panel once per slice.
+template <typename T>
+inline void gemm_micro_kernel_wide(int kc, const T* Ap, const T* Bp, double* C, int ldc,
+                                   T alpha, int m, int n) {
+    constexpr int MR = gemm_shape<T>::MR;
+    constexpr int NR = gemm_shape<T>::NR;
+    constexpr int W = NR * sizeof(T) / sizeof(double);
+    static_assert(NR % W == 0, "slices must tile the panel");
+    for (int j0 = 0; j0 < n; j0 += W) {
+        double acc[MR][W] = {};
+        for (int p = 0; p < kc; ++p) {
+            const T* a = Ap + p * MR;
+            const T* b = Bp + p * NR + j0;
+            for (int i = 0; i < MR; ++i) {
+                double ai = a[i];
+                for (int j = 0; j < W; ++j) acc[i][j] += ai * (double)b[j];
+            }
+        }
+        int w = std::min(W, n - j0);
+        for (int i = 0; i < m; ++i) {
+            double* Ci = C + (size_t)i * ldc + j0;
+            for (int j = 0; j < w; ++j) Ci[j] += (double)alpha * acc[i][j];
+        }
+    }
+}
+
+// Kahan-compensated sums in T, in slices of one vector (sums and
+// compensations take 12 vectors). The block sum is added into C with
+// compensation as well, carried between kc blocks in comp (row stride
+// ldcomp). Under -ffast-math the compiler may rewrite (t - s) - y as
+// zero; the empty asm statements make t and t - s opaque values so
+// the compensation survives (x86 "v" register constraint).
+template <typename T>
+inline void gemm_micro_kernel_kahan(int kc, const T* Ap, const T* Bp, T* C, int ldc,
+                                    T* comp, int ldcomp, T alpha, int m, int n) {
+    constexpr int MR = gemm_shape<T>::MR;
+    constexpr int NR = gemm_shape<T>::NR;
+    constexpr int VB = GEMM_VEC_BYTES;
+    constexpr int W = VB / sizeof(T);
+    static_assert(NR % W == 0, "slices must tile the panel");
+    typedef T vec __attribute__((vector_size(VB)));
+    for (int j0 = 0; j0 < n; j0 += W) {
+        vec sum[MR] = {}, c[MR] = {};
+        for (int p = 0; p < kc; ++p) {
+            const T* a = Ap + p * MR;
+            vec b;
+            std::memcpy(&b, Bp + p * NR + j0, sizeof(b));
+            for (int i = 0; i < MR; ++i) {
+                vec y = a[i] * b - c[i];
+                vec t = sum[i] + y;
+                asm("" : "+v"(t));
+                vec z = t - sum[i];
+                asm("" : "+v"(z));
+                c[i] = z - y;
+                sum[i] = t;
+            }
+        }
+        int w = std::min(W, n - j0);
+        for (int i = 0; i < m; ++i) {
+            T* Ci = C + (size_t)i * ldc + j0;
+            T* ci = comp + (size_t)i * ldcomp + j0;
+            for (int j = 0; j < w; ++j) {
+                T y = alpha * (sum[i][j] - c[i][j]) - ci[j];
+                T t = Ci[j] + y;
+                asm("" : "+v"(t));
+                T z = t - Ci[j];
+                asm("" : "+v"(z));
+                ci[j] = z - y;
+                Ci[j] = t;
+            }
+        }
+    }
+}
+
+// Accumulation policies (the Acc parameter of gemm):
+//   gemm_acc_native  products and sums in T
+//   gemm_acc_double  products and sums in double, across all of K: the
+//                    band of C is accumulated in a double copy and
+//                    rounded to T once at the end
+//   gemm_acc_kahan   sums in T with Kahan compensation, across all of K
+// gemm_acc_band<T, Acc> holds the per-band state and runs one
+// micro-tile at rows / columns (i, j) of C; only the native policy
+// honours the prefetch / streaming tile mode.
+struct gemm_acc_native {};
+struct gemm_acc_double {};
+struct gemm_acc_kahan {};
+
+template <typename T, typename Acc>
+struct gemm_acc_band;
+
+template <typename T>
+struct gemm_acc_band<T, gemm_acc_native> {
+    T* C;
+    int ldc;
+    gemm_acc_band(T* C, int ldc, int, int, int) : C(C), ldc(ldc) {}
+    void tile(int kc, const T* Ap, const T* Bp, int i, int j, T alpha, int m, int n,
+              gemm_tile_mode mode) {
+        T* Cij = C + (size_t)i * ldc + j;
+        if (mode.prefetch > 0)
+            gemm_micro_kernel<T, true>(kc, Ap, Bp, Cij, ldc, alpha, m, n, mode);
+        else
+            gemm_micro_kernel<T, false>(kc, Ap, Bp, Cij, ldc, alpha, m, n, mode);
+    }
+    void finish() {}
+};
+
+template <typename T>
+struct gemm_acc_band<T, gemm_acc_double> {
+    T* C;
+    int ldc, i0, i1, n;
+    std::vector<double> W;
+    gemm_acc_band(T* C, int ldc, int i0, int i1, int n)
+        : C(C), ldc(ldc), i0(i0), i1(i1), n(n), W((size_t)(i1 - i0) * n) {
+        for (int i = i0; i < i1; ++i)
+            for (int j = 0; j < n; ++j) W[(size_t)(i - i0) * n + j] = C[(size_t)i * ldc + j];
+    }
+    void tile(int kc, const T* Ap, const T* Bp, int i, int j, T alpha, int m, int nn,
+              gemm_tile_mode) {
+        gemm_micro_kernel_wide(kc, Ap, Bp, &W[(size_t)(i - i0) * n + j], n, alpha, m, nn);
+    }
+    void finish() {
+        for (int i = i0; i < i1; ++i)
+            for (int j = 0; j < n; ++j) C[(size_t)i * ldc + j] = (T)W[(size_t)(i - i0) * n + j];
+    }
+};
+
+template <typename T>
+struct gemm_acc_band<T, gemm_acc_kahan> {
+    T* C;
+    int ldc, i0, i1, n;
+    std::vector<T> comp;
+    gemm_acc_band(T* C, int ldc, int i0, int i1, int n)
+        : C(C), ldc(ldc), i0(i0), i1(i1), n(n), comp((size_t)(i1 - i0) * n) {}
+    void tile(int kc, const T* Ap, const T* Bp, int i, int j, T alpha, int m, int nn,
+              gemm_tile_mode) {
+        gemm_micro_kernel_kahan(kc, Ap, Bp, C + (size_t)i * ldc + j, ldc,
+                                &comp[(size_t)(i - i0) * n + j], n, alpha, m, nn);
+    }
+    // The compensation is the negated rounding error still missing.
+    void finish() {
+        for (int i = i0; i < i1; ++i)
+            for (int j = 0; j < n; ++j) C[(size_t)i * ldc + j] -= comp[(size_t)(i - i0) * n + j];
+    }
+};
+
+// C[i0..i1) *= beta; beta == 0 overwrites (NaNs in C do not survive,
+// as in BLAS).
+template <typename T>
+void gemm_scale_rows(T* C, int ldc, int i0, int i1, int n, T beta) {
+    if (beta == T(1)) return;
+    for (int i = i0; i < i1; ++i) {
+        T* Ci = C + (size_t)i * ldc;
+        for (int j = 0; j < n; ++j) Ci[j] = beta == T(0) ? T(0) : beta * Ci[j];
+    }
+}
+
+// Rows [i0, i1) of C, single-threaded. packed_b(jc, nb, pc, kb, buf)
+// returns the kb x nb block of op(B) at (pc, jc) in panel layout,
+// either packed into 'buf' now or taken from a pre-packed matrix.
+template <typename T, typename Acc = gemm_acc_native, typename PackedB>
+void gemm_rows_with(bool trans_a, int i0, int i1, int n, int k, T alpha,
+                    const T* A, int lda, PackedB packed_b, T beta, T* C, int ldc,
+                    const gemm_blocking& bs) {
+    constexpr int MR = gemm_shape<T>::MR;
+    constexpr int NR = gemm_shape<T>::NR;
+    TRACE_SCOPE_ARG("gemm rows", i0);
+    int kc = std::min(bs.kc, k);
+    // Streaming is for the native policy; with beta == 0 and a single K
+    // block C is written once, so it is neither scaled nor read.
+    bool stream = std::is_same<Acc, gemm_acc_native>::value && bs.stream_c;
+    bool overwrite = stream && beta == T(0) && alpha != T(0) && k > 0 && k <= kc;
+    if (!overwrite) gemm_scale_rows(C, ldc, i0, i1, n, beta);
+    if (alpha == T(0) || k == 0) return;
+
+    int mc = std::min(bs.mc, ((i1 - i0 + MR - 1) / MR) * MR);
+    int nc = std::min(bs.nc, ((n + NR - 1) / NR) * NR);
+    std::vector<T> Ap((size_t)mc * kc), buf;
+    gemm_acc_band<T, Acc> band(C, ldc, i0, i1, n);
+    long long streamed = 0;
+
+    for (int jc = 0; jc < n; jc += nc) {
+        int nb = std::min(nc, n - jc);
+        for (int pc = 0; pc < k; pc += kc) {
+            int kb = std::min(kc, k - pc);
+            gemm_tile_mode mode = {bs.prefetch, GEMM_STORE_ADD, &streamed};
+            if (stream && pc + kb == k)
+                mode.store = overwrite ? GEMM_STORE_SET_STREAM : GEMM_STORE_ADD_STREAM;
+            trace_scope_t pack_b = trace_begin_arg("pack B", pc);
+            const T* Bp = packed_b(jc, nb, pc, kb, buf);
+            trace_end(&pack_b);
+            for (int ic = i0; ic < i1; ic += mc) {
+                int mb = std::min(mc, i1 - ic);
+                trace_scope_t pack_a = trace_begin_arg("pack A", ic);
+                gemm_pack_a(A, lda, trans_a, ic, mb, pc, kb, Ap.data());
+                trace_end(&pack_a);
+                TRACE_SCOPE_ARG("tiles", ic);
+                for (int jr = 0; jr < nb; jr += NR) {
+                    for (int ir = 0; ir < mb; ir += MR) {
+                        band.tile(kb, &Ap[(size_t)ir * kb], &Bp[(size_t)jr * kb], ic + ir,
+                                  jc + jr, alpha, std::min(MR, mb - ir), std::min(NR, nb - jr),
+                                  mode);
+                    }
+                }
+            }
+        }
+    }
+    band.finish();
+    if (stream) {
+        gemm_stream_fence();
+        gemm_streamed_tiles += streamed;
+    }
+}
+
+template <typename T, typename Acc = gemm_acc_native>
+void gemm_rows(bool trans_a, bool trans_b, int i0, int i1, int n, int k, T alpha,
+               const T* A, int lda, const T* B, int ldb, T beta, T* C, int ldc,
+               const gemm_blocking& bs) {
+    auto pack_now = [=](int jc, int nb, int pc, int kb, std::vector<T>& buf) {
+        constexpr int NR = gemm_shape<T>::NR;
+        buf.resize((size_t)((nb + NR - 1) / NR) * NR * kb);
+        gemm_pack_b(B, ldb, trans_b, pc, kb, jc, nb, buf.data());
+        return (const T*)buf.data();
+    };
+    gemm_rows_with<T, Acc>(trans_a, i0, i1, n, k, alpha, A, lda, pack_now, beta, C, ldc, bs);
+}
+
+// All of op(B) packed in kc x nc blocks of NR-column panels, in the
+// order gemm_rows_with walks them. Every block but the last in each
+// direction is full and nc is a multiple of NR, so the blocks before
+// column jc hold exactly jc * k elements (gemm_packed_block).
+template <typename T>
+void gemm_pack_b_all(const T* B, int ldb, bool trans, int k, int n, int kc, int nc, T* Bp) {
+    constexpr int NR = gemm_shape<T>::NR;
+    for (int jc = 0; jc < n; jc += nc) {
+        int nb = std::min(nc, n - jc);
+        size_t width = (size_t)((nb + NR - 1) / NR) * NR;
+        for (int pc = 0; pc < k; pc += kc)
+            gemm_pack_b(B, ldb, trans, pc, std::min(kc, k - pc), jc, nb,
+                        Bp + (size_t)jc * k + (size_t)pc * width);
+    }
+}
+
+// Start of the kb x nb block at (pc, jc) in a gemm_pack_b_all buffer.
+template <typename T>
+inline const T* gemm_packed_block(const T* Bp, int k, int jc, int nb, int pc) {
+    constexpr int NR = gemm_shape<T>::NR;
+    size_t width = (size_t)((nb + NR - 1) / NR) * NR;
+    return Bp + (size_t)jc * k + (size_t)pc * width;
+}
+
+// Split the rows of an m-row C into one band (a multiple of MR rows)
+// per thread and run f(i0, i1) on each.
+template <typename T, typename F>
+void gemm_for_each_band(int m, int threads, F f) {
+    constexpr int MR = gemm_shape<T>::MR;
+    int panels = (m + MR - 1) / MR;
+    threads = std::max(1, std::min(threads, panels));
+    if (threads == 1) {
+        f(0, m);
+        return;
+    }
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        int i0 = std::min(m, (panels * t / threads) * MR);
+        int i1 = std::min(m, (panels * (t + 1) / threads) * MR);
+        pool.emplace_back([=] {
+            if (trace_on) {
+                char name[32];
+                snprintf(name, sizeof(name), "gemm band %d", t);
+                trace_thread_name(name);
+            }
+            f(i0, i1);
+        });
+    }
+    for (auto& th : pool) th.join();
+}
+
+// C = alpha * op(A) * op(B) + beta * C. The rows of C are split into
+// one band (a multiple of MR rows) per thread. With more than one band,
+// op(B) is packed once up front and the bands share it instead of each
+// packing every block again (one extra k x n buffer); a single band
+// packs block by block. Acc selects the accumulation policy, e.g.
+// gemm<float, gemm_acc_double>(...). The second form takes explicit
+// blocking and memory switches.
+template <typename T, typename Acc = gemm_acc_native>
+void gemm(bool trans_a, bool trans_b, int m, int n, int k, T alpha,
+          const T* A, int lda, const T* B, int ldb, T beta, T* C, int ldc,
+          int threads, const gemm_blocking& bs) {
+    constexpr int MR = gemm_shape<T>::MR;
+    constexpr int NR = gemm_shape<T>::NR;
+    if (m <= 0 || n <= 0) return;
+    if (threads <= 1 || m <= MR || k <= 0 || alpha == T(0)) {
+        gemm_for_each_band<T>(m, threads, [&](int i0, int i1) {
+            gemm_rows<T, Acc>(trans_a, trans_b, i0, i1, n, k, alpha, A, lda, B, ldb, beta, C,
+                              ldc, bs);
+        });
+        return;
+    }
+    gemm_blocking shared = bs;
+    shared.kc = std::min(bs.kc, k);
+    shared.nc = std::min(bs.nc, ((n + NR - 1) / NR) * NR);
+    std::vector<T> Bp((size_t)((n + NR - 1) / NR) * NR * k);
+    {
+        TRACE_SCOPE("pack B (shared)");
+        gemm_pack_b_all(B, ldb, trans_b, k, n, shared.kc, shared.nc, Bp.data());
+    }
+    auto prepacked = [&](int jc, int nb, int pc, int, std::vector<T>&) {
+        return gemm_packed_block(Bp.data(), k, jc, nb, pc);
+    };
+    gemm_for_each_band<T>(m, threads, [&](int i0, int i1) {
+        gemm_rows_with<T, Acc>(trans_a, i0, i1, n, k, alpha, A, lda, prepacked, beta, C, ldc,
+                               shared);
+    });
+}
+
+template <typename T, typename Acc = gemm_acc_native>
+void gemm(bool trans_a, bool trans_b, int m, int n, int k, T alpha,
+          const T* A, int lda, const T* B, int ldb, T beta, T* C, int ldc,
+          int threads = 1) {
+    gemm<T, Acc>(trans_a, trans_b, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, threads,
+                 gemm_default_blocking<T>());
+}
@@ -0,0 +1,201 @@
+// Boolean matrices packed 64 entries per word, and their products over
+// the Boolean semiring:
+//
+//     C = A . B       C_ij = OR_p (A_ip AND B_pj)
+//     P = A . B       P_ij = #p with A_ip AND B_pj  (paths of length 2)
+//
+// Rows are padded to whole 256-bit groups, so every row starts on a
+// word boundary and row operations run 256 bits per AVX2 instruction.
+// The OR product walks the set bits of each row of A and ORs the
+// matching rows of B into the row of C, on tiles of kc rows of B by
+// nc words of columns so that the B tile stays in cache; rows of C
+// that are already all ones skip the rest of their tile. The counting
+// product needs B by columns (bit_transpose) and sums popcounts of
+// A_i AND Bt_j (vpopcntq when AVX-512 VPOPCNTDQ is available).
+// bool_closure() computes the transitive closure by repeated squaring,
+// R = R | R . R, with two buffers reused for all rounds. Rows are split
+// over threads.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+struct bit_matrix {
+    int rows = 0, cols = 0;
+    int words = 0;                 // per row, a multiple of 4
+    std::vector<uint64_t> bits;
+
+    bit_matrix() = default;
+    bit_matrix(int rows, int cols)
+        : rows(rows), cols(cols), words((cols + 255) / 256 * 4),
+          bits((size_t)rows * words, 0) {}
+
+    uint64_t* row(int i) { return &bits[(size_t)i * words]; }
+    const uint64_t* row(int i) const { return &bits[(size_t)i * words]; }
+    bool get(int i, int j) const { return row(i)[j >> 6] >> (j & 63) & 1; }
+    void set(int i, int j) { row(i)[j >> 6] |= 1ULL << (j & 63); }
+    size_t count() const {
+        size_t c = 0;
+        for (uint64_t w : bits) c += __builtin_popcountll(w);
+        return c;
+    }
+};
+
+// Nonzeros of a dense row-major matrix as a bit matrix.
+template <typename T>
+bit_matrix bit_from_dense(int rows, int cols, const T* A, int lda) {
+    bit_matrix M(rows, cols);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            if (A[(size_t)i * lda + j] != T(0)) M.set(i, j);
+    return M;
+}
+
+inline bit_matrix bit_transpose(const bit_matrix& A) {
+    bit_matrix T(A.cols, A.rows);
+    for (int i = 0; i < A.rows; ++i) {
+        const uint64_t* a = A.row(i);
+        for (int w = 0; w < A.words; ++w)
+            for (uint64_t x = a[w]; x; x &= x - 1) T.set(w * 64 + __builtin_ctzll(x), i);
+    }
+    return T;
+}
+
+// Split rows [0, rows) evenly and run f(r0, r1) on each part.
+template <typename F>
+void bool_for_each_band(int rows, int threads, F f) {
+    threads = std::max(1, std::min(threads, rows));
+    if (threads == 1) {
+        f(0, rows);
+        return;
+    }
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        int r0 = (int)((long long)rows * t / threads);
+        int r1 = (int)((long long)rows * (t + 1) / threads);
+        pool.emplace_back([=] { f(r0, r1); });
+    }
+    for (auto& th : pool) th.join();
+}
+
+// c[0..n) |= b[0..n), n a multiple of 4; returns whether c now has
+// every bit of 'ones' (the columns that exist) set.
+inline bool bool_or_row(uint64_t* c, const uint64_t* b, const uint64_t* ones, int n) {
+#if defined(__AVX2__)
+    __m256i missing = _mm256_setzero_si256();
+    for (int w = 0; w < n; w += 4) {
+        __m256i v = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(c + w)),
+                                    _mm256_loadu_si256((const __m256i*)(b + w)));
+        _mm256_storeu_si256((__m256i*)(c + w), v);
+        missing = _mm256_or_si256(missing, _mm256_andnot_si256(
+                                               v, _mm256_loadu_si256((const __m256i*)(ones + w))));
+    }
+    return _mm256_testz_si256(missing, missing);
+#else
+    uint64_t missing = 0;
+    for (int w = 0; w < n; ++w) missing |= ones[w] & ~(c[w] |= b[w]);
+    return missing == 0;
+#endif
+}
+
+// Number of set bits in a AND b over n words, n a multiple of 4.
+inline int bool_and_popcount(const uint64_t* a, const uint64_t* b, int n) {
+    int c = 0;
+#if defined(__AVX512VPOPCNTDQ__) && defined(__AVX512VL__)
+    __m256i acc = _mm256_setzero_si256();
+    for (int w = 0; w < n; w += 4)
+        acc = _mm256_add_epi64(acc, _mm256_popcnt_epi64(_mm256_and_si256(
+                                        _mm256_loadu_si256((const __m256i*)(a + w)),
+                                        _mm256_loadu_si256((const __m256i*)(b + w)))));
+    c = (int)(_mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) +
+              _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3));
+#elif defined(__AVX2__)
+    for (int w = 0; w < n; w += 4) {
+        __m256i v = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(a + w)),
+                                     _mm256_loadu_si256((const __m256i*)(b + w)));
+        c += __builtin_popcountll(_mm256_extract_epi64(v, 0)) +
+             __builtin_popcountll(_mm256_extract_epi64(v, 1)) +
+             __builtin_popcountll(_mm256_extract_epi64(v, 2)) +
+             __builtin_popcountll(_mm256_extract_epi64(v, 3));
+    }
+#else
+    for (int w = 0; w < n; ++w) c += __builtin_popcountll(a[w] & b[w]);
+#endif
+    return c;
+}
+
+// Tile of the OR product: BOOL_KC rows of B by BOOL_NC words (4096
+// columns), 512 KiB, which stays in L2 while every row of A in the
+// band uses it. BOOL_KC is a multiple of 64, so tiles start on words.
+constexpr int BOOL_KC = 1024;
+constexpr int BOOL_NC = 64;
+
+// c |= B[p][jw .. jw + nw) for each set bit p of a in words [w0, w1);
+// returns true (and stops) once c is all ones.
+inline bool bool_or_selected(const uint64_t* a, int w0, int w1, const bit_matrix& B, int jw,
+                             int nw, const uint64_t* ones, uint64_t* c) {
+    for (int w = w0; w < w1; ++w)
+        for (uint64_t x = a[w]; x; x &= x - 1)
+            if (bool_or_row(c, B.row(w * 64 + __builtin_ctzll(x)) + jw, ones, nw)) return true;
+    return false;
+}
+
+// C |= A . B (C is not cleared; pass a zeroed C for C = A . B).
+inline void bool_gemm_or(const bit_matrix& A, const bit_matrix& B, bit_matrix& C,
+                         int threads = 1) {
+    std::vector<uint64_t> ones(B.words, 0);
+    for (int j = 0; j < B.cols; ++j) ones[j >> 6] |= 1ULL << (j & 63);
+    bool_for_each_band(A.rows, threads, [&](int r0, int r1) {
+        std::vector<char> full(r1 - r0);
+        for (int jw = 0; jw < B.words; jw += BOOL_NC) {
+            int nw = std::min(BOOL_NC, B.words - jw);
+            std::fill(full.begin(), full.end(), 0);
+            for (int p0 = 0; p0 < A.cols; p0 += BOOL_KC) {
+                int w0 = p0 / 64, w1 = (std::min(A.cols, p0 + BOOL_KC) + 63) / 64;
+                for (int i = r0; i < r1; ++i) {
+                    if (!full[i - r0])
+                        full[i - r0] = bool_or_selected(A.row(i), w0, w1, B, jw, nw, &ones[jw],
+                                                        C.row(i) + jw);
+                }
+            }
+        }
+    });
+}
+
+// P = A . B with B given transposed (Bt = bit_transpose(B)): P_ij is the
+// number of p with A_ip and B_pj. P is row-major with leading dimension
+// ldp.
+inline void bool_gemm_count(const bit_matrix& A, const bit_matrix& Bt, int32_t* P, int ldp,
+                            int threads = 1) {
+    bool_for_each_band(A.rows, threads, [&](int r0, int r1) {
+        for (int i = r0; i < r1; ++i) {
+            const uint64_t* a = A.row(i);
+            int32_t* n = P + (size_t)i * ldp;
+            for (int j = 0; j < Bt.rows; ++j) n[j] = bool_and_popcount(a, Bt.row(j), A.words);
+        }
+    });
+}
+
+// Transitive closure of the square relation R in place: afterwards
+// R_ij is set iff there is a path of length >= 1 from i to j. Each round
+// computes R | R . R, so ceil(log2(n)) rounds suffice; it stops early
+// when a round changes nothing. Returns the number of rounds.
+inline int bool_closure(bit_matrix& R, int threads = 1) {
+    bit_matrix next(R.rows, R.cols);
+    int rounds = 0;
+    for (;;) {
+        ++rounds;
+        next.bits = R.bits;
+        bool_gemm_or(R, R, next, threads);
+        bool changed = next.bits != R.bits;
+        std::swap(R.bits, next.bits);
+        if (!changed) break;
+    }
+    return rounds;
+}
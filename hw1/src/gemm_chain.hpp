@@ -0,0 +1,248 @@
+// Matrix chain products M_0 * M_1 * ... * M_{n-1}, where M_i is
+// dims[i] x dims[i + 1]:
+//
+//     chain_plan plan = chain_optimal_plan(dims, chain_cost_gemm<double>());
+//     gemm_chain(mats, plan, C, ldc, threads);
+//
+// chain_optimal_plan() is the O(n^3) dynamic program over split points;
+// the cost of one product of a p x q by a q x r matrix comes from a cost
+// functor: chain_cost_flops counts 2pqr, chain_cost_gemm<T> estimates
+// the time gemm() takes (work rounded up to whole MR x NR micro-tiles,
+// the bytes it reads and writes, and a fixed cost per call), which
+// favours fewer, squarer products over thin ones with the same flops.
+//
+// gemm_chain() executes a plan. The two halves of each split are
+// independent, so with more than one thread they run concurrently,
+// with the threads shared in proportion to their cost. Intermediate
+// products come from a chain_buffer_pool and go back to it as soon as
+// their parent product has been computed, so later intermediates reuse
+// that memory instead of allocating more.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gemm.hpp"
+
+struct chain_cost_flops {
+    double operator()(int p, int q, int r) const { return 2.0 * p * q * r; }
+};
+
+// Seconds for a p x q by q x r gemm<T>; the defaults are the
+// single-thread double rates of the reference machine.
+template <typename T>
+struct chain_cost_gemm {
+    double flop_rate = 50e9;       // micro-kernel flops per second
+    double bandwidth = 10e9;       // bytes per second for A, B and C
+    double call_overhead = 5e-6;   // seconds per product (packing setup)
+    double operator()(int p, int q, int r) const {
+        constexpr int MR = gemm_shape<T>::MR;
+        constexpr int NR = gemm_shape<T>::NR;
+        double tiles = 2.0 * ((p + MR - 1) / MR * MR) * q * ((r + NR - 1) / NR * NR);
+        double bytes = sizeof(T) * ((double)p * q + (double)q * r + 2.0 * p * r);
+        return tiles / flop_rate + bytes / bandwidth + call_overhead;
+    }
+};
+
+// split[i * n + j] is the k at which M_i..M_j is split into
+// (M_i..M_k)(M_k+1..M_j); cost is the cost-functor total.
+struct chain_plan {
+    int n = 0;
+    std::vector<int> dims;
+    std::vector<int> split;
+    double cost = 0.0;
+
+    int at(int i, int j) const { return split[(size_t)i * n + j]; }
+    // Parenthesization such as "((M0 M1) M2)".
+    std::string str(int i = 0, int j = -1) const {
+        if (n < 1) return "()";
+        if (j < 0) j = n - 1;
+        if (i == j) return "M" + std::to_string(i);
+        return "(" + str(i, at(i, j)) + " " + str(at(i, j) + 1, j) + ")";
+    }
+};
+
+// Cost of the product at (i, j) under 'cost', summed over the plan.
+template <typename Cost>
+double chain_plan_cost(const chain_plan& plan, Cost cost, int i = 0, int j = -1) {
+    if (plan.n < 1) return 0.0;
+    if (j < 0) j = plan.n - 1;
+    if (i == j) return 0.0;
+    int k = plan.at(i, j);
+    return chain_plan_cost(plan, cost, i, k) + chain_plan_cost(plan, cost, k + 1, j) +
+           cost(plan.dims[i], plan.dims[k + 1], plan.dims[j + 1]);
+}
+
+template <typename Cost>
+chain_plan chain_optimal_plan(const std::vector<int>& dims, Cost cost) {
+    chain_plan plan;
+    plan.n = (int)dims.size() - 1;
+    plan.dims = dims;
+    int n = plan.n;
+    plan.split.assign((size_t)n * n, 0);
+    std::vector<double> best((size_t)n * n, 0.0);
+    for (int len = 2; len <= n; ++len)
+        for (int i = 0; i + len - 1 < n; ++i) {
+            int j = i + len - 1;
+            double b = HUGE_VAL;
+            for (int k = i; k < j; ++k) {
+                double c = best[(size_t)i * n + k] + best[(size_t)(k + 1) * n + j] +
+                           cost(dims[i], dims[k + 1], dims[j + 1]);
+                if (c < b) {
+                    b = c;
+                    plan.split[(size_t)i * n + j] = k;
+                }
+            }
+            best[(size_t)i * n + j] = b;
+        }
+    plan.cost = n > 0 ? best[n - 1] : 0.0;
+    return plan;
+}
+
+// ((M0 M1) M2) ..., for comparison.
+inline chain_plan chain_left_to_right(const std::vector<int>& dims) {
+    chain_plan plan;
+    plan.n = (int)dims.size() - 1;
+    plan.dims = dims;
+    plan.split.assign((size_t)plan.n * plan.n, 0);
+    for (int i = 0; i < plan.n; ++i)
+        for (int j = i + 1; j < plan.n; ++j) plan.split[(size_t)i * plan.n + j] = j - 1;
+    plan.cost = chain_plan_cost(plan, chain_cost_flops());
+    return plan;
+}
+
+// Free list of intermediate buffers, shared by the threads of one
+// chain. acquire() hands out the smallest free buffer that is large
+// enough (or a new one); live / peak count the elements handed out.
+template <typename T>
+class chain_buffer_pool {
+public:
+    std::vector<T> acquire(size_t count) {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto best = free_.end();
+        for (auto it = free_.begin(); it != free_.end(); ++it)
+            if (it->capacity() >= count && (best == free_.end() || it->capacity() < best->capacity()))
+                best = it;
+        std::vector<T> buf;
+        if (best != free_.end()) {
+            buf = std::move(*best);
+            free_.erase(best);
+        } else {
+            ++allocations_;
+        }
+        buf.resize(count);
+        live_ += buf.capacity();
+        peak_ = std::max(peak_, live_);
+        return buf;
+    }
+    void release(std::vector<T>&& buf) {
+        if (buf.capacity() == 0) return;
+        std::lock_guard<std::mutex> lock(mu_);
+        live_ -= buf.capacity();
+        free_.push_back(std::move(buf));
+    }
+    size_t peak_elements() const { return peak_; }
+    int allocations() const { return allocations_; }
+
+private:
+    std::mutex mu_;
+    std::vector<std::vector<T>> free_;
+    size_t live_ = 0, peak_ = 0;
+    int allocations_ = 0;
+};
+
+// One operand of the chain: rows x cols, row-major with leading
+// dimension ld.
+template <typename T>
+struct chain_matrix {
+    int rows, cols;
+    const T* data;
+    int ld;
+};
+
+// Value of a sub-chain: an input operand, or an intermediate owning
+// its pool buffer.
+template <typename T>
+struct chain_value {
+    const T* data = nullptr;
+    int ld = 0;
+    std::vector<T> buf;
+};
+
+template <typename T, typename Cost>
+chain_value<T> chain_execute(const std::vector<chain_matrix<T>>& mats, const chain_plan& plan,
+                             Cost cost, int i, int j, T* out, int ldo, int threads,
+                             chain_buffer_pool<T>& pool) {
+    chain_value<T> v;
+    if (i == j) {
+        v.data = mats[i].data;
+        v.ld = mats[i].ld;
+        return v;
+    }
+    int k = plan.at(i, j);
+    chain_value<T> left, right;
+    double cl = chain_plan_cost(plan, cost, i, k), cr = chain_plan_cost(plan, cost, k + 1, j);
+    if (threads > 1 && cl > 0.0 && cr > 0.0) {
+        int tl = std::max(1, std::min(threads - 1, (int)std::lround(threads * cl / (cl + cr))));
+        std::thread t([&] {
+            left = chain_execute(mats, plan, cost, i, k, (T*)nullptr, 0, tl, pool);
+        });
+        right = chain_execute(mats, plan, cost, k + 1, j, (T*)nullptr, 0, threads - tl, pool);
+        t.join();
+    } else {
+        left = chain_execute(mats, plan, cost, i, k, (T*)nullptr, 0, threads, pool);
+        right = chain_execute(mats, plan, cost, k + 1, j, (T*)nullptr, 0, threads, pool);
+    }
+    int p = plan.dims[i], q = plan.dims[k + 1], r = plan.dims[j + 1];
+    if (out) {
+        v.data = out;
+        v.ld = ldo;
+    } else {
+        v.buf = pool.acquire((size_t)p * r);
+        v.data = v.buf.data();
+        v.ld = r;
+    }
+    gemm(false, false, p, r, q, T(1), left.data, left.ld, right.data, right.ld, T(0),
+         const_cast<T*>(v.data), v.ld, threads);
+    pool.release(std::move(left.buf));
+    pool.release(std::move(right.buf));
+    return v;
+}
+
+struct chain_stats {
+    size_t peak_elements = 0;   // intermediate elements held at once
+    int allocations = 0;        // intermediate buffers allocated
+};
+
+// C = M_0 * ... * M_{n-1} following 'plan' (C is dims[0] x dims[n]).
+// 'cost' only guides how threads are shared between the halves of each
+// split; pass the functor the plan was built with. An empty chain, or
+// one whose matrices do not match the plan's dims (or whose ld is below
+// cols, or ldc below dims[n]), has no product: C is left untouched.
+template <typename T, typename Cost = chain_cost_flops>
+chain_stats gemm_chain(const std::vector<chain_matrix<T>>& mats, const chain_plan& plan, T* C,
+                       int ldc, int threads = 1, Cost cost = Cost()) {
+    chain_buffer_pool<T> pool;
+    chain_stats stats;
+    if (plan.n < 1 || (int)mats.size() != plan.n || (int)plan.dims.size() != plan.n + 1 ||
+        ldc < plan.dims[plan.n])
+        return stats;
+    for (int i = 0; i < plan.n; ++i)
+        if (!mats[i].data || mats[i].rows != plan.dims[i] || mats[i].cols != plan.dims[i + 1] ||
+            mats[i].ld < mats[i].cols)
+            return stats;
+    if (plan.n == 1) {
+        for (int i = 0; i < mats[0].rows; ++i)
+            std::copy(mats[0].data + (size_t)i * mats[0].ld,
+                      mats[0].data + (size_t)i * mats[0].ld + mats[0].cols, C + (size_t)i * ldc);
+        return stats;
+    }
+    chain_execute(mats, plan, cost, 0, plan.n - 1, C, ldc, threads, pool);
+    stats.peak_elements = pool.peak_elements();
+    stats.allocations = pool.allocations();
+    return stats;
+}
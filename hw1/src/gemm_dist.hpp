@@ -0,0 +1,184 @@
+// Distributed C = A * B over P = q x q ranks (dist_transport.hpp). Rank
+// r sits at (r / q, r % q) of the grid and owns the b x b blocks
+// A_ij, B_ij and C_ij, b = n / q. Both algorithms run q steps of
+// C_ij += A' * B' with one gemm() per step; they differ in where the
+// blocks A' and B' come from:
+//
+//   SUMMA   step s: rank (i, s) broadcasts A_is along row i and rank
+//           (s, j) broadcasts B_sj down column j
+//   Cannon  after an initial skew (A_ij to column j - i, B_ij to row
+//           i - j), each step shifts A one rank left and B one rank up
+//
+// Blocks are double-buffered: a communication thread fetches the blocks
+// of step s + 1 into one pair of buffers while the compute thread works
+// on step s in the other (with overlap off, fetch and compute
+// alternate). dist_stats separates the time spent computing, the time
+// the communication thread spent fetching, and the part of it the
+// compute thread actually waited for.
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "dist_transport.hpp"
+#include "gemm.hpp"
+
+struct dist_grid {
+    int q, row, col;
+    dist_grid(int q, int rank) : q(q), row(rank / q), col(rank % q) {}
+    int rank_at(int r, int c) const { return ((r % q + q) % q) * q + (c % q + q) % q; }
+};
+
+struct dist_stats {
+    double compute = 0.0;   // in gemm()
+    double comm = 0.0;      // fetching blocks (communication thread)
+    double wait = 0.0;      // compute thread blocked on communication
+    double total = 0.0;
+};
+
+inline double dist_now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Run fetch(s) then compute(s) for s = 0 .. steps - 1. With overlap,
+// fetch(s + 1) runs on a second thread during compute(s); fetch(s)
+// writes the buffers compute(s - 2) read, so it waits for that first.
+template <typename Fetch, typename Compute>
+void dist_run_steps(int steps, bool overlap, Fetch fetch, Compute compute, dist_stats& st) {
+    double start = dist_now();
+    if (!overlap) {
+        for (int s = 0; s < steps; ++s) {
+            double t0 = dist_now();
+            fetch(s);
+            double t1 = dist_now();
+            compute(s);
+            st.comm += t1 - t0;
+            st.wait += t1 - t0;
+            st.compute += dist_now() - t1;
+        }
+        st.total = dist_now() - start;
+        return;
+    }
+    std::mutex mu;
+    std::condition_variable cv;
+    int fetched = -1, computed = -1;
+    std::thread comm([&] {
+        for (int s = 0; s < steps; ++s) {
+            {
+                std::unique_lock<std::mutex> lock(mu);
+                cv.wait(lock, [&] { return computed >= s - 2; });
+            }
+            double t0 = dist_now();
+            fetch(s);
+            st.comm += dist_now() - t0;
+            {
+                std::lock_guard<std::mutex> lock(mu);
+                fetched = s;
+            }
+            cv.notify_all();
+        }
+    });
+    for (int s = 0; s < steps; ++s) {
+        double t0 = dist_now();
+        {
+            std::unique_lock<std::mutex> lock(mu);
+            cv.wait(lock, [&] { return fetched >= s; });
+        }
+        double t1 = dist_now();
+        compute(s);
+        st.wait += t1 - t0;
+        st.compute += dist_now() - t1;
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            computed = s;
+        }
+        cv.notify_all();
+    }
+    comm.join();
+    st.total = dist_now() - start;
+}
+
+// C_ij += A_i* B_*j on this rank; A, B and C are its b x b blocks
+// (leading dimension b).
+template <typename T>
+dist_stats dist_summa(dist_transport& tr, int q, int b, const T* A, const T* B, T* C,
+                      bool overlap, int threads = 1) {
+    dist_grid g(q, tr.rank);
+    size_t bytes = sizeof(T) * b * b;
+    std::vector<T> bufA[2], bufB[2];
+    const T* a[2];
+    const T* bb[2];
+    auto fetch = [&](int s) {
+        int slot = s % 2;
+        if (g.col == s) {
+            a[slot] = A;
+            for (int c = 0; c < q; ++c)
+                if (c != s) tr.send(g.rank_at(g.row, c), A, bytes);
+        } else {
+            bufA[slot].resize((size_t)b * b);
+            tr.recv(g.rank_at(g.row, s), bufA[slot].data(), bytes);
+            a[slot] = bufA[slot].data();
+        }
+        if (g.row == s) {
+            bb[slot] = B;
+            for (int r = 0; r < q; ++r)
+                if (r != s) tr.send(g.rank_at(r, g.col), B, bytes);
+        } else {
+            bufB[slot].resize((size_t)b * b);
+            tr.recv(g.rank_at(s, g.col), bufB[slot].data(), bytes);
+            bb[slot] = bufB[slot].data();
+        }
+    };
+    auto compute = [&](int s) {
+        gemm(false, false, b, b, b, T(1), a[s % 2], b, bb[s % 2], b, T(1), C, b, threads);
+    };
+    dist_stats st;
+    dist_run_steps(q, overlap, fetch, compute, st);
+    return st;
+}
+
+template <typename T>
+dist_stats dist_cannon(dist_transport& tr, int q, int b, const T* A, const T* B, T* C,
+                       bool overlap, int threads = 1) {
+    dist_grid g(q, tr.rank);
+    size_t bytes = sizeof(T) * b * b;
+    std::vector<T> bufA[2], bufB[2];
+    const T* a[2];
+    const T* bb[2];
+    // Send 'from' to rank 'dst', receive the replacement from 'src' into
+    // slot 'slot' (a shift of zero keeps the block in place).
+    auto shift = [&](const T* from, int dst, int src, std::vector<T>* buf, const T** cur,
+                     int slot) {
+        if (dst == tr.rank) {
+            cur[slot] = from;
+            return;
+        }
+        tr.send(dst, from, bytes);
+        buf[slot].resize((size_t)b * b);
+        tr.recv(src, buf[slot].data(), bytes);
+        cur[slot] = buf[slot].data();
+    };
+    auto fetch = [&](int s) {
+        int slot = s % 2;
+        if (s == 0) {
+            shift(A, g.rank_at(g.row, g.col - g.row), g.rank_at(g.row, g.col + g.row), bufA, a, 0);
+            shift(B, g.rank_at(g.row - g.col, g.col), g.rank_at(g.row + g.col, g.col), bufB, bb, 0);
+        } else {
+            shift(a[1 - slot], g.rank_at(g.row, g.col - 1), g.rank_at(g.row, g.col + 1), bufA, a,
+                  slot);
+            shift(bb[1 - slot], g.rank_at(g.row - 1, g.col), g.rank_at(g.row + 1, g.col), bufB, bb,
+                  slot);
+        }
+    };
+    auto compute = [&](int s) {
+        gemm(false, false, b, b, b, T(1), a[s % 2], b, bb[s % 2], b, T(1), C, b, threads);
+    };
+    dist_stats st;
+    dist_run_steps(q, overlap, fetch, compute, st);
+    return st;
+}
@@ -0,0 +1,162 @@
+// Pre-packed B for repeated multiplies with the same right-hand side:
+//
+//     gemm_packed_b<float> W = gemm_pack_b_matrix(false, k, n, B, ldb);
+//     for (each A) gemm_packed(false, m, 1.0f, A, lda, W, 0.0f, C, ldc);
+//
+// B is packed once into exactly the kc x nc block / NR-panel layout that
+// gemm() builds on every call, so gemm_packed() only packs A. The handle
+// carries a 64-bit content hash of op(B) (FNV-1a over the values), used
+// to key the optional on-disk cache: gemm_packed_load_or_pack() reads
+// <dir>/<hash>.gpk when it exists and was packed with the same kernel
+// shape and blocking, and packs and writes it otherwise.
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gemm.hpp"
+
+template <typename T>
+struct gemm_packed_b {
+    int k = 0, n = 0;        // op(B) is k x n
+    gemm_blocking bs{};      // blocking the panels were packed with
+    uint64_t hash = 0;       // content hash of op(B)
+    std::vector<T> data;     // (jc, pc) blocks, each in NR-column panels
+
+    // Start of the kb x nb block at row pc, column jc.
+    const T* block(int jc, int nb, int pc) const {
+        return gemm_packed_block(data.data(), k, jc, nb, pc);
+    }
+};
+
+// FNV-1a over the values of op(B), row by row, plus the shape.
+template <typename T>
+uint64_t gemm_hash_b(bool trans_b, int k, int n, const T* B, int ldb) {
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](const void* p, size_t len) {
+        const unsigned char* c = (const unsigned char*)p;
+        for (size_t i = 0; i < len; ++i) h = (h ^ c[i]) * 1099511628211ull;
+    };
+    mix(&k, sizeof(k));
+    mix(&n, sizeof(n));
+    if (!trans_b) {
+        for (int p = 0; p < k; ++p) mix(B + (size_t)p * ldb, sizeof(T) * n);
+    } else {
+        for (int p = 0; p < k; ++p)
+            for (int j = 0; j < n; ++j) {
+                T v = B[(size_t)j * ldb + p];
+                mix(&v, sizeof(T));
+            }
+    }
+    return h;
+}
+
+template <typename T>
+gemm_packed_b<T> gemm_pack_b_matrix(bool trans_b, int k, int n, const T* B, int ldb) {
+    constexpr int NR = gemm_shape<T>::NR;
+    gemm_packed_b<T> P;
+    P.k = k;
+    P.n = n;
+    P.bs = gemm_default_blocking<T>();
+    P.hash = gemm_hash_b(trans_b, k, n, B, ldb);
+    int kc = std::min(P.bs.kc, std::max(k, 1));
+    int nc = std::min(P.bs.nc, ((n + NR - 1) / NR) * NR);
+    P.bs.kc = kc;
+    P.bs.nc = nc;
+    P.data.resize((size_t)((n + NR - 1) / NR) * NR * k);
+    gemm_pack_b_all(B, ldb, trans_b, k, n, kc, nc, P.data.data());
+    return P;
+}
+
+// C = alpha * op(A) * B + beta * C with B pre-packed; op(A) is m x B.k.
+template <typename T>
+void gemm_packed(bool trans_a, int m, T alpha, const T* A, int lda,
+                 const gemm_packed_b<T>& B, T beta, T* C, int ldc, int threads = 1) {
+    if (m <= 0 || B.n <= 0) return;
+    gemm_blocking bs = gemm_default_blocking<T>();
+    bs.kc = B.bs.kc;
+    bs.nc = B.bs.nc;
+    auto prepacked = [&B](int jc, int nb, int pc, int, std::vector<T>&) {
+        return B.block(jc, nb, pc);
+    };
+    gemm_for_each_band<T>(m, threads, [&](int i0, int i1) {
+        gemm_rows_with(trans_a, i0, i1, B.n, B.k, alpha, A, lda, prepacked, beta, C, ldc, bs);
+    });
+}
+
+// On-disk form: a header identifying the element size, kernel shape and
+// blocking (a file packed for another micro-kernel is rejected), then
+// the panel data.
+struct gemm_packed_header {
+    char magic[4];           // "GPKB"
+    int32_t version, elem_size, mr, nr, k, n, kc, nc;
+    uint64_t hash;
+};
+
+template <typename T>
+bool gemm_packed_save(const gemm_packed_b<T>& P, const std::string& path) {
+    gemm_packed_header h = {{'G', 'P', 'K', 'B'}, 1, (int32_t)sizeof(T),
+                            gemm_shape<T>::MR, gemm_shape<T>::NR, P.k, P.n,
+                            P.bs.kc, P.bs.nc, P.hash};
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+              fwrite(P.data.data(), sizeof(T), P.data.size(), f) == P.data.size();
+    return fclose(f) == 0 && ok;
+}
+
+// Load a packed B; fails (returns false) if the file is missing, was
+// packed for a different shape / blocking, or its hash is not
+// 'expected_hash' (0 accepts any).
+template <typename T>
+bool gemm_packed_load(gemm_packed_b<T>& P, const std::string& path, uint64_t expected_hash = 0) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    gemm_packed_header h;
+    bool ok = fread(&h, sizeof(h), 1, f) == 1 && memcmp(h.magic, "GPKB", 4) == 0 &&
+              h.version == 1 && h.elem_size == (int32_t)sizeof(T) &&
+              h.mr == gemm_shape<T>::MR && h.nr == gemm_shape<T>::NR &&
+              (expected_hash == 0 || h.hash == expected_hash);
+    if (ok) {
+        // Only blockings gemm_pack_b_matrix would produce here are valid.
+        gemm_blocking bs = gemm_default_blocking<T>();
+        constexpr int NR = gemm_shape<T>::NR;
+        ok = h.kc == std::min(bs.kc, std::max(h.k, 1)) &&
+             h.nc == std::min(bs.nc, ((h.n + NR - 1) / NR) * NR);
+    }
+    if (ok) {
+        P.k = h.k;
+        P.n = h.n;
+        P.bs = gemm_default_blocking<T>();
+        P.bs.kc = h.kc;
+        P.bs.nc = h.nc;
+        P.hash = h.hash;
+        P.data.resize((size_t)((h.n + gemm_shape<T>::NR - 1) / gemm_shape<T>::NR) *
+                      gemm_shape<T>::NR * h.k);
+        ok = fread(P.data.data(), sizeof(T), P.data.size(), f) == P.data.size();
+    }
+    fclose(f);
+    return ok;
+}
+
+// Packed B from <dir>/<hash>.gpk if present and compatible, otherwise
+// packed now and written there. *loaded tells which happened.
+template <typename T>
+gemm_packed_b<T> gemm_packed_load_or_pack(const std::string& dir, bool trans_b, int k, int n,
+                                          const T* B, int ldb, bool* loaded = nullptr) {
+    uint64_t hash = gemm_hash_b(trans_b, k, n, B, ldb);
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.gpk", (unsigned long long)hash);
+    std::string path = dir + name;
+    gemm_packed_b<T> P;
+    bool hit = gemm_packed_load(P, path, hash);
+    if (!hit) {
+        P = gemm_pack_b_matrix(trans_b, k, n, B, ldb);
+        gemm_packed_save(P, path);
+    }
+    if (loaded) *loaded = hit;
+    return P;
+}
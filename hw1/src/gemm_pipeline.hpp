@@ -0,0 +1,115 @@
+// gemm() with B packed ahead of use by a helper thread:
+//
+//     gemm_pipeline_stats st = gemm_pipelined(false, false, m, n, k, 1.0, A, lda,
+//                                             B, ldb, 0.0, C, ldc, threads);
+//
+// The engine multiplies B in kc x nc blocks, visited in the same (jc,
+// pc) order by every compute thread. Here one packer thread packs
+// block s + 1 into the second of two buffers while the compute threads
+// run on block s, and all compute threads share the packed copy.
+// gemm() packs each block inline on one thread, and with several
+// threads packs all of op(B) up front before any of them computes; here
+// packing overlaps compute and needs two block buffers instead of a
+// packed copy of B. The handoff is lock-free: the packer publishes s in 'started'
+// and 'ready' when it starts and finishes packing block s, each compute
+// thread publishes in its own 'consumed' slot the last block it has
+// finished, and the packer reuses a buffer once every thread is past
+// the block it held. Waiting sides spin with yield.
+//
+// A is still packed by the compute threads, one mc x kc block at a
+// time: it is private to each thread's band of rows and small next to
+// a B block. gemm_pipeline_stats reports the time the packer spent
+// packing and the time the compute threads waited for a block while it
+// was being packed; the difference is the packing time hidden behind
+// compute. Waiting for a slower band to free a buffer (before packing
+// starts) is load imbalance, not exposed packing, and is not counted.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "gemm.hpp"
+
+struct gemm_pipeline_stats {
+    double pack = 0.0;   // packer busy packing B
+    double wait = 0.0;   // longest total wait of a compute thread on packing
+    int blocks = 0;      // B blocks packed
+    double hidden() const { return std::max(0.0, pack - wait); }
+};
+
+// packer_cpu >= 0 pins the packer thread there (e.g. the SMT sibling of
+// a compute thread's core).
+template <typename T>
+gemm_pipeline_stats gemm_pipelined(bool trans_a, bool trans_b, int m, int n, int k, T alpha,
+                                   const T* A, int lda, const T* B, int ldb, T beta, T* C,
+                                   int ldc, int threads = 1, int packer_cpu = -1) {
+    constexpr int MR = gemm_shape<T>::MR;
+    constexpr int NR = gemm_shape<T>::NR;
+    gemm_pipeline_stats st;
+    if (m <= 0 || n <= 0) return st;
+    if (k == 0 || alpha == T(0)) {
+        gemm(trans_a, trans_b, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, threads);
+        return st;
+    }
+    using clock = std::chrono::steady_clock;
+    gemm_blocking bs = gemm_default_blocking<T>();
+    bs.kc = std::min(bs.kc, k);
+    bs.nc = std::min(bs.nc, ((n + NR - 1) / NR) * NR);
+    const int kc = bs.kc, nc = bs.nc;
+    const int blocks = ((n + nc - 1) / nc) * ((k + kc - 1) / kc);
+    const int bands = std::max(1, std::min(threads, (m + MR - 1) / MR));
+
+    std::vector<T> slot[2];
+    for (auto& s : slot) s.resize((size_t)nc * kc);
+    struct alignas(64) counter {
+        std::atomic<int> v{-1};
+    };
+    counter started, ready;
+    std::vector<counter> consumed(bands);
+    std::atomic<int> next_band{0};
+    std::vector<double> wait(bands, 0.0);
+
+    std::thread packer([&] {
+        if (packer_cpu >= 0) topo_pin_thread(packer_cpu);
+        int s = 0;
+        for (int jc = 0; jc < n; jc += nc) {
+            int nb = std::min(nc, n - jc);
+            for (int pc = 0; pc < k; pc += kc, ++s) {
+                int kb = std::min(kc, k - pc);
+                // slot[s % 2] last held block s - 2.
+                for (int t = 0; t < bands; ++t)
+                    while (consumed[t].v.load(std::memory_order_acquire) < s - 2)
+                        std::this_thread::yield();
+                started.v.store(s, std::memory_order_release);
+                auto t0 = clock::now();
+                gemm_pack_b(B, ldb, trans_b, pc, kb, jc, nb, slot[s % 2].data());
+                st.pack += std::chrono::duration<double>(clock::now() - t0).count();
+                ready.v.store(s, std::memory_order_release);
+            }
+        }
+    });
+
+    gemm_for_each_band<T>(m, bands, [&](int i0, int i1) {
+        int id = next_band++;
+        int s = 0;
+        auto handoff = [&](int, int, int, int, std::vector<T>&) {
+            consumed[id].v.store(s - 1, std::memory_order_release);
+            if (ready.v.load(std::memory_order_acquire) < s) {
+                while (started.v.load(std::memory_order_acquire) < s) std::this_thread::yield();
+                auto t0 = clock::now();
+                while (ready.v.load(std::memory_order_acquire) < s) std::this_thread::yield();
+                wait[id] += std::chrono::duration<double>(clock::now() - t0).count();
+            }
+            return (const T*)slot[s++ % 2].data();
+        };
+        gemm_rows_with(trans_a, i0, i1, n, k, alpha, A, lda, handoff, beta, C, ldc, bs);
+        consumed[id].v.store(blocks, std::memory_order_release);
+    });
+    packer.join();
+    for (double w : wait) st.wait = std::max(st.wait, w);
+    st.blocks = blocks;
+    return st;
+}
@@ -0,0 +1,327 @@
+// Quantized integer GEMM: C = A * B for int8 or int16 A and B with
+// int32 C (row-major, leading dimensions, no transposes):
+//
+//     qgemm(m, n, k, A, lda, B, ldb, C, ldc, threads);
+//
+// Consecutive elements along K are packed into 32-bit words (four int8
+// or two int16), so one instruction multiplies and sums a whole word:
+//
+//   int8, AVX512-VNNI   vpdpbusd (u8 x s8, 4 products -> int32). A is
+//                       stored shifted by +128 to make it unsigned, and
+//                       128 * colsum(B) is subtracted afterwards.
+//   int16, or int8      vpmaddwd (s16 x s16, 2 products -> int32) on
+//   without VNNI        512-bit vectors with AVX-512BW, 256-bit with
+//                       AVX2; int8 operands are widened to int16 while
+//                       packing.
+//   neither             the same packed layout in plain C++.
+//
+// pmaddubsw is not used: it sums its u8 x s8 pairs into a saturating
+// int16, which overflows for full-range int8 (2 * 255 * 127 > 32767).
+//
+// The int32 accumulators do not overflow: K is split into blocks of at
+// most INT32_MAX / (max|word sum|) words, derived from the largest
+// magnitudes actually present in A and B. When K needs more than one
+// block, the block sums are added in int64; the final value is
+// saturated to int32. A single int16 word can exceed int32 only when
+// both operands hold -32768 (2 * 32768^2 = 2^31, which vpmaddwd wraps);
+// that case, which qgemm_quantize never produces, is computed with
+// int64 products instead (qgemm_rows_wide).
+// The register tile is gemm_shape<int32_t> (6 x 48, three 16-lane
+// vectors per row with AVX-512; 6 x 16 with AVX2) and rows are split
+// over threads as in gemm().
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX512BW__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "gemm.hpp"
+
+enum qgemm_mode { QGEMM_U8S8, QGEMM_S16 };
+
+// Word format used for element type T on this build.
+template <typename T>
+constexpr qgemm_mode qgemm_mode_for() {
+    static_assert(std::is_same<T, int8_t>::value || std::is_same<T, int16_t>::value,
+                  "qgemm supports int8_t and int16_t");
+#if defined(__AVX512VNNI__) && defined(__AVX512BW__)
+    return std::is_same<T, int8_t>::value ? QGEMM_U8S8 : QGEMM_S16;
+#else
+    return QGEMM_S16;
+#endif
+}
+
+// Elements of K per 32-bit word.
+constexpr int qgemm_group(qgemm_mode mode) { return mode == QGEMM_U8S8 ? 4 : 2; }
+
+// Pack KG consecutive values into a word; 'shift' is added to each
+// (128 for the unsigned A operand of vpdpbusd). Missing values (past
+// K) are zero in both operands.
+template <qgemm_mode MODE>
+inline int32_t qgemm_word(const int* v, int count, int shift) {
+    uint32_t w = 0;
+    if (MODE == QGEMM_U8S8) {
+        for (int e = 0; e < count; ++e) w |= (uint32_t)(uint8_t)(v[e] + shift) << (8 * e);
+    } else {
+        for (int e = 0; e < count; ++e) w |= (uint32_t)(uint16_t)v[e] << (16 * e);
+    }
+    return (int32_t)w;
+}
+
+// Sum of the products of one A word and one B word. The caller only
+// uses it when the sum fits int32 (qgemm_safe_groups > 0).
+template <qgemm_mode MODE>
+inline int32_t qgemm_dot_word(int32_t a, int32_t b) {
+    int64_t s = 0;
+    if (MODE == QGEMM_U8S8) {
+        for (int e = 0; e < 4; ++e)
+            s += (int32_t)(uint8_t)(a >> (8 * e)) * (int32_t)(int8_t)(b >> (8 * e));
+    } else {
+        for (int e = 0; e < 2; ++e)
+            s += (int32_t)(int16_t)(a >> (16 * e)) * (int32_t)(int16_t)(b >> (16 * e));
+    }
+    return (int32_t)s;
+}
+
+// Rows [i0, i0 + mb) of A as MR-row panels of words:
+// panel r holds Aw[(r * groups + g) * MR + i].
+template <qgemm_mode MODE, typename T>
+void qgemm_pack_a(const T* A, int lda, int i0, int mb, int k, int32_t* Aw) {
+    constexpr int MR = gemm_shape<int32_t>::MR, KG = qgemm_group(MODE);
+    const int shift = MODE == QGEMM_U8S8 ? 128 : 0;
+    int groups = (k + KG - 1) / KG;
+    int v[KG];
+    for (int ir = 0; ir < mb; ir += MR) {
+        for (int g = 0; g < groups; ++g) {
+            int count = std::min(KG, k - g * KG);
+            for (int i = 0; i < MR; ++i) {
+                if (ir + i < mb) {
+                    const T* a = A + (size_t)(i0 + ir + i) * lda + g * KG;
+                    for (int e = 0; e < count; ++e) v[e] = a[e];
+                    Aw[g * MR + i] = qgemm_word<MODE>(v, count, shift);
+                } else {
+                    Aw[g * MR + i] = 0;
+                }
+            }
+        }
+        Aw += (size_t)groups * MR;
+    }
+}
+
+// All of B as NR-column panels of words:
+// panel c holds Bw[(c * groups + g) * NR + j], zero padded.
+template <qgemm_mode MODE, typename T>
+void qgemm_pack_b(const T* B, int ldb, int k, int n, int32_t* Bw) {
+    constexpr int NR = gemm_shape<int32_t>::NR, KG = qgemm_group(MODE);
+    int groups = (k + KG - 1) / KG;
+    int v[KG];
+    for (int jr = 0; jr < n; jr += NR) {
+        for (int g = 0; g < groups; ++g) {
+            int count = std::min(KG, k - g * KG);
+            for (int j = 0; j < NR; ++j) {
+                if (jr + j < n) {
+                    for (int e = 0; e < count; ++e) v[e] = B[(size_t)(g * KG + e) * ldb + jr + j];
+                    Bw[g * NR + j] = qgemm_word<MODE>(v, count, 0);
+                } else {
+                    Bw[g * NR + j] = 0;
+                }
+            }
+        }
+        Bw += (size_t)groups * NR;
+    }
+}
+
+// acc = sum over words [g0, g1) of one A and one B panel.
+template <qgemm_mode MODE>
+inline void qgemm_micro_kernel(int g0, int g1, const int32_t* Aw, const int32_t* Bw,
+                               int32_t* acc) {
+    constexpr int MR = gemm_shape<int32_t>::MR, NR = gemm_shape<int32_t>::NR;
+#if defined(__AVX512BW__)
+    static_assert(NR == 48, "the AVX-512 kernel holds a row in three vectors");
+    __m512i c[MR][3];
+    for (int i = 0; i < MR; ++i)
+        for (int v = 0; v < 3; ++v) c[i][v] = _mm512_setzero_si512();
+    for (int g = g0; g < g1; ++g) {
+        const int32_t* b = Bw + (size_t)g * NR;
+        __m512i b0 = _mm512_loadu_si512(b), b1 = _mm512_loadu_si512(b + 16),
+                b2 = _mm512_loadu_si512(b + 32);
+        for (int i = 0; i < MR; ++i) {
+            __m512i a = _mm512_set1_epi32(Aw[(size_t)g * MR + i]);
+#if defined(__AVX512VNNI__)
+            if (MODE == QGEMM_U8S8) {
+                c[i][0] = _mm512_dpbusd_epi32(c[i][0], a, b0);
+                c[i][1] = _mm512_dpbusd_epi32(c[i][1], a, b1);
+                c[i][2] = _mm512_dpbusd_epi32(c[i][2], a, b2);
+                continue;
+            }
+#endif
+            c[i][0] = _mm512_add_epi32(c[i][0], _mm512_madd_epi16(a, b0));
+            c[i][1] = _mm512_add_epi32(c[i][1], _mm512_madd_epi16(a, b1));
+            c[i][2] = _mm512_add_epi32(c[i][2], _mm512_madd_epi16(a, b2));
+        }
+    }
+    for (int i = 0; i < MR; ++i)
+        for (int v = 0; v < 3; ++v) _mm512_storeu_si512(acc + i * NR + v * 16, c[i][v]);
+#elif defined(__AVX2__)
+    static_assert(NR == 16, "the AVX2 kernel holds a row in two vectors");
+    static_assert(MODE == QGEMM_S16, "u8 x s8 words need AVX512-VNNI");
+    __m256i c0[MR], c1[MR];
+    for (int i = 0; i < MR; ++i) c0[i] = c1[i] = _mm256_setzero_si256();
+    for (int g = g0; g < g1; ++g) {
+        const int32_t* b = Bw + (size_t)g * NR;
+        __m256i b0 = _mm256_loadu_si256((const __m256i*)b),
+                b1 = _mm256_loadu_si256((const __m256i*)(b + 8));
+        for (int i = 0; i < MR; ++i) {
+            __m256i a = _mm256_set1_epi32(Aw[(size_t)g * MR + i]);
+            c0[i] = _mm256_add_epi32(c0[i], _mm256_madd_epi16(a, b0));
+            c1[i] = _mm256_add_epi32(c1[i], _mm256_madd_epi16(a, b1));
+        }
+    }
+    for (int i = 0; i < MR; ++i) {
+        _mm256_storeu_si256((__m256i*)(acc + i * NR), c0[i]);
+        _mm256_storeu_si256((__m256i*)(acc + i * NR + 8), c1[i]);
+    }
+#else
+    for (int i = 0; i < MR * NR; ++i) acc[i] = 0;
+    for (int g = g0; g < g1; ++g) {
+        const int32_t* b = Bw + (size_t)g * NR;
+        for (int i = 0; i < MR; ++i) {
+            int32_t a = Aw[(size_t)g * MR + i];
+            for (int j = 0; j < NR; ++j) acc[i * NR + j] += qgemm_dot_word<MODE>(a, b[j]);
+        }
+    }
+#endif
+}
+
+// Words per K block such that no int32 accumulator can overflow, given
+// the largest |value| in A (after the shift) and in B; 0 if one word
+// alone can exceed int32.
+inline int qgemm_safe_groups(qgemm_mode mode, long long max_a, long long max_b) {
+    long long per_word = (long long)qgemm_group(mode) * max_a * max_b;
+    if (per_word == 0) return INT_MAX;
+    return (int)std::min((long long)INT_MAX, (long long)INT32_MAX / per_word);
+}
+
+// Rows [i0, i1) of C with int64 products and sums, saturated to int32.
+template <typename T>
+void qgemm_rows_wide(int i0, int i1, int n, int k, const T* A, int lda, const T* B, int ldb,
+                     int32_t* C, int ldc) {
+    std::vector<long long> row(n);
+    for (int i = i0; i < i1; ++i) {
+        std::fill(row.begin(), row.end(), 0LL);
+        for (int p = 0; p < k; ++p) {
+            long long a = A[(size_t)i * lda + p];
+            const T* b = B + (size_t)p * ldb;
+            for (int j = 0; j < n; ++j) row[j] += a * b[j];
+        }
+        for (int j = 0; j < n; ++j)
+            C[(size_t)i * ldc + j] = (int32_t)std::max((long long)INT32_MIN,
+                                                       std::min((long long)INT32_MAX, row[j]));
+    }
+}
+
+template <typename T>
+void qgemm(int m, int n, int k, const T* A, int lda, const T* B, int ldb,
+           int32_t* C, int ldc, int threads = 1) {
+    constexpr qgemm_mode MODE = qgemm_mode_for<T>();
+    constexpr int MR = gemm_shape<int32_t>::MR, NR = gemm_shape<int32_t>::NR;
+    constexpr int KG = qgemm_group(MODE);
+    if (m <= 0 || n <= 0) return;
+    const int shift = MODE == QGEMM_U8S8 ? 128 : 0;
+    int groups = (k + KG - 1) / KG;
+
+    // B is packed once and shared by all threads.
+    std::vector<int32_t> Bw((size_t)((n + NR - 1) / NR) * NR * groups);
+    qgemm_pack_b<MODE>(B, ldb, k, n, Bw.data());
+    std::vector<long long> colsum(MODE == QGEMM_U8S8 ? n : 0, 0);
+    long long max_a = 0, max_b = 0;
+    for (int p = 0; p < k; ++p) {
+        const T* b = B + (size_t)p * ldb;
+        for (int j = 0; j < n; ++j) {
+            max_b = std::max(max_b, (long long)std::abs((int)b[j]));
+            if (MODE == QGEMM_U8S8) colsum[j] += b[j];
+        }
+    }
+    for (int i = 0; i < m; ++i)
+        for (int p = 0; p < k; ++p)
+            max_a = std::max(max_a, (long long)std::abs((int)A[(size_t)i * lda + p] + shift));
+    int block = qgemm_safe_groups(MODE, max_a, max_b);
+    if (block == 0) {
+        gemm_for_each_band<int32_t>(m, threads, [&](int i0, int i1) {
+            qgemm_rows_wide(i0, i1, n, k, A, lda, B, ldb, C, ldc);
+        });
+        return;
+    }
+    int mc = std::max(MR, gemm_default_blocking<int32_t>().mc / MR * MR);
+
+    gemm_for_each_band<int32_t>(m, threads, [&](int i0, int i1) {
+        std::vector<int32_t> Aw((size_t)mc * groups);
+        alignas(64) int32_t acc[MR * NR];
+        long long sum[MR * NR];
+        for (int ic = i0; ic < i1; ic += mc) {
+            int mb = std::min(mc, i1 - ic);
+            qgemm_pack_a<MODE>(A, lda, ic, mb, k, Aw.data());
+            for (int jr = 0; jr < n; jr += NR) {
+                const int32_t* Bp = &Bw[(size_t)jr * groups];
+                int nb = std::min(NR, n - jr);
+                for (int ir = 0; ir < mb; ir += MR) {
+                    const int32_t* Ap = &Aw[(size_t)ir * groups];
+                    int rows = std::min(MR, mb - ir);
+                    std::fill(sum, sum + MR * NR, 0LL);
+                    for (int g0 = 0; g0 < groups; g0 += block) {
+                        int g1 = groups - g0 > block ? g0 + block : groups;
+                        qgemm_micro_kernel<MODE>(g0, g1, Ap, Bp, acc);
+                        for (int t = 0; t < MR * NR; ++t) sum[t] += acc[t];
+                    }
+                    for (int i = 0; i < rows; ++i) {
+                        int32_t* Ci = C + (size_t)(ic + ir + i) * ldc + jr;
+                        for (int j = 0; j < nb; ++j) {
+                            long long v = sum[i * NR + j];
+                            if (MODE == QGEMM_U8S8) v -= 128 * colsum[jr + j];
+                            Ci[j] = (int32_t)std::max((long long)INT32_MIN,
+                                                      std::min((long long)INT32_MAX, v));
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+// Largest quantized magnitude for which a K-deep dot product of two
+// operands quantized to it still fits int32 exactly: 127 for int8 up to
+// K = 133000, but about 1448 rather than 32767 for int16 at K = 1024.
+template <typename T>
+int qgemm_qmax(int k) {
+    long long q = (long long)std::sqrt((double)INT32_MAX / std::max(k, 1));
+    return (int)std::min<long long>(std::numeric_limits<T>::max(), std::max(1LL, q));
+}
+
+// Symmetric per-tensor quantization: q = round(x / scale) clamped to
+// [-qmax, qmax] with scale = max|x| / qmax. Returns the scale (1 for an
+// all-zero x).
+template <typename T>
+float qgemm_quantize(const float* x, size_t count, T* q, int qmax = std::numeric_limits<T>::max()) {
+    float amax = 0.0f;
+    for (size_t i = 0; i < count; ++i) amax = std::max(amax, std::fabs(x[i]));
+    float scale = amax > 0.0f ? amax / qmax : 1.0f;
+    for (size_t i = 0; i < count; ++i)
+        q[i] = (T)std::max(-(float)qmax, std::min((float)qmax, std::nearbyint(x[i] / scale)));
+    return scale;
+}
+
+// Y = scale * C for an m x n int32 result; scale is the product of the
+// scales of the two quantized operands.
+inline void qgemm_dequantize(const int32_t* C, int ldc, int m, int n, float scale,
+                             float* Y, int ldy) {
+    for (int i = 0; i < m; ++i)
+        for (int j = 0; j < n; ++j) Y[(size_t)i * ldy + j] = scale * (float)C[(size_t)i * ldc + j];
+}
@@ -0,0 +1,180 @@
+// Matrix products over other semirings, on the packed GEMM engine of
+// gemm.hpp:
+//
+//     C = C (+) A (x) B       C_ij = C_ij (+) SUM(+)_p A_ip (x) B_pj
+//
+//   semiring_min_plus  (+) = min, (x) = +    shortest paths
+//   semiring_max_plus  (+) = max, (x) = +    longest paths (no positive
+//                                            cycles, e.g. in a DAG)
+//   semiring_max_min   (+) = max, (x) = min  bottleneck (widest) paths
+//
+// A semiring is a policy with zero() (the identity of (+), "no path"),
+// none(x) (x means no path) and add / mul templated on the operand
+// type, so the same expressions apply to scalars and to GCC vector
+// types. The accumulation policy
+// gemm_acc_semiring<S> plugs a micro-kernel over S into gemm_rows_with,
+// so blocking, packing and threading are the ones gemm() uses. The
+// kernel keeps its MR x NR accumulators in whole SIMD vectors and
+// compiles to vpaddd / vpminsd (or vaddpd / vminpd) per element pair.
+//
+// For integers, "infinity" is max() / 2 rather than max(), so the sum
+// of two infinities does not overflow; entries of C must stay within
+// [-inf, inf] (zero() of the min-plus and max-plus semirings). An
+// infinite operand plus a finite weight drifts off inf by that weight,
+// so none(x) tests for "no path" with a margin of inf / 2.
+//
+// floyd_warshall_blocked() solves the all-pairs problem in the blocked
+// form: for each diagonal block, the diagonal and its row / column
+// panels are closed with plain loops and the rest of the matrix (all
+// but a b-wide cross) is updated with one semiring GEMM of depth b.
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "gemm.hpp"
+
+template <typename T>
+constexpr T semiring_inf() {
+    return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity()
+                                                : std::numeric_limits<T>::max() / 2;
+}
+
+struct semiring_min_plus {
+    template <typename T> static constexpr T zero() { return semiring_inf<T>(); }
+    template <typename T> static bool none(T x) { return x >= semiring_inf<T>() / 2; }
+    template <typename V> static V add(V a, V b) { return a < b ? a : b; }
+    template <typename V> static V mul(V a, V b) { return a + b; }
+};
+
+struct semiring_max_plus {
+    template <typename T> static constexpr T zero() { return -semiring_inf<T>(); }
+    template <typename T> static bool none(T x) { return x <= -semiring_inf<T>() / 2; }
+    template <typename V> static V add(V a, V b) { return a > b ? a : b; }
+    template <typename V> static V mul(V a, V b) { return a + b; }
+};
+
+struct semiring_max_min {
+    template <typename T> static constexpr T zero() { return std::numeric_limits<T>::lowest(); }
+    template <typename T> static bool none(T x) { return x == zero<T>(); }
+    template <typename V> static V add(V a, V b) { return a > b ? a : b; }
+    template <typename V> static V mul(V a, V b) { return a < b ? a : b; }
+};
+
+// C[0..m) x [0..n) = C (+) Ap (x) Bp for one MR-row and one NR-column
+// panel of depth kc, in NR / W vectors of W elements per row.
+template <typename T, typename S>
+inline void gemm_micro_kernel_semiring(int kc, const T* Ap, const T* Bp, T* C, int ldc,
+                                       int m, int n) {
+    constexpr int MR = gemm_shape<T>::MR;
+    constexpr int NR = gemm_shape<T>::NR;
+#if defined(__AVX512F__)
+    constexpr int VB = 64;
+#elif defined(__AVX__)
+    constexpr int VB = 32;
+#else
+    constexpr int VB = 16;
+#endif
+    constexpr int W = VB / sizeof(T);
+    constexpr int NV = NR / W;
+    static_assert(NR % W == 0, "vectors must tile the panel");
+    typedef T vec __attribute__((vector_size(VB)));
+    vec acc[MR][NV];
+    for (int i = 0; i < MR; ++i)
+        for (int v = 0; v < NV; ++v) acc[i][v] = vec{} + S::template zero<T>();
+    for (int p = 0; p < kc; ++p) {
+        const T* a = Ap + p * MR;
+        vec b[NV];
+        std::memcpy(b, Bp + p * NR, sizeof(b));
+        for (int i = 0; i < MR; ++i) {
+            vec ai = vec{} + a[i];
+            for (int v = 0; v < NV; ++v) acc[i][v] = S::add(acc[i][v], S::mul(ai, b[v]));
+        }
+    }
+    for (int i = 0; i < m; ++i) {
+        T* Ci = C + (size_t)i * ldc;
+        const T* r = (const T*)acc[i];
+        for (int j = 0; j < n; ++j) Ci[j] = S::add(Ci[j], r[j]);
+    }
+}
+
+template <typename S>
+struct gemm_acc_semiring {};
+
+template <typename T, typename S>
+struct gemm_acc_band<T, gemm_acc_semiring<S>> {
+    T* C;
+    int ldc;
+    gemm_acc_band(T* C, int ldc, int, int, int) : C(C), ldc(ldc) {}
+    void tile(int kc, const T* Ap, const T* Bp, int i, int j, T, int m, int n, gemm_tile_mode) {
+        gemm_micro_kernel_semiring<T, S>(kc, Ap, Bp, C + (size_t)i * ldc + j, ldc, m, n);
+    }
+    void finish() {}
+};
+
+// C = op(A) (x) op(B), or C = C (+) op(A) (x) op(B) with accumulate;
+// op(A) is m x k, op(B) is k x n. Rows of C are split over threads.
+template <typename T, typename S>
+void gemm_semiring(bool trans_a, bool trans_b, int m, int n, int k, const T* A, int lda,
+                   const T* B, int ldb, bool accumulate, T* C, int ldc, int threads = 1) {
+    if (m <= 0 || n <= 0) return;
+    gemm_blocking bs = gemm_default_blocking<T>();
+    gemm_for_each_band<T>(m, threads, [&](int i0, int i1) {
+        if (!accumulate)
+            for (int i = i0; i < i1; ++i)
+                std::fill(C + (size_t)i * ldc, C + (size_t)i * ldc + n, S::template zero<T>());
+        gemm_rows<T, gemm_acc_semiring<S>>(trans_a, trans_b, i0, i1, n, k, T(1), A, lda, B, ldb,
+                                          T(1), C, ldc, bs);
+    });
+}
+
+// D[i][j] = D[i][j] (+) D[i][p] (x) D[p][j] for p in [p0, p1), i in
+// [i0, i1), j in [j0, j1), in that order of p: the Floyd-Warshall
+// update restricted to a block.
+template <typename T, typename S>
+void semiring_fw_block(T* D, int ld, int p0, int p1, int i0, int i1, int j0, int j1) {
+    for (int p = p0; p < p1; ++p) {
+        const T* __restrict Dp = D + (size_t)p * ld;
+        for (int i = i0; i < i1; ++i) {
+            T* __restrict Di = D + (size_t)i * ld;
+            T dip = Di[p];
+            // Row p is not changed by step p unless there is an
+            // improving cycle through p, so it is skipped and the rows
+            // never alias.
+            if (i == p) continue;
+            for (int j = j0; j < j1; ++j) Di[j] = S::add(Di[j], S::mul(dip, Dp[j]));
+        }
+    }
+}
+
+// Classic Floyd-Warshall over S on the n x n matrix D, in place.
+template <typename T, typename S>
+void floyd_warshall(T* D, int ld, int n) {
+    semiring_fw_block<T, S>(D, ld, 0, n, 0, n, 0, n);
+}
+
+// Blocked Floyd-Warshall with b-wide diagonal blocks; the bulk of the
+// work (all rows and columns outside the current block) runs through
+// gemm_semiring.
+template <typename T, typename S>
+void floyd_warshall_blocked(T* D, int ld, int n, int b, int threads = 1) {
+    for (int k0 = 0; k0 < n; k0 += b) {
+        int k1 = std::min(n, k0 + b);
+        // Rows of the block over all columns (the diagonal block and the
+        // row panel), then the column panel against the closed diagonal.
+        semiring_fw_block<T, S>(D, ld, k0, k1, k0, k1, 0, n);
+        semiring_fw_block<T, S>(D, ld, k0, k1, 0, k0, k0, k1);
+        semiring_fw_block<T, S>(D, ld, k0, k1, k1, n, k0, k1);
+        // Everything else: D[I][J] (+)= D[I][K] (x) D[K][J] for the row
+        // ranges I and column ranges J on either side of the block.
+        const int ranges[2][2] = {{0, k0}, {k1, n}};
+        for (auto& I : ranges)
+            for (auto& J : ranges)
+                if (I[1] > I[0] && J[1] > J[0])
+                    gemm_semiring<T, S>(false, false, I[1] - I[0], J[1] - J[0], k1 - k0,
+                                        D + (size_t)I[0] * ld + k0, ld,
+                                        D + (size_t)k0 * ld + J[0], ld, true,
+                                        D + (size_t)I[0] * ld + J[0], ld, threads);
+    }
+}
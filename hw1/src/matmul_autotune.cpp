@@ -0,0 +1,101 @@
+// Autotuner for the tiled matmul kernel (matmul_tiling).
+// Searches tile size x thread count with successive halving and
+// appends the winner to the tuning database (results/tuning.db or
+// $TUNEDB), keyed by CPU model and cache sizes. matmul_tiling --tuned
+// reads it back at startup.
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TUNEDB_IMPLEMENTATION
+#include "tunedb.h"
+#define TOPOLOGY_IMPLEMENTATION
+#include "topology.h"
+#define TRACE_IMPLEMENTATION
+#include "trace.h"
+#include "matmul_tiled.hpp"
+#include "matrix_init.hpp"
+
+using namespace std;
+
+#ifndef N
+#define N 1024
+#endif
+
+struct Candidate {
+    int tile;
+    int threads;
+};
+
+struct TuneContext {
+    const int* A;
+    const int* B;
+    int* C;
+    vector<Candidate> cands;
+};
+
+// Multiply the first 'budget' fraction of the rows and scale the time
+// to the full matrix.
+static double eval_candidate(void* arg, int cand, double budget) {
+    TuneContext* ctx = static_cast<TuneContext*>(arg);
+    const Candidate& c = ctx->cands[cand];
+    int rows = (int)(budget * N + 0.5);
+    rows = max(rows, c.tile * c.threads);
+    rows = min(rows, N);
+    memset(ctx->C, 0, sizeof(int) * (size_t)rows * N);
+
+    auto start = chrono::high_resolution_clock::now();
+    matmul_tiled(ctx->A, ctx->B, ctx->C, N, c.tile, c.threads, rows);
+    auto end = chrono::high_resolution_clock::now();
+    double t = chrono::duration<double>(end - start).count() * N / rows;
+    cout << "  tile=" << c.tile << " threads=" << c.threads
+         << " budget=" << budget << " -> " << t << " s" << endl;
+    return t;
+}
+
+int main() {
+    cout << "Matrix size: " << N << "x" << N << endl;
+    int* A = new int[N * N];
+    int* B = new int[N * N];
+    int* C = new int[N * N]();
+
+    uint64_t seed = matrix_default_seed();
+    matrix_random(A, (size_t)N * N, seed, 0);
+    matrix_random(B, (size_t)N * N, seed, 1);
+
+    // Grid: tile sizes x {1, 2, 4, .., hardware threads}.
+    TuneContext ctx{A, B, C, {}};
+    int max_threads = max(1u, thread::hardware_concurrency());
+    vector<int> thread_grid;
+    for (int t = 1; t < max_threads; t *= 2) thread_grid.push_back(t);
+    thread_grid.push_back(max_threads);
+    for (int tile : {8, 16, 24, 32, 48, 64, 96, 128, 192, 256}) {
+        if (tile > N) continue;
+        for (int t : thread_grid) ctx.cands.push_back({tile, t});
+    }
+
+    cout << "Tuning " << ctx.cands.size() << " candidates (successive halving)" << endl;
+    double seconds = 0.0;
+    int best = tunedb_successive_halving((int)ctx.cands.size(), eval_candidate, &ctx,
+                                         16.0 / N, &seconds);
+    const Candidate& c = ctx.cands[best];
+    cout << "Best: tile=" << c.tile << " threads=" << c.threads
+         << " (" << seconds << " s)" << endl;
+
+    char host[TUNEDB_FIELD];
+    tunedb_host_key(host, sizeof(host));
+    string problem = "N=" + to_string(N);
+    string params = "tile=" + to_string(c.tile) + " threads=" + to_string(c.threads);
+    if (tunedb_append(tunedb_default_path(), host, "matmul_tiling", problem.c_str(),
+                      params.c_str(), seconds) == 0) {
+        cout << "Saved tuning result to " << tunedb_default_path() << endl;
+    }
+
+    delete[] A;
+    delete[] B;
+    delete[] C;
+}
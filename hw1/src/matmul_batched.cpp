@@ -0,0 +1,126 @@
+// Batched small-matrix benchmark: many independent size x size double
+// multiplies (C = A * B + C), run as a loop over gemm() calls, as one
+// gemm_batch_strided() call and as one pointer-array gemm_batch() call.
+// Without --size it sweeps 4, 8, 16, 32, 48 and 64; the batch holds
+// about 2^20 elements per operand unless --batch is given.
+//
+//   --size=S      one matrix size (m = n = k)
+//   --batch=B     number of multiplies
+//   --threads=T   0 = one per physical core (default 1)
+//
+// The exit status is 1 if a batched result differs from the loop by
+// more than 2 * size * DBL_EPSILON (relative, at least 1 in magnitude):
+// the rounding bound of each side.
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define TOPOLOGY_IMPLEMENTATION
+#include "topology.h"
+#define TRACE_IMPLEMENTATION
+#include "trace.h"
+#include "gemm_batched.hpp"
+
+using namespace std;
+
+#ifndef N
+#define N 1024
+#endif
+
+template <typename F>
+static double time_best(int reps, F f) {
+    double best = 1e30;
+    for (int r = 0; r < reps; ++r) {
+        auto start = chrono::high_resolution_clock::now();
+        f();
+        auto end = chrono::high_resolution_clock::now();
+        best = min(best, chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+static double max_diff(const vector<double>& x, const vector<double>& y) {
+    double d = 0.0;
+    for (size_t i = 0; i < x.size(); ++i) d = max(d, fabs(x[i] - y[i]) / max(1.0, fabs(y[i])));
+    return d;
+}
+
+int main(int argc, char** argv) {
+    int size = 0, batch = 0, threads = 1;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (strncmp(a, "--size=", 7) == 0) size = atoi(a + 7);
+        else if (strncmp(a, "--batch=", 8) == 0) batch = atoi(a + 8);
+        else if (strncmp(a, "--threads=", 10) == 0) threads = atoi(a + 10);
+        else {
+            cerr << "Unknown argument: " << a << endl;
+            return 1;
+        }
+    }
+    if (threads <= 0) {
+        topo_t topo;
+        topo_discover(&topo);
+        threads = topo_default_threads(&topo);
+        topo_free(&topo);
+    }
+    vector<int> sizes = size > 0 ? vector<int>{size} : vector<int>{4, 8, 16, 32, 48, 64};
+    cout << "Batched GEMM, threads: " << threads << endl;
+    cout << setw(6) << "size" << setw(9) << "batch" << setw(14) << "loop GF/s" << setw(14)
+         << "strided GF/s" << setw(14) << "pointer GF/s" << setw(10) << "speedup"
+         << setw(12) << "max diff" << endl;
+
+    double total = 0.0;
+    bool passed = true;
+    for (int s : sizes) {
+        int nb = batch > 0 ? batch : max(1, (1 << 20) / (s * s));
+        size_t e = (size_t)s * s;
+        vector<double> A(e * nb), B(e * nb), C0(e * nb);
+        srand(1);
+        for (auto& x : A) x = rand() % 100 / 10.0;
+        for (auto& x : B) x = rand() % 100 / 10.0;
+        for (auto& x : C0) x = rand() % 100 / 10.0;
+        vector<const double*> Ap(nb), Bp(nb);
+        vector<double*> Cp(nb);
+
+        // Each timed run starts from C0, so all three compute the same C.
+        vector<double> C_loop, C_strided, C_ptr;
+        double t_loop = time_best(3, [&] {
+            C_loop = C0;
+            for (int b = 0; b < nb; ++b)
+                gemm(false, false, s, s, s, 1.0, &A[b * e], s, &B[b * e], s, 1.0,
+                     &C_loop[b * e], s, threads);
+        });
+        double t_strided = time_best(3, [&] {
+            C_strided = C0;
+            gemm_batch_strided(false, false, s, s, s, 1.0, A.data(), s, (long long)e, B.data(), s,
+                               (long long)e, 1.0, C_strided.data(), s, (long long)e, nb, threads);
+        });
+        double t_ptr = time_best(3, [&] {
+            C_ptr = C0;
+            for (int b = 0; b < nb; ++b) {
+                Ap[b] = &A[b * e];
+                Bp[b] = &B[b * e];
+                Cp[b] = &C_ptr[b * e];
+            }
+            gemm_batch(false, false, s, s, s, 1.0, Ap.data(), s, Bp.data(), s, 1.0, Cp.data(), s,
+                       nb, threads);
+        });
+        total += t_strided;
+
+        double flops = 2.0 * s * s * s * nb;
+        double diff = max(max_diff(C_strided, C_loop), max_diff(C_ptr, C_loop));
+        passed = passed && diff <= 2.0 * s * DBL_EPSILON;
+        cout << setw(6) << s << setw(9) << nb << fixed << setprecision(2) << setw(14)
+             << flops / t_loop * 1e-9 << setw(14) << flops / t_strided * 1e-9 << setw(14)
+             << flops / t_ptr * 1e-9 << setw(9) << t_loop / t_strided << "x" << scientific
+             << setprecision(1) << setw(12) << diff << defaultfloat << setprecision(6) << endl;
+    }
+    cout << "Verification: " << (passed ? "passed" : "FAILED") << " (vs gemm() loop)" << endl;
+    cout << "Execution time: " << total << " seconds" << endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+// Boolean matrix benchmark on the adjacency matrix of a random directed
+// graph: the bit-packed OR product and path counting from gemm_bool.hpp
+// against gemm<int> on the 0/1 matrix, then the transitive closure by
+// repeated squaring, checked against BFS from a few sources.
+//
+//   --nodes=V     number of nodes (default N)
+//   --degree=D    out-edges per node (default 4)
+//   --graph=random|local  targets uniform, or within 64 nodes ahead (a
+//                 long-diameter graph that needs more squaring rounds)
+//   --threads=T   0 = one per physical core (default 1)
+//   --no-dense    skip the gemm<int> comparison (for large V)
+//
+// "Execution time" is the headline kernel alone, the OR product G . G;
+// the other times are printed above it. The exit status is 1 on any
+// mismatch against gemm<int> or BFS.
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define TOPOLOGY_IMPLEMENTATION
+#include "topology.h"
+#define TRACE_IMPLEMENTATION
+#include "trace.h"
+#include "gemm.hpp"
+#include "gemm_bool.hpp"
+
+using namespace std;
+
+#ifndef N
+#define N 1024
+#endif
+
+template <typename F>
+static double time_best(int reps, F f) {
+    double best = 1e30;
+    for (int r = 0; r < reps; ++r) {
+        auto start = chrono::high_resolution_clock::now();
+        f();
+        auto end = chrono::high_resolution_clock::now();
+        best = min(best, chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+// Nodes reachable from s by a path of length >= 1.
+static vector<char> reachable(const bit_matrix& G, int s) {
+    vector<char> seen(G.rows, 0);
+    vector<int> queue;
+    auto visit_from = [&](int u) {
+        const uint64_t* r = G.row(u);
+        for (int w = 0; w < G.words; ++w)
+            for (uint64_t x = r[w]; x; x &= x - 1) {
+                int v = w * 64 + __builtin_ctzll(x);
+                if (!seen[v]) {
+                    seen[v] = 1;
+                    queue.push_back(v);
+                }
+            }
+    };
+    visit_from(s);
+    for (size_t q = 0; q < queue.size(); ++q) visit_from(queue[q]);
+    return seen;
+}
+
+int main(int argc, char** argv) {
+    int nodes = N, degree = 4, threads = 1;
+    string graph = "random";
+    bool dense = true;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (strncmp(a, "--nodes=", 8) == 0) nodes = atoi(a + 8);
+        else if (strncmp(a, "--degree=", 9) == 0) degree = atoi(a + 9);
+        else if (strncmp(a, "--graph=", 8) == 0) graph = a + 8;
+        else if (strncmp(a, "--threads=", 10) == 0) threads = atoi(a + 10);
+        else if (strcmp(a, "--no-dense") == 0) dense = false;
+        else {
+            cerr << "Unknown argument: " << a << endl;
+            return 1;
+        }
+    }
+    if (nodes <= 0 || degree < 0 || (graph != "random" && graph != "local")) {
+        cerr << "Error: bad --nodes, --degree or --graph" << endl;
+        return 1;
+    }
+    if (threads <= 0) {
+        topo_t topo;
+        topo_discover(&topo);
+        threads = topo_default_threads(&topo);
+        topo_free(&topo);
+    }
+    cout << "Boolean " << nodes << " nodes, degree " << degree << ", graph " << graph
+         << ", threads: " << threads << endl;
+
+    srand(1);
+    bit_matrix G(nodes, nodes);
+    for (int i = 0; i < nodes; ++i)
+        for (int e = 0; e < degree; ++e) {
+            int j = graph == "local" ? (i + 1 + rand() % 64) % nodes : rand() % nodes;
+            G.set(i, j);
+        }
+    cout << "Edges: " << G.count() << ", bit matrix " << G.bits.size() * 8 / 1024.0
+         << " KiB vs int matrix " << (double)nodes * nodes * 4 / 1024.0 << " KiB" << endl;
+
+    // Two-step reachability and path counts: G . G.
+    bit_matrix G2(nodes, nodes);
+    double t_or = time_best(3, [&] {
+        fill(G2.bits.begin(), G2.bits.end(), 0);
+        bool_gemm_or(G, G, G2, threads);
+    });
+    bit_matrix Gt = bit_transpose(G);
+    vector<int32_t> paths((size_t)nodes * nodes);
+    double t_count = time_best(3, [&] {
+        bool_gemm_count(G, Gt, paths.data(), nodes, threads);
+    });
+    cout << fixed << setprecision(4) << "OR product:    " << t_or << " s" << endl
+         << "Path counts:   " << t_count << " s" << endl;
+
+    double t_dense = 0.0;
+    size_t mismatches = 0;
+    if (dense) {
+        vector<int> A((size_t)nodes * nodes), C((size_t)nodes * nodes);
+        for (int i = 0; i < nodes; ++i)
+            for (int j = 0; j < nodes; ++j) A[(size_t)i * nodes + j] = G.get(i, j);
+        t_dense = time_best(1, [&] {
+            gemm(false, false, nodes, nodes, nodes, 1, A.data(), nodes, A.data(), nodes, 0,
+                 C.data(), nodes, threads);
+        });
+        size_t or_bad = 0, count_bad = 0;
+        for (int i = 0; i < nodes; ++i)
+            for (int j = 0; j < nodes; ++j) {
+                int c = C[(size_t)i * nodes + j];
+                or_bad += G2.get(i, j) != (c > 0);
+                count_bad += paths[(size_t)i * nodes + j] != c;
+            }
+        cout << "gemm<int>:     " << t_dense << " s (" << t_dense / t_or << "x OR, "
+             << t_dense / t_count << "x count)" << endl;
+        cout << "Mismatches vs gemm<int>: OR " << or_bad << ", count " << count_bad << endl;
+        mismatches += or_bad + count_bad;
+    }
+    cout << defaultfloat << setprecision(6);
+
+    bit_matrix R = G;
+    int rounds = 0;
+    double t_closure = time_best(1, [&] { rounds = bool_closure(R, threads); });
+    size_t closure_bad = 0;
+    for (int s = 0; s < nodes; s += max(1, nodes / 16)) {
+        vector<char> seen = reachable(G, s);
+        for (int j = 0; j < nodes; ++j) closure_bad += R.get(s, j) != (seen[j] != 0);
+    }
+    cout << "Closure: " << rounds << " rounds, " << R.count() << " reachable pairs, "
+         << t_closure << " s; mismatches vs BFS (16 sources): " << closure_bad << endl;
+    mismatches += closure_bad;
+    cout << "Verification: " << (mismatches == 0 ? "passed" : "FAILED") << endl;
+    cout << "Execution time: " << t_or << " seconds" << endl;
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+// Matrix chain benchmark: a chain of matrices with random dimensions
+// multiplied left to right, in the order that minimizes flops and in
+// the order that minimizes the gemm() cost model (gemm_chain.hpp).
+// Reports predicted flops, time, peak intermediate memory and the
+// largest difference from the left-to-right result; the exit status is
+// 1 if that exceeds length * max-dim * DBL_EPSILON times max|C|.
+//
+//   --length=L    number of matrices (default 10)
+//   --max-dim=D   dimensions are drawn from [4, D] (default N)
+//   --seed=S      random dimensions seed (default 1)
+//   --threads=T   0 = one per physical core (default 1)
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define TOPOLOGY_IMPLEMENTATION
+#include "topology.h"
+#define TRACE_IMPLEMENTATION
+#include "trace.h"
+#include "gemm.hpp"
+#include "gemm_chain.hpp"
+
+using namespace std;
+
+#ifndef N
+#define N 1024
+#endif
+
+template <typename F>
+static double time_best(int reps, F f) {
+    double best = 1e30;
+    for (int r = 0; r < reps; ++r) {
+        auto start = chrono::high_resolution_clock::now();
+        f();
+        auto end = chrono::high_resolution_clock::now();
+        best = min(best, chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    int length = 10, max_dim = N, seed = 1, threads = 1;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (strncmp(a, "--length=", 9) == 0) length = atoi(a + 9);
+        else if (strncmp(a, "--max-dim=", 10) == 0) max_dim = atoi(a + 10);
+        else if (strncmp(a, "--seed=", 7) == 0) seed = atoi(a + 7);
+        else if (strncmp(a, "--threads=", 10) == 0) threads = atoi(a + 10);
+        else {
+            cerr << "Unknown argument: " << a << endl;
+            return 1;
+        }
+    }
+    if (length <= 0 || max_dim < 4) {
+        cerr << "Error: bad --length or --max-dim" << endl;
+        return 1;
+    }
+    if (threads <= 0) {
+        topo_t topo;
+        topo_discover(&topo);
+        threads = topo_default_threads(&topo);
+        topo_free(&topo);
+    }
+
+    srand(seed);
+    vector<int> dims(length + 1);
+    for (int& d : dims) d = 4 + rand() % (max_dim - 3);
+    cout << "Chain of " << length << " matrices, dims";
+    for (int d : dims) cout << " " << d;
+    cout << ", threads: " << threads << endl;
+
+    vector<vector<double>> data(length);
+    vector<chain_matrix<double>> mats;
+    for (int i = 0; i < length; ++i) {
+        // Entries scaled so products stay near 1 in magnitude.
+        data[i].resize((size_t)dims[i] * dims[i + 1]);
+        double scale = 2.0 / sqrt((double)dims[i]);
+        for (auto& v : data[i]) v = scale * ((double)rand() / RAND_MAX - 0.5);
+        mats.push_back({dims[i], dims[i + 1], data[i].data(), dims[i + 1]});
+    }
+
+    chain_cost_gemm<double> model;
+    struct variant {
+        const char* name;
+        chain_plan plan;
+    } variants[] = {
+        {"left to right", chain_left_to_right(dims)},
+        {"min flops", chain_optimal_plan(dims, chain_cost_flops())},
+        {"cost model", chain_optimal_plan(dims, model)},
+    };
+
+    size_t out = (size_t)dims[0] * dims[length];
+    vector<double> ref(out), C(out);
+    cout << left << setw(15) << "plan" << right << setw(12) << "GFLOP" << setw(12) << "model s"
+         << setw(10) << "time s" << setw(12) << "peak MiB" << setw(8) << "allocs" << setw(12)
+         << "max diff" << endl;
+    double total = 0.0, worst = 0.0, max_c = 0.0;
+    for (int v = 0; v < 3; ++v) {
+        const chain_plan& plan = variants[v].plan;
+        chain_stats stats;
+        double t = time_best(2, [&] {
+            stats = gemm_chain(mats, plan, v == 0 ? ref.data() : C.data(), dims[length], threads,
+                               model);
+        });
+        double diff = 0.0;
+        if (v == 0)
+            for (size_t e = 0; e < out; ++e) max_c = max(max_c, fabs(ref[e]));
+        else
+            for (size_t e = 0; e < out; ++e) diff = max(diff, fabs(C[e] - ref[e]));
+        worst = max(worst, diff);
+        total += t;
+        cout << left << setw(15) << variants[v].name << right << fixed << setprecision(3)
+             << setw(12) << chain_plan_cost(plan, chain_cost_flops()) * 1e-9 << setw(12)
+             << chain_plan_cost(plan, model) << setw(10) << t << setw(12)
+             << stats.peak_elements * sizeof(double) / 1048576.0 << setw(8) << stats.allocations
+             << scientific << setprecision(2) << setw(12) << diff << defaultfloat
+             << setprecision(6) << endl;
+    }
+    cout << "Flop-optimal:  " << variants[1].plan.str() << endl;
+    cout << "Model-optimal: " << variants[2].plan.str() << endl;
+    bool passed = worst <= (double)length * max_dim * DBL_EPSILON * max_c;
+    cout << "Verification: " << (passed ? "passed" : "FAILED") << " (vs left to right)" << endl;
+    cout << "Execution time: " << total << " seconds" << endl;
+    return passed ? 0 : 1;
+}
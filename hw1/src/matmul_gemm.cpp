@@ -0,0 +1,167 @@
+// Rectangular GEMM benchmark: C = alpha * op(A) * op(B) + beta * C in
+// double precision with gemm.hpp, optionally against the cblas_dgemm of
+// another BLAS loaded with dlopen (--blas=libopenblas.so).
+//
+//   --m=M --n=N --k=K     problem size (default N x N x N)
+//   --trans=NN|NT|TN|TT   transpose flags of A and B
+//   --alpha=a --beta=b    scalars (default 1, 0)
+//   --threads=T           0 = one per physical core (default 1)
+//   --prefetch=D          software prefetch D k-steps ahead (default 0 = off)
+//   --stream              non-temporal stores for the final C write-back
+//
+// C is 64-byte aligned (arena.h), as a BLAS caller's C usually is. The
+// exit status is 1 if a sampled entry is off by more than k * DBL_EPSILON
+// (relative, at least 1 in magnitude).
+//
+// With $TRACE=FILE the bands, packing and tile loops are written as a
+// Chrome trace (trace.h).
+#include <iostream>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <dlfcn.h>
+
+#define ARENA_IMPLEMENTATION
+#include "arena.h"
+#define TOPOLOGY_IMPLEMENTATION
+#include "topology.h"
+#define TRACE_IMPLEMENTATION
+#include "trace.h"
+#include "gemm.hpp"
+#include "blas/cblas.h"
+
+using namespace std;
+
+#ifndef N
+#define N 1024
+#endif
+
+typedef void (*dgemm_fn)(CBLAS_ORDER, CBLAS_TRANSPOSE, CBLAS_TRANSPOSE, int, int, int,
+                         double, const double*, int, const double*, int, double,
+                         double*, int);
+
+int main(int argc, char** argv) {
+    int m = N, n = N, k = N, threads = 1;
+    bool ta = false, tb = false;
+    double alpha = 1.0, beta = 0.0;
+    const char* blas = nullptr;
+    int prefetch = 0;
+    bool stream = false;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (strncmp(a, "--m=", 4) == 0) m = atoi(a + 4);
+        else if (strncmp(a, "--n=", 4) == 0) n = atoi(a + 4);
+        else if (strncmp(a, "--k=", 4) == 0) k = atoi(a + 4);
+        else if (strncmp(a, "--threads=", 10) == 0) threads = atoi(a + 10);
+        else if (strncmp(a, "--alpha=", 8) == 0) alpha = atof(a + 8);
+        else if (strncmp(a, "--beta=", 7) == 0) beta = atof(a + 7);
+        else if (strncmp(a, "--blas=", 7) == 0) blas = a + 7;
+        else if (strncmp(a, "--prefetch=", 11) == 0) prefetch = atoi(a + 11);
+        else if (strcmp(a, "--stream") == 0) stream = true;
+        else if (strncmp(a, "--trans=", 8) == 0 && strlen(a + 8) == 2) {
+            ta = a[8] == 'T';
+            tb = a[9] == 'T';
+        } else {
+            cerr << "Unknown argument: " << a << endl;
+            return 1;
+        }
+    }
+    trace_init(nullptr);
+    if (threads <= 0) {
+        topo_t topo;
+        topo_discover(&topo);
+        threads = topo_default_threads(&topo);
+        topo_free(&topo);
+    }
+    gemm_blocking bs = gemm_default_blocking<double>();
+    bs.prefetch = max(0, prefetch);
+    bs.stream_c = stream;
+    cout << "GEMM " << m << "x" << k << " * " << k << "x" << n << " (" << (ta ? 'T' : 'N')
+         << (tb ? 'T' : 'N') << "), alpha=" << alpha << " beta=" << beta
+         << ", threads: " << threads << ", blocking mc=" << bs.mc << " kc=" << bs.kc
+         << " nc=" << bs.nc << ", prefetch " << bs.prefetch << ", stream "
+         << (bs.stream_c ? "on" : "off") << endl;
+
+    // Stored shapes: op(A) is m x k, so A is k x m when transposed.
+    int lda = ta ? m : k, ldb = tb ? k : n, ldc = n;
+    vector<double> A((size_t)(ta ? k : m) * lda), B((size_t)(tb ? n : k) * ldb);
+    vector<double> C0((size_t)m * ldc);
+    srand(1);
+    for (auto& x : A) x = rand() % 100 / 10.0;
+    for (auto& x : B) x = rand() % 100 / 10.0;
+    for (auto& x : C0) x = rand() % 100 / 10.0;
+    arena_t arena;
+    if (arena_init(&arena, C0.size() * sizeof(double) + ARENA_ALIGN, 0) != 0) {
+        cerr << "Error: could not map C" << endl;
+        return 1;
+    }
+    double* C = (double*)arena_alloc(&arena, C0.size() * sizeof(double));
+    copy(C0.begin(), C0.end(), C);
+    gemm_streamed_tiles = 0;
+
+    trace_scope_t multiply = trace_begin("multiply");
+    auto start = chrono::high_resolution_clock::now();
+    gemm(ta, tb, m, n, k, alpha, A.data(), lda, B.data(), ldb, beta, C, ldc, threads, bs);
+    auto end = chrono::high_resolution_clock::now();
+    trace_end(&multiply);
+    double t = chrono::duration<double>(end - start).count();
+    double flops = 2.0 * m * n * k;
+    cout << "Execution time: " << t << " seconds (" << flops / t * 1e-9 << " GFLOP/s)" << endl;
+    if (bs.stream_c) {
+        constexpr int MR = gemm_shape<double>::MR, NR = gemm_shape<double>::NR;
+        long long tiles = (long long)((m + MR - 1) / MR) * ((n + NR - 1) / NR);
+        cout << "Streamed tiles: " << gemm_streamed_tiles << " of " << tiles << endl;
+    }
+
+    // Reference on up to 16 sampled rows.
+    trace_scope_t reference = trace_begin("reference");
+    double max_err = 0.0;
+    for (int s = 0; s < min(m, 16); ++s) {
+        int i = (int)((long long)s * m / min(m, 16));
+        for (int j = 0; j < n; ++j) {
+            double sum = 0.0;
+            for (int p = 0; p < k; ++p)
+                sum += gemm_at(A.data(), lda, ta, i, p) * gemm_at(B.data(), ldb, tb, p, j);
+            double ref = alpha * sum + beta * C0[(size_t)i * ldc + j];
+            double err = fabs(C[(size_t)i * ldc + j] - ref) / max(1.0, fabs(ref));
+            max_err = max(max_err, err);
+        }
+    }
+    trace_end(&reference);
+    cout << "Max relative error (sampled rows): " << max_err << endl;
+    bool passed = max_err <= max(1, k) * DBL_EPSILON;
+    cout << "Verification: " << (passed ? "passed" : "FAILED") << " (sampled rows)" << endl;
+
+    double checksum = 0;
+    for (size_t i = 0; i < C0.size(); ++i) checksum += C[i];
+    cout << "Checksum: " << checksum << endl;
+
+    if (blas) {
+        void* lib = dlopen(blas, RTLD_NOW | RTLD_LOCAL);
+        dgemm_fn other = lib ? (dgemm_fn)dlsym(lib, "cblas_dgemm") : nullptr;
+        if (!other) {
+            cerr << "Error: no cblas_dgemm in " << blas << ": " << dlerror() << endl;
+            arena_release(&arena);
+            return 1;
+        }
+        vector<double> C2 = C0;
+        start = chrono::high_resolution_clock::now();
+        other(CblasRowMajor, ta ? CblasTrans : CblasNoTrans, tb ? CblasTrans : CblasNoTrans,
+              m, n, k, alpha, A.data(), lda, B.data(), ldb, beta, C2.data(), ldc);
+        end = chrono::high_resolution_clock::now();
+        double t2 = chrono::duration<double>(end - start).count();
+        double diff = 0.0;
+        for (size_t i = 0; i < C0.size(); ++i)
+            diff = max(diff, fabs(C[i] - C2[i]) / max(1.0, fabs(C2[i])));
+        cout << blas << ": " << t2 << " seconds (" << flops / t2 * 1e-9
+             << " GFLOP/s), max relative difference " << diff << endl;
+        dlclose(lib);
+    }
+    arena_release(&arena);
+    trace_finish();
+    return passed ? 0 : 1;
+}
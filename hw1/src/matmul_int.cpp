@@ -2,6 +2,8 @@
 #include <chrono>
 #include <cstdlib>
 
+#include "matrix_init.hpp"
+
 using namespace std;
 
 #ifndef N
@@ -15,10 +17,9 @@ int main() {
     int* B = new int[N * N];
     int* C = new int[N * N]();
 
-    for (int i = 0; i < N * N; ++i) {
-        A[i] = rand() % 100;
-        B[i] = rand() % 100;
-    }
+    uint64_t seed = matrix_default_seed();
+    matrix_random(A, (size_t)N * N, seed, 0);
+    matrix_random(B, (size_t)N * N, seed, 1);
 
     auto start = chrono::high_resolution_clock::now();
 
@@ -36,13 +37,12 @@ int main() {
     double time_taken = chrono::duration<double>(end - start).count();
     cout << "Execution time: " << time_taken << " seconds" << endl;
 
-    double checksum = 0;
-    for (int i = 0; i < N * N; ++i)
-        checksum += C[i];
-
-    cout << "Checksum: " << checksum << endl;
+    freivalds_result v = freivalds_check(A, B, C, N);
+    cout << "Verification: " << (v.ok ? "passed" : "FAILED") << " (Freivalds, " << v.rounds
+         << " rounds)" << endl;
 
     delete[] A;
     delete[] B;
     delete[] C;
+    return v.ok ? 0 : 1;
 }
\ No newline at end of file
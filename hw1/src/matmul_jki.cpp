@@ -1,6 +1,10 @@
+// jki loop order on int matrices, generated by matmul_loops.hpp;
+// matmul_loops runs every order and element type from one binary.
 #include <iostream>
 #include <chrono>
-#include <cstdlib>
+#include <vector>
+
+#include "matmul_loops.hpp"
 
 using namespace std;
 
@@ -9,40 +13,23 @@ using namespace std;
 #endif
 
 int main() {
-    // const int N = 1024; // Start small (e.g., 512) and scale up later
     cout << "Matrix size: " << N << "x" << N << endl;
-    int* A = new int[N * N];
-    int* B = new int[N * N];
-    int* C = new int[N * N]();
-
-    for (int i = 0; i < N * N; ++i) {
-        A[i] = rand() % 100;
-        B[i] = rand() % 100;
-    }
+    vector<int> A((size_t)N * N), B((size_t)N * N), C((size_t)N * N);
+    matmul_loop_init(A.data(), B.data(), C.data(), N, matrix_default_seed());
 
     auto start = chrono::high_resolution_clock::now();
-
-    // Matrix multiplication
-    for (int j = 0; j < N; ++j)
-        for (int k = 0; k < N; ++k) {
-            int bkj = B[k * N + j];
-            for (int i = 0; i < N; ++i) {
-                C[i * N + j] += A[i * N + k] * bkj;
-            }
-        }
-
+    bool ran = matmul_loop_nest<int, 'j', 'k', 'i', N>::run(A.data(), B.data(), C.data(), N, {});
     auto end = chrono::high_resolution_clock::now();
 
+    if (!ran) {
+        cerr << "Error: the loop nest was built for another matrix size" << endl;
+        return 1;
+    }
     double time_taken = chrono::duration<double>(end - start).count();
     cout << "Execution time: " << time_taken << " seconds" << endl;
 
-    double checksum = 0;
-    for (int i = 0; i < N * N; ++i)
-        checksum += C[i];
-
-    cout << "Checksum: " << checksum << endl;
-
-    delete[] A;
-    delete[] B;
-    delete[] C;
-}
\ No newline at end of file
+    freivalds_result v = freivalds_check(A.data(), B.data(), C.data(), N);
+    cout << "Verification: " << (v.ok ? "passed" : "FAILED") << " (Freivalds, " << v.rounds
+         << " rounds)" << endl;
+    return v.ok ? 0 : 1;
+}
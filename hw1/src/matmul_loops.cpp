@@ -0,0 +1,84 @@
+// Loop order study: any of the six loop orders of C += A * B
+// (matmul_loops.hpp), optionally tiled per loop variable, for int,
+// float or double, all from this one binary. Prints time and GFLOP/s
+// per order, each result checked with freivalds_check
+// (matrix_init.hpp); exits with 1 if any check fails.
+//
+//   --order=ORD|all      ijk, ikj, jik, jki, kij, kji (default all)
+//   --type=int|float|double
+//   --tile=T|Ti,Tj,Tk    tile sizes for i, j, k (default 0 = untiled)
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "matmul_loops.hpp"
+
+using namespace std;
+
+#ifndef N
+#define N 1024
+#endif
+
+template <typename T>
+static int run(const string& order, matmul_loop_tiles tiles) {
+    vector<matmul_loop_variant<T>> variants = matmul_loop_variants<T, N>();
+    if (order != "all" && !matmul_loop_find(variants, order)) {
+        cerr << "Error: unknown --order=" << order << endl;
+        return 1;
+    }
+    vector<T> A((size_t)N * N), B((size_t)N * N), C((size_t)N * N);
+    matmul_loop_init(A.data(), B.data(), C.data(), N, matrix_default_seed());
+
+    cout << setw(6) << "order" << setw(12) << "time s" << setw(10) << "GFLOP/s" << setw(10)
+         << "check" << endl;
+    double total = 0.0;
+    bool ok = true;
+    for (const auto& v : variants) {
+        if (order != "all" && order != v.name) continue;
+        fill(C.begin(), C.end(), T(0));
+        auto start = chrono::high_resolution_clock::now();
+        bool ran = v.run(A.data(), B.data(), C.data(), N, tiles);
+        auto end = chrono::high_resolution_clock::now();
+        if (!ran) {
+            cerr << "Error: " << v.name << " was built for another matrix size" << endl;
+            return 1;
+        }
+        double t = chrono::duration<double>(end - start).count();
+        bool passed = freivalds_check(A.data(), B.data(), C.data(), N).ok;
+        ok &= passed;
+        total += t;
+        cout << setw(6) << v.name << setw(12) << t << setw(10) << 2.0 * N * N * N / t * 1e-9
+             << setw(10) << (passed ? "passed" : "FAILED") << endl;
+    }
+    cout << "Execution time: " << total << " seconds" << endl;
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    string order = "all", type = "int";
+    matmul_loop_tiles tiles;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (strncmp(a, "--order=", 8) == 0) order = a + 8;
+        else if (strncmp(a, "--type=", 7) == 0) type = a + 7;
+        else if (strncmp(a, "--tile=", 7) == 0) {
+            if (sscanf(a + 7, "%d,%d,%d", &tiles.i, &tiles.j, &tiles.k) == 1)
+                tiles.j = tiles.k = tiles.i;
+        } else {
+            cerr << "Unknown argument: " << a << endl;
+            return 1;
+        }
+    }
+    cout << "Matrix size: " << N << "x" << N << ", type: " << type << ", tiles i=" << tiles.i
+         << " j=" << tiles.j << " k=" << tiles.k << endl;
+    if (type == "int") return run<int>(order, tiles);
+    if (type == "float") return run<float>(order, tiles);
+    if (type == "double") return run<double>(order, tiles);
+    cerr << "Error: --type must be int, float or double" << endl;
+    return 1;
+}
@@ -0,0 +1,167 @@
+// All six loop orders of C += A * B from one template:
+//
+//     matmul_loop_nest<double, 'k', 'i', 'j'>::run(A, B, C, n, {64, 0, 256});
+//
+// The three template characters name the loops from outermost to
+// innermost. The innermost loop is specialized on its variable, with
+// the values and row pointers that do not change in it hoisted out:
+//
+//   ..k   sum += A[i][k] * B[k][j], one store to C[i][j] at the end
+//   ..j   C[i][.] += a * B[k][.] with a = A[i][k]    (unit stride)
+//   ..i   C[.][j] += A[.][k] * b with b = B[k][j]    (stride n)
+//
+// matmul_loop_tiles optionally blocks each variable: the nest first
+// walks tiles of i, j and k in the same order, then the points inside
+// a tile (0 leaves that variable untiled). Fixed > 0 makes the matrix
+// size a compile-time constant (run() then returns false, leaving C
+// untouched, unless n == Fixed), which
+// lets the compiler fold the strides as it did for the original
+// per-order programs built with -DN. matmul_loop_variants<T, Fixed>()
+// lists all six orders for runtime selection.
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "matrix_init.hpp"
+
+struct matmul_loop_tiles {
+    int i = 0, j = 0, k = 0;
+};
+
+template <typename T, char L0, char L1, char L2, int Fixed = 0>
+struct matmul_loop_nest {
+    static constexpr int var(char c) { return c == 'i' ? 0 : c == 'j' ? 1 : 2; }
+    static constexpr int order[3] = {var(L0), var(L1), var(L2)};
+    static_assert(((1 << var(L0)) | (1 << var(L1)) | (1 << var(L2))) == 7 &&
+                      (L0 == 'i' || L0 == 'j' || L0 == 'k') &&
+                      (L1 == 'i' || L1 == 'j' || L1 == 'k') &&
+                      (L2 == 'i' || L2 == 'j' || L2 == 'k'),
+                  "loop order must be a permutation of i, j, k");
+
+    // Bounds of one tile, [lo[v], hi[v]) for variable v. Passed by value
+    // so that stores to C (possibly int as well) cannot alias them; A, B
+    // and C are __restrict for the same reason.
+    struct box {
+        int lo[3], hi[3];
+    };
+
+    // Points of one tile. The whole nest sits in one function so that
+    // __restrict covers it; x[] is indexed by constants only and lives
+    // in registers. Whole (no tiling) replaces the bounds by 0 .. n, so
+    // with Fixed the trip counts are constant like in the original
+    // programs.
+    template <bool Whole>
+    static void points(const T* __restrict A, const T* __restrict B, T* __restrict C, int nr,
+                       box b) {
+        constexpr int v0 = order[0], v1 = order[1], v2 = order[2];
+        const int n = Fixed > 0 ? Fixed : nr;
+        const int lo2 = Whole ? 0 : b.lo[v2], hi2 = Whole ? n : b.hi[v2];
+        int x[3];
+        for (x[v0] = Whole ? 0 : b.lo[v0]; x[v0] < (Whole ? n : b.hi[v0]); ++x[v0])
+            for (x[v1] = Whole ? 0 : b.lo[v1]; x[v1] < (Whole ? n : b.hi[v1]); ++x[v1]) {
+                const int i = x[0], j = x[1], k = x[2];
+                if constexpr (v2 == 2) {
+                    const T* Ai = A + (size_t)i * n;
+                    const T* Bj = B + j;
+                    T sum = T(0);
+                    for (int kk = lo2; kk < hi2; ++kk) sum += Ai[kk] * Bj[(size_t)kk * n];
+                    C[(size_t)i * n + j] += sum;
+                } else if constexpr (v2 == 1) {
+                    const T a = A[(size_t)i * n + k];
+                    const T* Bk = B + (size_t)k * n;
+                    T* Ci = C + (size_t)i * n;
+                    for (int jj = lo2; jj < hi2; ++jj) Ci[jj] += a * Bk[jj];
+                } else {
+                    const T bkj = B[(size_t)k * n + j];
+                    const T* Ak = A + k;
+                    T* Cj = C + j;
+                    for (int ii = lo2; ii < hi2; ++ii) Cj[(size_t)ii * n] += Ak[(size_t)ii * n] * bkj;
+                }
+            }
+    }
+
+    // Tile loops in the same order; an untiled variable has one tile.
+    template <int D>
+    static void tiles(const T* A, const T* B, T* C, int n, const int* step, box b) {
+        if constexpr (D == 3) {
+            points<false>(A, B, C, n, b);
+        } else {
+            constexpr int v = order[D];
+            for (int t = 0; t < n; t += step[v]) {
+                b.lo[v] = t;
+                b.hi[v] = std::min(t + step[v], n);
+                tiles<D + 1>(A, B, C, n, step, b);
+            }
+        }
+    }
+
+    // C += A * B for n x n row-major matrices. False if n != Fixed.
+    static bool run(const T* A, const T* B, T* C, int n, matmul_loop_tiles t) {
+        if (Fixed > 0 && n != Fixed) return false;
+        if (n <= 0) return true;
+        int step[3] = {t.i, t.j, t.k};
+        for (int& s : step) s = s > 0 ? std::min(s, n) : n;
+        if (step[0] == n && step[1] == n && step[2] == n)
+            points<true>(A, B, C, n, box{});
+        else
+            tiles<0>(A, B, C, n, step, box{});
+        return true;
+    }
+};
+
+template <typename T>
+struct matmul_loop_variant {
+    const char* name;
+    bool (*run)(const T*, const T*, T*, int, matmul_loop_tiles);
+};
+
+template <typename T, int Fixed = 0>
+std::vector<matmul_loop_variant<T>> matmul_loop_variants() {
+    return {
+        {"ijk", &matmul_loop_nest<T, 'i', 'j', 'k', Fixed>::run},
+        {"ikj", &matmul_loop_nest<T, 'i', 'k', 'j', Fixed>::run},
+        {"jik", &matmul_loop_nest<T, 'j', 'i', 'k', Fixed>::run},
+        {"jki", &matmul_loop_nest<T, 'j', 'k', 'i', Fixed>::run},
+        {"kij", &matmul_loop_nest<T, 'k', 'i', 'j', Fixed>::run},
+        {"kji", &matmul_loop_nest<T, 'k', 'j', 'i', Fixed>::run},
+    };
+}
+
+// The variant called 'name', or nullptr.
+template <typename T>
+const matmul_loop_variant<T>* matmul_loop_find(const std::vector<matmul_loop_variant<T>>& v,
+                                               const std::string& name) {
+    for (const auto& x : v)
+        if (name == x.name) return &x;
+    return nullptr;
+}
+
+// Bytes the untiled nest 'order' loads and stores for n x n matrices
+// of s-byte elements, for the cache-aware roofline report
+// (matmul_roofline): per innermost iteration each array costs s unless
+// it does not depend on the innermost variable (hoisted into a
+// register); C costs twice (load and store). Whether a stride-n access
+// is served by L1 or by a slower level is what the report shows, so it
+// is not part of the count.
+inline double matmul_loop_bytes(const std::string& order, int n, int s) {
+    if (order.size() != 3) return 0.0;
+    const char v = order[2];
+    auto cost = [&](char row, char col, int touches) {
+        return v == row || v == col ? (double)s * touches : 0.0;
+    };
+    double per = cost('i', 'k', 1) + cost('k', 'j', 1) + cost('i', 'j', 2);
+    return per * n * n * n;
+}
+
+// Fill A and B from matrix_random (streams 0 and 1 of 'seed') and
+// zero C.
+template <typename T>
+void matmul_loop_init(T* A, T* B, T* C, int n, uint64_t seed) {
+    matrix_random(A, (size_t)n * n, seed, 0);
+    matrix_random(B, (size_t)n * n, seed, 1);
+    memset(C, 0, sizeof(T) * (size_t)n * n);
+}
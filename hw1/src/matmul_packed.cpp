@@ -0,0 +1,94 @@
+// Fixed-weights benchmark: one K x N weight matrix B times a stream of
+// different M x K matrices A, in single precision. Compares gemm()
+// (packs B on every call) with gemm_packed() on a B packed once, and
+// with --cache=DIR loads the packed B from disk when it is already
+// there (a restart skips the packing).
+//
+//   --m=M --n=N --k=K   problem size (default 64 x N x N)
+//   --calls=R           number of A matrices (default 20)
+//   --threads=T         0 = one per physical core (default 1)
+//   --cache=DIR         packed-B cache directory
+//
+// The exit status is 1 if gemm_packed() differs from gemm() in any
+// element.
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define TOPOLOGY_IMPLEMENTATION
+#include "topology.h"
+#define TRACE_IMPLEMENTATION
+#include "trace.h"
+#include "gemm_packed.hpp"
+
+using namespace std;
+
+#ifndef N
+#define N 1024
+#endif
+
+static double seconds_since(chrono::high_resolution_clock::time_point start) {
+    return chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    int m = 64, n = N, k = N, calls = 20, threads = 1;
+    const char* cache = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (strncmp(a, "--m=", 4) == 0) m = atoi(a + 4);
+        else if (strncmp(a, "--n=", 4) == 0) n = atoi(a + 4);
+        else if (strncmp(a, "--k=", 4) == 0) k = atoi(a + 4);
+        else if (strncmp(a, "--calls=", 8) == 0) calls = max(1, atoi(a + 8));
+        else if (strncmp(a, "--threads=", 10) == 0) threads = atoi(a + 10);
+        else if (strncmp(a, "--cache=", 8) == 0) cache = a + 8;
+        else {
+            cerr << "Unknown argument: " << a << endl;
+            return 1;
+        }
+    }
+    if (threads <= 0) {
+        topo_t topo;
+        topo_discover(&topo);
+        threads = topo_default_threads(&topo);
+        topo_free(&topo);
+    }
+    cout << "Weights " << k << "x" << n << ", " << calls << " x A " << m << "x" << k
+         << ", threads: " << threads << endl;
+
+    srand(1);
+    vector<float> B((size_t)k * n), A((size_t)calls * m * k);
+    for (auto& x : B) x = (rand() % 200 - 100) / 64.0f;
+    for (auto& x : A) x = (rand() % 200 - 100) / 64.0f;
+    vector<float> C1((size_t)m * n), C2((size_t)m * n);
+
+    // Unpacked: B is packed again inside every call.
+    auto start = chrono::high_resolution_clock::now();
+    for (int r = 0; r < calls; ++r)
+        gemm(false, false, m, n, k, 1.0f, &A[(size_t)r * m * k], k, B.data(), n, 0.0f,
+             C1.data(), n, threads);
+    double t_plain = seconds_since(start);
+
+    start = chrono::high_resolution_clock::now();
+    bool loaded = false;
+    gemm_packed_b<float> W = cache ? gemm_packed_load_or_pack(cache, false, k, n, B.data(), n, &loaded)
+                                   : gemm_pack_b_matrix(false, k, n, B.data(), n);
+    double t_pack = seconds_since(start);
+
+    start = chrono::high_resolution_clock::now();
+    for (int r = 0; r < calls; ++r)
+        gemm_packed(false, m, 1.0f, &A[(size_t)r * m * k], k, W, 0.0f, C2.data(), n, threads);
+    double t_packed = seconds_since(start);
+
+    cout << "B hash: " << hex << W.hash << dec << endl;
+    cout << (loaded ? "Loaded packed B from cache: " : "Packing B: ") << t_pack << " s" << endl;
+    cout << "gemm (repacks B):  " << t_plain << " s, " << t_plain / calls * 1e3 << " ms/call" << endl;
+    cout << "gemm_packed:       " << t_packed << " s, " << t_packed / calls * 1e3 << " ms/call ("
+         << t_plain / t_packed << "x)" << endl;
+    cout << "Execution time: " << t_packed << " seconds" << endl;
+    bool identical = memcmp(C1.data(), C2.data(), sizeof(float) * C1.size()) == 0;
+    cout << "Results identical: " << (identical ? "yes" : "no") << endl;
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+// Precision benchmark: C = A * B with the packed GEMM engine in
+//
+//   double            gemm<double>
+//   float             gemm<float>
+//   float/double acc  gemm<float, gemm_acc_double>
+//   float/Kahan       gemm<float, gemm_acc_kahan>
+//
+// A and B are uniform in [-1, 1] and rounded to float, so every variant
+// multiplies the same values; the reference is that product summed in
+// long double. Errors are relative to (|A| |B|)_ij, the scale of the
+// rounding-error bound, which stays meaningful where C_ij cancels to
+// near zero.
+//
+//   --m=M --n=N --k=K   problem size (default N x N x N)
+//   --threads=T         0 = one per physical core (default 1)
+//
+// "Execution time" is the headline kernel alone, gemm<float>; the table
+// has the times of the others.
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define TOPOLOGY_IMPLEMENTATION
+#include "topology.h"
+#define TRACE_IMPLEMENTATION
+#include "trace.h"
+#include "gemm.hpp"
+
+using namespace std;
+
+#ifndef N
+#define N 1024
+#endif
+
+template <typename F>
+static double time_best(int reps, F f) {
+    double best = 1e30;
+    for (int r = 0; r < reps; ++r) {
+        auto start = chrono::high_resolution_clock::now();
+        f();
+        auto end = chrono::high_resolution_clock::now();
+        best = min(best, chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    int m = N, n = N, k = N, threads = 1;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (strncmp(a, "--m=", 4) == 0) m = atoi(a + 4);
+        else if (strncmp(a, "--n=", 4) == 0) n = atoi(a + 4);
+        else if (strncmp(a, "--k=", 4) == 0) k = atoi(a + 4);
+        else if (strncmp(a, "--threads=", 10) == 0) threads = atoi(a + 10);
+        else {
+            cerr << "Unknown argument: " << a << endl;
+            return 1;
+        }
+    }
+    if (threads <= 0) {
+        topo_t topo;
+        topo_discover(&topo);
+        threads = topo_default_threads(&topo);
+        topo_free(&topo);
+    }
+    cout << "GEMM precision " << m << "x" << k << " * " << k << "x" << n << ", threads: " << threads
+         << endl;
+
+    size_t sa = (size_t)m * k, sb = (size_t)k * n, sc = (size_t)m * n;
+    vector<float> Af(sa), Bf(sb);
+    srand(1);
+    for (auto& x : Af) x = (float)((double)rand() / RAND_MAX * 2.0 - 1.0);
+    for (auto& x : Bf) x = (float)((double)rand() / RAND_MAX * 2.0 - 1.0);
+    vector<double> Ad(Af.begin(), Af.end()), Bd(Bf.begin(), Bf.end());
+
+    // Reference and error scale, on every row for small problems and on
+    // up to 64 sampled rows otherwise.
+    int rows = min(m, 64);
+    vector<int> sample(rows);
+    for (int s = 0; s < rows; ++s) sample[s] = (int)((long long)s * m / rows);
+    vector<long double> ref((size_t)rows * n);
+    vector<double> scale((size_t)rows * n);
+    for (int s = 0; s < rows; ++s) {
+        const double* a = &Ad[(size_t)sample[s] * k];
+        for (int j = 0; j < n; ++j) {
+            long double sum = 0;
+            double mag = 0;
+            for (int p = 0; p < k; ++p) {
+                sum += (long double)a[p] * Bd[(size_t)p * n + j];
+                mag += fabs(a[p] * Bd[(size_t)p * n + j]);
+            }
+            ref[(size_t)s * n + j] = sum;
+            scale[(size_t)s * n + j] = mag > 0 ? mag : 1.0;
+        }
+    }
+    auto errors = [&](auto& C, double& max_err, double& mean_err) {
+        max_err = mean_err = 0.0;
+        for (int s = 0; s < rows; ++s)
+            for (int j = 0; j < n; ++j) {
+                size_t r = (size_t)s * n + j;
+                double e = (double)fabsl((long double)C[(size_t)sample[s] * n + j] - ref[r]) / scale[r];
+                max_err = max(max_err, e);
+                mean_err += e;
+            }
+        mean_err /= (double)rows * n;
+    };
+
+    double flops = 2.0 * m * n * k;
+    cout << left << setw(20) << "variant" << right << setw(10) << "time (s)" << setw(10)
+         << "GFLOP/s" << setw(14) << "max error" << setw(14) << "mean error" << endl;
+    auto report = [&](const char* name, double t, auto& C) {
+        double max_err, mean_err;
+        errors(C, max_err, mean_err);
+        cout << left << setw(20) << name << right << fixed << setprecision(4) << setw(10) << t
+             << setprecision(1) << setw(10) << flops / t * 1e-9 << scientific << setprecision(2)
+             << setw(14) << max_err << setw(14) << mean_err << defaultfloat << setprecision(6)
+             << endl;
+    };
+
+    vector<double> Cd(sc);
+    vector<float> Cf(sc);
+    double t = time_best(3, [&] {
+        gemm(false, false, m, n, k, 1.0, Ad.data(), k, Bd.data(), n, 0.0, Cd.data(), n, threads);
+    });
+    report("double", t, Cd);
+    double t_float = time_best(3, [&] {
+        gemm(false, false, m, n, k, 1.0f, Af.data(), k, Bf.data(), n, 0.0f, Cf.data(), n, threads);
+    });
+    report("float", t_float, Cf);
+    t = time_best(3, [&] {
+        gemm<float, gemm_acc_double>(false, false, m, n, k, 1.0f, Af.data(), k, Bf.data(), n, 0.0f,
+                                     Cf.data(), n, threads);
+    });
+    report("float/double acc", t, Cf);
+    t = time_best(3, [&] {
+        gemm<float, gemm_acc_kahan>(false, false, m, n, k, 1.0f, Af.data(), k, Bf.data(), n, 0.0f,
+                                    Cf.data(), n, threads);
+    });
+    report("float/Kahan", t, Cf);
+
+    cout << "Execution time: " << t_float << " seconds" << endl;
+}
@@ -0,0 +1,142 @@
+// Quantized GEMM benchmark. Part 1 multiplies the matmul_int inputs
+// (rand() % 100, which fit in int8) stored as int32 with gemm<int>, as
+// int16 and as int8 with qgemm, and checks that all three agree
+// exactly. Part 2 quantizes random float matrices to int8 / int16
+// (with qgemm_qmax, so the int32 products cannot saturate), multiplies
+// with qgemm and dequantizes, against gemm<float>.
+//
+//   --m=M --n=N --k=K   problem size (default N x N x N)
+//   --threads=T         0 = one per physical core (default 1)
+//
+// "Execution time" is the headline kernel alone, qgemm<int8>; the table
+// has the times of the others. The exit status is 1 if a part 1 product
+// is not exact.
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define TOPOLOGY_IMPLEMENTATION
+#include "topology.h"
+#define TRACE_IMPLEMENTATION
+#include "trace.h"
+#include "gemm_quant.hpp"
+
+using namespace std;
+
+#ifndef N
+#define N 1024
+#endif
+
+template <typename F>
+static double time_best(int reps, F f) {
+    double best = 1e30;
+    for (int r = 0; r < reps; ++r) {
+        auto start = chrono::high_resolution_clock::now();
+        f();
+        auto end = chrono::high_resolution_clock::now();
+        best = min(best, chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+static void report(const char* name, double t, double ops, size_t bytes) {
+    cout << left << setw(22) << name << right << fixed << setprecision(4) << setw(10) << t
+         << setprecision(1) << setw(10) << ops / t * 1e-9 << setw(12) << bytes / 1024 << " KiB"
+         << defaultfloat << setprecision(6);
+}
+
+int main(int argc, char** argv) {
+    int m = N, n = N, k = N, threads = 1;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (strncmp(a, "--m=", 4) == 0) m = atoi(a + 4);
+        else if (strncmp(a, "--n=", 4) == 0) n = atoi(a + 4);
+        else if (strncmp(a, "--k=", 4) == 0) k = atoi(a + 4);
+        else if (strncmp(a, "--threads=", 10) == 0) threads = atoi(a + 10);
+        else {
+            cerr << "Unknown argument: " << a << endl;
+            return 1;
+        }
+    }
+    if (threads <= 0) {
+        topo_t topo;
+        topo_discover(&topo);
+        threads = topo_default_threads(&topo);
+        topo_free(&topo);
+    }
+    cout << "Quantized GEMM " << m << "x" << k << " * " << k << "x" << n << ", threads: " << threads
+         << ", int8 words: " << (qgemm_mode_for<int8_t>() == QGEMM_U8S8 ? "VNNI u8 x s8" : "int16 pairs")
+         << endl;
+    double ops = 2.0 * m * n * k;
+    size_t sa = (size_t)m * k, sb = (size_t)k * n, sc = (size_t)m * n;
+
+    // Part 1: exact integer products.
+    vector<int> A32(sa), B32(sb), C32(sc);
+    srand(1);
+    for (auto& x : A32) x = rand() % 100;
+    for (auto& x : B32) x = rand() % 100;
+    vector<int16_t> A16(A32.begin(), A32.end()), B16(B32.begin(), B32.end());
+    vector<int8_t> A8(A32.begin(), A32.end()), B8(B32.begin(), B32.end());
+    vector<int32_t> C16(sc), C8(sc);
+
+    cout << left << setw(22) << "kernel" << right << setw(10) << "time (s)" << setw(10) << "GOP/s"
+         << setw(16) << "A+B size" << endl;
+    double t32 = time_best(3, [&] {
+        gemm(false, false, m, n, k, 1, A32.data(), k, B32.data(), n, 0, C32.data(), n, threads);
+    });
+    report("gemm<int32>", t32, ops, (sa + sb) * 4);
+    cout << endl;
+    double t16 = time_best(3, [&] { qgemm(m, n, k, A16.data(), k, B16.data(), n, C16.data(), n, threads); });
+    report("qgemm<int16>", t16, ops, (sa + sb) * 2);
+    cout << "   " << (C16 == C32 ? "exact" : "MISMATCH") << endl;
+    double t8 = time_best(3, [&] { qgemm(m, n, k, A8.data(), k, B8.data(), n, C8.data(), n, threads); });
+    report("qgemm<int8>", t8, ops, sa + sb);
+    cout << "   " << (C8 == C32 ? "exact" : "MISMATCH") << endl;
+
+    // Part 2: float -> int8 / int16 -> float.
+    vector<float> Af(sa), Bf(sb), Cf(sc), Yf(sc);
+    for (auto& x : Af) x = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+    for (auto& x : Bf) x = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+    double tf = time_best(3, [&] {
+        gemm(false, false, m, n, k, 1.0f, Af.data(), k, Bf.data(), n, 0.0f, Cf.data(), n, threads);
+    });
+    report("gemm<float>", tf, ops, (sa + sb) * 4);
+    cout << endl;
+    double norm = 0.0;
+    for (float x : Cf) norm = max(norm, (double)fabs(x));
+
+    vector<int8_t> Aq8(sa), Bq8(sb);
+    vector<int16_t> Aq16(sa), Bq16(sb);
+    vector<int32_t> Cq(sc);
+    auto quantized = [&](auto& Aq, auto& Bq, const char* name) {
+        double t = time_best(3, [&] {
+            using Q = typename std::decay<decltype(Aq[0])>::type;
+            int qmax = qgemm_qmax<Q>(k);
+            float s = qgemm_quantize(Af.data(), sa, Aq.data(), qmax) *
+                      qgemm_quantize(Bf.data(), sb, Bq.data(), qmax);
+            qgemm(m, n, k, Aq.data(), k, Bq.data(), n, Cq.data(), n, threads);
+            qgemm_dequantize(Cq.data(), n, m, n, s, Yf.data(), n);
+        });
+        double err = 0.0;
+        for (size_t i = 0; i < sc; ++i) err = max(err, (double)fabs(Yf[i] - Cf[i]));
+        report(name, t, ops, (sa + sb) * sizeof(Aq[0]));
+        cout << "   max error " << scientific << setprecision(2) << err / norm << " of max|C|"
+             << defaultfloat << setprecision(6) << endl;
+        return t;
+    };
+    quantized(Aq16, Bq16, "quantized int16");
+    quantized(Aq8, Bq8, "quantized int8");
+
+    bool exact = C16 == C32 && C8 == C32;
+    cout << "Verification: " << (exact ? "passed" : "FAILED") << " (qgemm exact vs gemm<int32>)"
+         << endl;
+    cout << "Execution time: " << t8 << " seconds" << endl;
+    double checksum = 0;
+    for (int32_t x : C8) checksum += x;
+    cout << "Checksum: " << checksum << endl;
+    return exact ? 0 : 1;
+}
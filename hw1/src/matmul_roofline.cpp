@@ -0,0 +1,171 @@
+// Roofline report: runs the double-precision matmul variants (the six
+// loop orders, unroll-and-jam register tiles, tiled and the packed
+// GEMM) and places each one on the cache-aware roofline of this host
+// (roofline.h): the arithmetic intensity from the bytes each variant's
+// loads and stores move, measured GFLOP/s, the attainable roof, the
+// headroom left and the slowest memory level that could still feed the
+// achieved rate. The roofs are measured once per host and thread count
+// and kept in $ROOFLINE.
+//
+// Bytes loaded and stored (n^3 multiply-adds, s-byte elements):
+//   loop orders   s per array the innermost loop walks, C twice
+//                 (matmul_loop_bytes)
+//   RI x RJ       n^3 s (1/RI + 1/RJ): RI + RJ loads per k step
+//   tiled         3 n^3 s: inner ikj loop loads B and C, stores C
+//   gemm          n^3 s (1/MR + 1/NR + 2/nc + 2/kc) + 2 n^2 s: micro-kernel
+//                 loads, A packing per nc panel, C per kc block, B packing
+//
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define TOPOLOGY_IMPLEMENTATION
+#include "topology.h"
+#define TRACE_IMPLEMENTATION
+#include "trace.h"
+#define ROOFLINE_IMPLEMENTATION
+#include "roofline.h"
+#include "gemm.hpp"
+#include "matmul_loops.hpp"
+#include "matmul_tiled.hpp"
+#include "matmul_unrolled.hpp"
+#include "matrix_init.hpp"
+
+using namespace std;
+
+#ifndef N
+#define N 1024
+#endif
+
+#ifndef TILE
+#define TILE 0
+#endif
+
+#ifndef UNROLL
+#define UNROLL 4
+#endif
+
+// One roof_point_t per variant; names are kept alive here.
+struct roof_run {
+    string name;
+    double bytes;
+    function<void(const double*, const double*, double*)> fn;
+};
+
+static bool measure(const roof_run& r, const vector<double>& A,
+                    const vector<double>& B, vector<double>& C, vector<roof_point_t>& pts) {
+    fill(C.begin(), C.end(), 0.0);
+    auto start = chrono::high_resolution_clock::now();
+    r.fn(A.data(), B.data(), C.data());
+    auto end = chrono::high_resolution_clock::now();
+    roof_point_t p;
+    p.name = r.name.c_str();
+    p.flops = 2.0 * N * N * N;
+    p.bytes = r.bytes;
+    p.seconds = chrono::duration<double>(end - start).count();
+    p.level = ROOF_L1;
+    p.f32 = 0;
+    pts.push_back(p);
+    bool ok = freivalds_check(A.data(), B.data(), C.data(), N).ok;
+    if (!ok) cerr << "Error: " << r.name << " failed verification" << endl;
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    int threads = 1;
+    bool remeasure = false;
+    const char* csv = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (strncmp(a, "--threads=", 10) == 0) threads = atoi(a + 10);
+        else if (strcmp(a, "--measure") == 0) remeasure = true;
+        else if (strncmp(a, "--csv=", 6) == 0) csv = a + 6;
+        else {
+            cerr << "Unknown argument: " << a << endl;
+            return 1;
+        }
+    }
+    topo_t topo;
+    topo_discover(&topo);
+    if (threads <= 0) threads = topo_default_threads(&topo);
+    const int s = sizeof(double);
+    // The tile matmul_tiling uses by default, so the "tiled" point is the
+    // kernel that program runs.
+    const int tile = TILE > 0 ? TILE : topo_matmul_tile(&topo, sizeof(int));
+    gemm_blocking bs = gemm_default_blocking<double>();
+    cout << "Matrix size: " << N << "x" << N << " (double), threads: " << threads << endl;
+
+    vector<roof_run> single, threaded;
+    for (const auto& v : matmul_loop_variants<double, N>()) {
+        auto run = v.run;
+        single.push_back({v.name, matmul_loop_bytes(v.name, N, s),
+                          [run](const double* A, const double* B, double* C) {
+                              run(A, B, C, N, matmul_loop_tiles());
+                          }});
+    }
+    single.push_back({"unrolled 1x1", (double)N * N * N * s * 2.0,
+                      [](const double* A, const double* B, double* C) {
+                          matmul_unrolled<double, 1, 1, UNROLL>(A, B, C, N);
+                      }});
+    single.push_back({"unrolled 4x8", (double)N * N * N * s * (1.0 / 4 + 1.0 / 8),
+                      [](const double* A, const double* B, double* C) {
+                          matmul_unrolled<double, 4, 8, UNROLL>(A, B, C, N);
+                      }});
+    single.push_back({"unrolled 8x16", (double)N * N * N * s * (1.0 / 8 + 1.0 / 16),
+                      [](const double* A, const double* B, double* C) {
+                          matmul_unrolled<double, 8, 16, UNROLL>(A, B, C, N);
+                      }});
+    threaded.push_back({"tiled T=" + to_string(tile), 3.0 * N * N * N * s,
+                        [=](const double* A, const double* B, double* C) {
+                            matmul_tiled(A, B, C, N, tile, threads);
+                        }});
+    const double mr = gemm_shape<double>::MR, nr = gemm_shape<double>::NR;
+    threaded.push_back({"gemm",
+                        (double)N * N * N * s * (1 / mr + 1 / nr + 2.0 / bs.nc + 2.0 / bs.kc) +
+                            2.0 * N * N * s,
+                        [=](const double* A, const double* B, double* C) {
+                            gemm(false, false, N, N, N, 1.0, A, N, B, N, 0.0, C, N, threads, bs);
+                        }});
+    if (threads == 1) {
+        single.insert(single.end(), threaded.begin(), threaded.end());
+        threaded.clear();
+    }
+
+    vector<double> A((size_t)N * N), B((size_t)N * N), C((size_t)N * N);
+    uint64_t seed = matrix_default_seed();
+    matrix_random(A.data(), A.size(), seed, 0);
+    matrix_random(B.data(), B.size(), seed, 1);
+
+    FILE* out = nullptr;
+    if (csv && !(out = fopen(csv, "w"))) {
+        cerr << "Error: cannot write " << csv << endl;
+        return 1;
+    }
+    bool ok = true;
+    double total = 0.0;
+    for (int g = 0; g < 2; ++g) {
+        const vector<roof_run>& runs = g == 0 ? single : threaded;
+        if (runs.empty()) continue;
+        int t = g == 0 ? 1 : threads;
+        roof_machine_t m;
+        roof_get(&m, &topo, t, roof_default_path(), remeasure);
+        roof_print_machine(&m, stdout);
+        vector<roof_point_t> pts;
+        for (const auto& r : runs) ok &= measure(r, A, B, C, pts);
+        for (const auto& p : pts) total += p.seconds;
+        roof_report(&m, pts.data(), (int)pts.size(), stdout);
+        if (out) roof_write_csv(&m, pts.data(), (int)pts.size(), out);
+    }
+    if (out) {
+        fclose(out);
+        cout << "Wrote " << csv << endl;
+    }
+    topo_free(&topo);
+    cout << "Verification: " << (ok ? "passed" : "FAILED") << " (Freivalds, 16 rounds)" << endl;
+    cout << "Execution time: " << total << " seconds" << endl;
+    return ok ? 0 : 1;
+}
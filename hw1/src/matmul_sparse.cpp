@@ -0,0 +1,171 @@
+// Sparse vs dense benchmark: for a sweep of densities, multiplies a
+// dense N x N matrix D by a sparse S (and S by D) with gemm<double> and
+// with the sparse.hpp kernels, and reports the density below which
+// each sparse kernel wins (the crossover).
+//
+//   --pattern=random|block|skewed  nonzeros uniform, in BR x BC blocks,
+//                                  or with a power-law number per row
+//   --block=BRxBC                  BCSR block shape (default 4x8)
+//   --threads=T                    0 = one per physical core (default 1)
+//
+// The exit status is 1 if a sparse kernel differs from gemm / gemv by
+// more than 2 * N * DBL_EPSILON (relative, at least 1 in magnitude).
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define TOPOLOGY_IMPLEMENTATION
+#include "topology.h"
+#define TRACE_IMPLEMENTATION
+#include "trace.h"
+#include "gemm.hpp"
+#include "sparse.hpp"
+
+using namespace std;
+
+#ifndef N
+#define N 1024
+#endif
+
+template <typename F>
+static double time_best(int reps, F f) {
+    double best = 1e30;
+    for (int r = 0; r < reps; ++r) {
+        auto start = chrono::high_resolution_clock::now();
+        f();
+        auto end = chrono::high_resolution_clock::now();
+        best = min(best, chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+static double max_diff(const vector<double>& x, const vector<double>& y) {
+    double d = 0.0;
+    for (size_t i = 0; i < x.size(); ++i) d = max(d, fabs(x[i] - y[i]) / max(1.0, fabs(y[i])));
+    return d;
+}
+
+static double uniform() { return (double)rand() / RAND_MAX; }
+
+// N x N matrix with about 'density' nonzeros.
+static vector<double> make_sparse(const string& pattern, double density, int br, int bc) {
+    vector<double> S((size_t)N * N, 0.0);
+    if (pattern == "block") {
+        for (int bi = 0; bi < N; bi += br)
+            for (int bj = 0; bj < N; bj += bc) {
+                if (uniform() >= density) continue;
+                for (int i = bi; i < min(N, bi + br); ++i)
+                    for (int j = bj; j < min(N, bj + bc); ++j) S[(size_t)i * N + j] = uniform() - 0.5;
+            }
+    } else {
+        // skewed: row i is weighted by 1 / sqrt(i + 1), scaled to mean 1.
+        double norm = 0.0;
+        for (int i = 0; i < N; ++i) norm += 1.0 / sqrt(i + 1.0);
+        for (int i = 0; i < N; ++i) {
+            double p = pattern == "skewed" ? min(1.0, density * N / norm / sqrt(i + 1.0)) : density;
+            for (int j = 0; j < N; ++j)
+                if (uniform() < p) S[(size_t)i * N + j] = uniform() - 0.5;
+        }
+    }
+    return S;
+}
+
+int main(int argc, char** argv) {
+    string pattern = "random";
+    int br = 4, bc = 8, threads = 1;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (strncmp(a, "--pattern=", 10) == 0) pattern = a + 10;
+        else if (strncmp(a, "--block=", 8) == 0 && sscanf(a + 8, "%dx%d", &br, &bc) == 2) {}
+        else if (strncmp(a, "--threads=", 10) == 0) threads = atoi(a + 10);
+        else {
+            cerr << "Unknown argument: " << a << endl;
+            return 1;
+        }
+    }
+    if (pattern != "random" && pattern != "block" && pattern != "skewed") {
+        cerr << "Error: unknown pattern '" << pattern << "'" << endl;
+        return 1;
+    }
+    if (br <= 0 || bc <= 0) {
+        cerr << "Error: bad block shape" << endl;
+        return 1;
+    }
+    if (threads <= 0) {
+        topo_t topo;
+        topo_discover(&topo);
+        threads = topo_default_threads(&topo);
+        topo_free(&topo);
+    }
+    cout << "Sparse " << N << "x" << N << ", pattern " << pattern << ", BCSR " << br << "x" << bc
+         << ", threads: " << threads << endl;
+
+    srand(1);
+    vector<double> D((size_t)N * N), x(N), C((size_t)N * N), ref((size_t)N * N), y(N), yref(N);
+    for (auto& v : D) v = uniform() - 0.5;
+    for (auto& v : x) v = uniform() - 0.5;
+
+    const double densities[] = {0.5, 0.2, 0.1, 0.05, 0.02, 0.01, 0.005, 0.001};
+    double flops = 2.0 * N * N * N;
+    cout << setw(8) << "density" << setw(10) << "dense" << setw(11) << "D*S csr" << setw(11)
+         << "D*S bcsr" << setw(11) << "S*D csr" << setw(10) << "gemv" << setw(10) << "spmv csr"
+         << setw(10) << "spmv csc" << setw(12) << "max diff" << "   (GEMM s, GEMV us)" << endl;
+
+    double cross_b = 0.0, cross_a = 0.0, total = 0.0, worst = 0.0;
+    for (double d : densities) {
+        vector<double> S = make_sparse(pattern, d, br, bc);
+        csr_matrix<double> Sr = csr_from_dense(N, N, S.data(), N);
+        csc_matrix<double> Sc = csc_from_dense(N, N, S.data(), N);
+        bcsr_matrix<double> Sb = bcsr_from_dense(N, N, S.data(), N, br, bc);
+
+        // Dense reference D * S; S * D costs the same with gemm.
+        double t_dense = time_best(2, [&] {
+            gemm(false, false, N, N, N, 1.0, D.data(), N, S.data(), N, 0.0, ref.data(), N, threads);
+        });
+        double diff = 0.0;
+        double t_csr = time_best(2, [&] { spmm(N, D.data(), N, Sr, C.data(), N, threads); });
+        diff = max(diff, max_diff(C, ref));
+        double t_bcsr = time_best(2, [&] { spmm(N, D.data(), N, Sb, C.data(), N, threads); });
+        diff = max(diff, max_diff(C, ref));
+        gemm(false, false, N, N, N, 1.0, S.data(), N, D.data(), N, 0.0, ref.data(), N, threads);
+        double t_a = time_best(2, [&] { spmm(Sr, D.data(), N, N, C.data(), N, threads); });
+        diff = max(diff, max_diff(C, ref));
+
+        double t_gemv = time_best(3, [&] {
+            for (int i = 0; i < N; ++i) {
+                double sum = 0.0;
+                for (int j = 0; j < N; ++j) sum += S[(size_t)i * N + j] * x[j];
+                yref[i] = sum;
+            }
+        });
+        double t_spmv = time_best(3, [&] { spmv(Sr, x.data(), y.data(), threads); });
+        diff = max(diff, max_diff(y, yref));
+        double t_spmv_c = time_best(3, [&] { spmv(Sc, x.data(), y.data()); });
+        diff = max(diff, max_diff(y, yref));
+
+        worst = max(worst, diff);
+        if (min(t_csr, t_bcsr) < t_dense) cross_b = max(cross_b, d);
+        if (t_a < t_dense) cross_a = max(cross_a, d);
+        total += t_csr;
+        cout << setw(7) << d * 100 << "%" << fixed << setprecision(4) << setw(10) << t_dense
+             << setw(11) << t_csr << setw(11) << t_bcsr << setw(11) << t_a << setprecision(1)
+             << setw(10) << t_gemv * 1e6 << setw(10) << t_spmv * 1e6 << setw(10) << t_spmv_c * 1e6
+             << scientific << setw(12) << diff << defaultfloat << setprecision(6) << "   nnz "
+             << Sr.nnz() << ", blocks " << Sb.blocks() << endl;
+    }
+    cout << "Dense GEMM: " << flops * 1e-9 << " GFLOP per product" << endl;
+    cout << "Crossover D*S (sparse B faster than dense): ";
+    if (cross_b > 0) cout << "density <= " << cross_b * 100 << "%" << endl; else cout << "none" << endl;
+    cout << "Crossover S*D (sparse A faster than dense): ";
+    if (cross_a > 0) cout << "density <= " << cross_a * 100 << "%" << endl; else cout << "none" << endl;
+    bool passed = worst <= 2.0 * N * DBL_EPSILON;
+    cout << "Verification: " << (passed ? "passed" : "FAILED") << " (vs gemm / gemv)" << endl;
+    cout << "Execution time: " << total << " seconds" << endl;
+    return passed ? 0 : 1;
+}
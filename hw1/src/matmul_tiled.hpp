@@ -0,0 +1,94 @@
+// Tiled (blocked) matrix multiplication with the tile size and thread
+// count chosen at runtime, so they can come from the tuning database
+// instead of the TILE macro.
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "topology.h"
+#include "trace.h"
+
+// C[row_begin..row_end) += A * B for N x N row-major matrices.
+// ii-kk-jj outer blocks, inner ikj; each row of tiles is a trace.h
+// scope.
+template <typename T>
+void matmul_tiled_rows(const T* A, const T* B, T* C, int n, int tile,
+                       int row_begin, int row_end) {
+    for (int ii = row_begin; ii < row_end; ii += tile) {
+        TRACE_SCOPE_ARG("row tile", ii);
+        int iimax = std::min(ii + tile, row_end);
+        for (int kk = 0; kk < n; kk += tile) {
+            int kkmax = std::min(kk + tile, n);
+            for (int jj = 0; jj < n; jj += tile) {
+                int jjmax = std::min(jj + tile, n);
+                for (int i = ii; i < iimax; ++i) {
+                    T* Ci = &C[i * n];
+                    for (int k = kk; k < kkmax; ++k) {
+                        T aik = A[i * n + k];
+                        const T* Bk = &B[k * n];
+                        for (int j = jj; j < jjmax; ++j) {
+                            Ci[j] += aik * Bk[j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Run f(begin, end) on rows [0, rows) split into one band of whole row
+// tiles per thread; thread t is pinned to cpus[t] when cpus is given.
+template <typename F>
+void for_each_row_band(int rows, int tile, int threads, const int* cpus, F f) {
+    if (threads <= 1) {
+        f(0, rows);
+        return;
+    }
+    int tiles = (rows + tile - 1) / tile;
+    threads = std::min(threads, tiles);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        int begin = (tiles * t / threads) * tile;
+        int end = std::min((tiles * (t + 1) / threads) * tile, rows);
+        int cpu = cpus ? cpus[t] : -1;
+        pool.emplace_back([=] {
+            if (cpu >= 0) topo_pin_thread(cpu);
+            if (trace_on) {
+                char name[32];
+                snprintf(name, sizeof(name), "band %d", t);
+                trace_thread_name(name);
+            }
+            f(begin, end);
+        });
+    }
+    for (auto& th : pool) th.join();
+}
+
+// Rows [0, rows) of C += A * B, split into one band of whole row tiles
+// per thread.
+template <typename T>
+void matmul_tiled(const T* A, const T* B, T* C, int n, int tile, int threads,
+                  int rows, const int* cpus = nullptr) {
+    for_each_row_band(rows, tile, threads, cpus, [=](int begin, int end) {
+        matmul_tiled_rows(A, B, C, n, tile, begin, end);
+    });
+}
+
+template <typename T>
+void matmul_tiled(const T* A, const T* B, T* C, int n, int tile, int threads) {
+    matmul_tiled(A, B, C, n, tile, threads, n);
+}
+
+// Zero an n x n matrix band by band from the threads that will compute
+// those rows (same split and pinning as matmul_tiled), so on NUMA
+// machines the first touch puts each band on its thread's node.
+template <typename T>
+void matmul_first_touch(T* M, int n, int tile, int threads, const int* cpus) {
+    for_each_row_band(n, tile, threads, cpus, [=](int begin, int end) {
+        std::memset(M + (size_t)begin * n, 0, sizeof(T) * (size_t)(end - begin) * n);
+    });
+}
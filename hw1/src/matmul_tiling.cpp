@@ -1,7 +1,20 @@
 #include <iostream>
 #include <chrono>
 #include <cstdlib>
-#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define TUNEDB_IMPLEMENTATION
+#include "tunedb.h"
+#define TOPOLOGY_IMPLEMENTATION
+#include "topology.h"
+#define TRACE_IMPLEMENTATION
+#include "trace.h"
+#define ARENA_IMPLEMENTATION
+#include "arena.h"
+#include "matmul_tiled.hpp"
+#include "matrix_init.hpp"
 
 using namespace std;
 
@@ -9,58 +22,145 @@ using namespace std;
 #define N 1024
 #endif
 
+// 0 = derive the tile size from the L1d size (topology.h)
 #ifndef TILE
-#define TILE 32
+#define TILE 0
 #endif
 
-int main() {
+int main(int argc, char** argv) {
     // const int N = 1024; // Start small (e.g., 512) and scale up later
+    // $TRACE=FILE records the phases, bands and row tiles (trace.h).
+    trace_init(nullptr);
     cout << "Matrix size: " << N << "x" << N << endl;
-    int* A = new int[N * N];
-    int* B = new int[N * N];
-    int* C = new int[N * N]();
 
-    for (int i = 0; i < N * N; ++i) {
-        A[i] = rand() % 100;
-        B[i] = rand() % 100;
+    // Default tile: TILE if given at build time, otherwise derived from
+    // the cache hierarchy of this machine.
+    topo_t topo;
+    topo_discover(&topo);
+    int tile = TILE > 0 ? TILE : topo_matmul_tile(&topo, sizeof(int));
+    int threads = 1;
+
+    bool tuned = false;
+    bool show_topo = false;
+    int threads_arg = -1;
+    bool huge = false;
+    const char* affinity = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--tuned") == 0) {
+            tuned = true;
+        } else if (strcmp(argv[i], "--huge") == 0) {
+            huge = true;
+        } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            threads_arg = atoi(argv[i] + 10);
+        } else if (strncmp(argv[i], "--affinity=", 11) == 0) {
+            affinity = argv[i] + 11;
+        } else if (strcmp(argv[i], "--topo") == 0) {
+            show_topo = true;
+            topo_print(&topo, stdout);
+            vector<int> cpus(topo_default_threads(&topo));
+            topo_default_placement(&topo, (int)cpus.size(), cpus.data());
+            cout << "Default tile: " << topo_matmul_tile(&topo, sizeof(int))
+                 << ", threads: " << cpus.size() << " on CPUs";
+            for (int c : cpus) cout << " " << c;
+            cout << endl;
+        }
+    }
+
+    // --tuned: take tile size and thread count from the tuning database
+    // written by matmul_autotune (falls back to the defaults above).
+    if (tuned) {
+        char host[TUNEDB_FIELD], params[TUNEDB_FIELD];
+        tunedb_host_key(host, sizeof(host));
+        string problem = "N=" + to_string(N);
+        int rc = tunedb_lookup(tunedb_default_path(), host, "matmul_tiling",
+                               problem.c_str(), params, sizeof(params));
+        if (rc >= 0) {
+            tile = tunedb_param_int(params, "tile", tile);
+            threads = tunedb_param_int(params, "threads", 1);
+        } else {
+            cout << "No tuning result in " << tunedb_default_path() << ", using defaults" << endl;
+        }
+    }
+    // --threads=N overrides the thread count (0 = one per physical core).
+    if (threads_arg >= 0) {
+        threads = threads_arg > 0 ? threads_arg : topo_default_threads(&topo);
     }
+    cout << "Tile size: " << tile << ", threads: " << threads << endl;
 
+    // --affinity=compact|scatter|none|<cpu list>: pin the row-band threads.
+    // Without it, several threads follow the default placement (scatter).
+    vector<int> cpus(max(threads, 1));
+    const int* pin = nullptr;
+    if (affinity || threads > 1) {
+        const char* placement = affinity ? affinity : "scatter";
+        int rc = topo_affinity_cpus(&topo, placement, (int)cpus.size(), cpus.data());
+        if (rc < 0) {
+            cerr << "Error: bad affinity '" << placement << "'" << endl;
+            topo_free(&topo);
+            return 1;
+        }
+        if (rc == 0) {
+            pin = cpus.data();
+            cout << "Affinity " << placement << (affinity ? "" : " (default)") << ": CPUs";
+            for (int c : cpus) cout << " " << c;
+            cout << endl;
+        }
+    }
+
+    // A, B and C come from one 64-byte aligned arena; --huge backs it
+    // with 2 MiB pages. With several threads, every band is first
+    // touched by the thread that computes it; filling the values
+    // afterwards (matrix_random, in parallel) does not move the pages.
+    trace_scope_t init = trace_begin("init");
+    size_t bytes = sizeof(int) * (size_t)N * N;
+    arena_t arena;
+    if (arena_init(&arena, 3 * (bytes + ARENA_ALIGN), huge ? ARENA_HUGE : 0) != 0) {
+        cerr << "Error: could not map matrices" << endl;
+        topo_free(&topo);
+        return 1;
+    }
+    int* A = (int*)arena_alloc(&arena, bytes);
+    int* B = (int*)arena_alloc(&arena, bytes);
+    int* C = (int*)arena_alloc(&arena, bytes);
+    matmul_first_touch(A, N, tile, threads, pin);
+    matmul_first_touch(B, N, tile, threads, pin);
+    matmul_first_touch(C, N, tile, threads, pin);
+
+    uint64_t seed = matrix_default_seed();
+    matrix_random(A, (size_t)N * N, seed, 0, threads);
+    matrix_random(B, (size_t)N * N, seed, 1, threads);
+    trace_end(&init);
+    if (huge) {
+        cout << "Pages: " << arena_pages_name(&arena) << ", "
+             << arena_huge_bytes(&arena) / (1 << 20) << " MiB on huge pages" << endl;
+    }
+    if (affinity || show_topo) {
+        topo_print_buffer_nodes(&topo, "A", A, bytes, stdout);
+        topo_print_buffer_nodes(&topo, "B", B, bytes, stdout);
+        topo_print_buffer_nodes(&topo, "C", C, bytes, stdout);
+    }
+
+    trace_scope_t multiply = trace_begin("multiply");
     auto start = chrono::high_resolution_clock::now();
 
     // Matrix multiplication
     // Tiled (blocked) matrix multiplication: ii-kk-jj outer blocks, inner ikj
-    for (int ii = 0; ii < N; ii += TILE) {
-        int iimax = std::min(ii + TILE, N);
-        for (int kk = 0; kk < N; kk += TILE) {
-            int kkmax = std::min(kk + TILE, N);
-            for (int jj = 0; jj < N; jj += TILE) {
-                int jjmax = std::min(jj + TILE, N);
-                for (int i = ii; i < iimax; ++i) {
-                    int* Ci = &C[i * N];
-                    for (int k = kk; k < kkmax; ++k) {
-                        int aik = A[i * N + k];
-                        const int* Bk = &B[k * N];
-                        for (int j = jj; j < jjmax; ++j) {
-                            Ci[j] += aik * Bk[j];
-                        }
-                    }
-                }
-            }
-        }
-    }
+    matmul_tiled(A, B, C, N, tile, threads, N, pin);
 
     auto end = chrono::high_resolution_clock::now();
+    trace_end(&multiply);
 
     double time_taken = chrono::duration<double>(end - start).count();
     cout << "Execution time: " << time_taken << " seconds" << endl;
 
-    double checksum = 0;
-    for (int i = 0; i < N * N; ++i)
-        checksum += C[i];
-
-    cout << "Checksum: " << checksum << endl;
+    trace_scope_t verify = trace_begin("verify");
+    freivalds_result v = freivalds_check(A, B, C, N);
+    trace_end(&verify);
+    cout << "Verification: " << (v.ok ? "passed" : "FAILED") << " (Freivalds, " << v.rounds
+         << " rounds)" << endl;
 
-    delete[] A;
-    delete[] B;
-    delete[] C;
-}
\ No newline at end of file
+    arena_release(&arena);
+    topo_free(&topo);
+    trace_finish();
+    return v.ok ? 0 : 1;
+}
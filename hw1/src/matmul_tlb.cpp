@@ -0,0 +1,173 @@
+// dTLB benchmark: the ijk and jki loop orders (strided walks over B
+// resp. A and C) with the matrices in new[] memory, in a 4 KiB-page
+// arena and in a 2 MiB huge-page arena (../common/arena.h). Each
+// repetition resets the arena and allocates again, so later
+// repetitions reuse the pages faulted in by the first one.
+// dTLB load misses are counted with perf_event_open. The exit status is
+// 1 if any repetition fails verification.
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define ARENA_IMPLEMENTATION
+#include "arena.h"
+#include "matrix_init.hpp"
+
+using namespace std;
+
+#ifndef N
+#define N 1024
+#endif
+
+static void matmul_ijk(const int* A, const int* B, int* C) {
+    for (int i = 0; i < N; ++i)
+        for (int j = 0; j < N; ++j) {
+            int sum = 0;
+            for (int k = 0; k < N; ++k)
+                sum += A[i * N + k] * B[k * N + j];
+            C[i * N + j] = sum;
+        }
+}
+
+static void matmul_jki(const int* A, const int* B, int* C) {
+    memset(C, 0, sizeof(int) * N * N);
+    for (int j = 0; j < N; ++j)
+        for (int k = 0; k < N; ++k) {
+            int bkj = B[k * N + j];
+            for (int i = 0; i < N; ++i) {
+                C[i * N + j] += A[i * N + k] * bkj;
+            }
+        }
+}
+
+// User-space dTLB load misses of this thread, or -1 if the PMU is not
+// available (VMs, perf_event_paranoid).
+static int open_dtlb_counter() {
+    perf_event_attr pe;
+    memset(&pe, 0, sizeof(pe));
+    pe.type = PERF_TYPE_HW_CACHE;
+    pe.size = sizeof(pe);
+    pe.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    pe.disabled = 1;
+    pe.exclude_kernel = 1;
+    pe.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &pe, 0, -1, -1, 0);
+}
+
+struct Result {
+    double seconds;
+    long long misses;
+    bool verified;
+};
+
+static Result run(void (*kernel)(const int*, const int*, int*),
+                  const int* A, const int* B, int* C, int counter) {
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    auto start = chrono::high_resolution_clock::now();
+    kernel(A, B, C);
+    auto end = chrono::high_resolution_clock::now();
+    long long misses = -1;
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter, &misses, sizeof(misses)) != sizeof(misses)) misses = -1;
+    }
+    return {chrono::duration<double>(end - start).count(), misses,
+            freivalds_check(A, B, C, N).ok};
+}
+
+static void fill(int* A, int* B) {
+    matrix_random(A, (size_t)N * N, matrix_default_seed(), 0);
+    matrix_random(B, (size_t)N * N, matrix_default_seed(), 1);
+}
+
+int main(int argc, char** argv) {
+    int reps = 3;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--reps=", 7) == 0) reps = max(1, atoi(argv[i] + 7));
+    }
+    cout << "Matrix size: " << N << "x" << N << ", best of " << reps << " repetitions" << endl;
+
+    int counter = open_dtlb_counter();
+    if (counter < 0) cout << "dTLB counter unavailable (perf_event_open failed), timing only" << endl;
+
+    struct Order {
+        const char* name;
+        void (*kernel)(const int*, const int*, int*);
+    };
+    const Order orders[] = {{"ijk", matmul_ijk}, {"jki", matmul_jki}};
+    size_t bytes = sizeof(int) * (size_t)N * N;
+
+    cout << left << setw(6) << "order" << setw(10) << "memory" << right << setw(12) << "time (s)"
+         << setw(18) << "dTLB misses" << setw(12) << "vs 4k" << setw(12) << "huge MiB" << endl;
+    bool failed = false;
+    for (const Order& o : orders) {
+        long long misses_4k = -1;
+        for (int mode = 0; mode < 3; ++mode) {
+            // mode 0: new[], mode 1: 4 KiB arena, mode 2: huge-page arena
+            arena_t arena;
+            int* heap = nullptr;
+            if (mode == 0) {
+                heap = new int[3 * (size_t)N * N];
+            } else if (arena_init(&arena, 3 * bytes + 3 * ARENA_ALIGN,
+                                  mode == 2 ? ARENA_HUGE : ARENA_NO_HUGE) != 0) {
+                cerr << "Error: could not map arena" << endl;
+                return 1;
+            }
+
+            Result best{1e30, -1, false};
+            bool all_verified = true;
+            for (int r = 0; r < reps; ++r) {
+                int *A, *B, *C;
+                if (mode == 0) {
+                    A = heap;
+                    B = heap + (size_t)N * N;
+                    C = heap + 2 * (size_t)N * N;
+                } else {
+                    arena_reset(&arena);
+                    A = (int*)arena_alloc(&arena, bytes);
+                    B = (int*)arena_alloc(&arena, bytes);
+                    C = (int*)arena_alloc(&arena, bytes);
+                }
+                fill(A, B);
+                Result res = run(o.kernel, A, B, C, counter);
+                all_verified = all_verified && res.verified;
+                if (res.seconds < best.seconds) best = res;
+            }
+
+            string memory = mode == 0 ? "new[]" : arena_pages_name(&arena);
+            cout << left << setw(6) << o.name << setw(10) << memory << right << fixed
+                 << setprecision(4) << setw(12) << best.seconds << setw(18);
+            if (best.misses >= 0) cout << best.misses; else cout << "n/a";
+            cout << setw(12);
+            if (mode == 1) misses_4k = best.misses;
+            if (mode == 2 && misses_4k > 0 && best.misses >= 0) {
+                cout << setprecision(1) << showpos
+                     << 100.0 * (best.misses - misses_4k) / misses_4k << "%" << noshowpos;
+            } else {
+                cout << "";
+            }
+            cout << setw(12);
+            if (mode == 0) cout << "-"; else cout << arena_huge_bytes(&arena) / (1 << 20);
+            cout << defaultfloat << setprecision(6) << "   "
+                 << (all_verified ? "verified" : "FAILED") << endl;
+            failed = failed || !all_verified;
+
+            if (mode == 0) delete[] heap; else arena_release(&arena);
+        }
+    }
+    if (counter >= 0) close(counter);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,109 @@
+// Unroll-and-jam matrix multiplication with the register tile and the
+// k unroll factor as template parameters:
+//
+//     matmul_unrolled<int, 4, 16, 4>(A, B, C, n);
+//
+// C is walked in RI x RJ tiles. Each tile keeps RI * RJ independent
+// accumulators (RI rows of A broadcast against RJ contiguous columns of
+// B), so consecutive adds no longer depend on each other and the RJ
+// columns map onto vector registers; the k loop is unrolled UK times.
+// Both unrollings are generated by unroll_for<> at compile time, so any
+// tile shape or factor is one instantiation away. Rows and columns left
+// over at the edges run the same loop with runtime extents.
+//
+// matmul_unrolled_variants<T, UK>() lists the tile shapes the sweep in
+// matmul_unrolling compares.
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+// f(std::integral_constant<int, 0>) .. f(std::integral_constant<int, U - 1>),
+// expanded at compile time.
+template <int U, typename F, int... Is>
+inline void unroll_for_impl(F&& f, std::integer_sequence<int, Is...>) {
+    (f(std::integral_constant<int, Is>()), ...);
+}
+
+template <int U, typename F>
+inline void unroll_for(F&& f) {
+    unroll_for_impl<U>(f, std::make_integer_sequence<int, U>());
+}
+
+// C[i0 .. i0 + RI) x [j0 .. j0 + RJ) = A * B over k = 0 .. n.
+template <typename T, int RI, int RJ, int UK>
+inline void matmul_unrolled_tile(const T* A, const T* B, T* C, int n, int i0, int j0) {
+    T acc[RI][RJ] = {};
+    auto step = [&](int k) {
+        const T* Bk = &B[(size_t)k * n + j0];
+        unroll_for<RI>([&](auto ii) {
+            T a = A[(size_t)(i0 + ii) * n + k];
+            unroll_for<RJ>([&](auto jj) { acc[ii][jj] += a * Bk[jj]; });
+        });
+    };
+    int k = 0;
+    for (; k + UK <= n; k += UK) unroll_for<UK>([&](auto u) { step(k + u); });
+    for (; k < n; ++k) step(k);
+    for (int ii = 0; ii < RI; ++ii)
+        for (int jj = 0; jj < RJ; ++jj) C[(size_t)(i0 + ii) * n + j0 + jj] = acc[ii][jj];
+}
+
+// Edge tile of m <= RI rows and w <= RJ columns.
+template <typename T, int RI, int RJ>
+inline void matmul_unrolled_edge(const T* A, const T* B, T* C, int n, int i0, int j0, int m,
+                                 int w) {
+    T acc[RI][RJ] = {};
+    for (int k = 0; k < n; ++k) {
+        const T* Bk = &B[(size_t)k * n + j0];
+        for (int ii = 0; ii < m; ++ii) {
+            T a = A[(size_t)(i0 + ii) * n + k];
+            for (int jj = 0; jj < w; ++jj) acc[ii][jj] += a * Bk[jj];
+        }
+    }
+    for (int ii = 0; ii < m; ++ii)
+        for (int jj = 0; jj < w; ++jj) C[(size_t)(i0 + ii) * n + j0 + jj] = acc[ii][jj];
+}
+
+// C = A * B for n x n row-major matrices.
+template <typename T, int RI, int RJ, int UK>
+void matmul_unrolled(const T* A, const T* B, T* C, int n) {
+    static_assert(RI > 0 && RJ > 0 && UK > 0, "tile and unroll factor must be positive");
+    for (int i0 = 0; i0 < n; i0 += RI) {
+        int m = std::min(RI, n - i0);
+        for (int j0 = 0; j0 < n; j0 += RJ) {
+            int w = std::min(RJ, n - j0);
+            if (m == RI && w == RJ)
+                matmul_unrolled_tile<T, RI, RJ, UK>(A, B, C, n, i0, j0);
+            else
+                matmul_unrolled_edge<T, RI, RJ>(A, B, C, n, i0, j0, m, w);
+        }
+    }
+}
+
+template <typename T>
+struct matmul_unrolled_variant {
+    int ri, rj;
+    void (*fn)(const T*, const T*, T*, int);
+    std::string name() const { return std::to_string(ri) + "x" + std::to_string(rj); }
+};
+
+template <typename T, int UK, int RI, int RJ>
+matmul_unrolled_variant<T> matmul_unrolled_entry() {
+    return {RI, RJ, &matmul_unrolled<T, RI, RJ, UK>};
+}
+
+// 1x1 is the single-accumulator kernel; the rest range from a few
+// accumulators to most of the 32 vector registers of AVX-512 for 4-byte
+// types (RJ is in elements).
+template <typename T, int UK>
+std::vector<matmul_unrolled_variant<T>> matmul_unrolled_variants() {
+    return {
+        matmul_unrolled_entry<T, UK, 1, 1>(),  matmul_unrolled_entry<T, UK, 2, 8>(),
+        matmul_unrolled_entry<T, UK, 4, 8>(),  matmul_unrolled_entry<T, UK, 2, 16>(),
+        matmul_unrolled_entry<T, UK, 4, 16>(), matmul_unrolled_entry<T, UK, 6, 16>(),
+        matmul_unrolled_entry<T, UK, 8, 16>(), matmul_unrolled_entry<T, UK, 4, 32>(),
+        matmul_unrolled_entry<T, UK, 6, 32>(), matmul_unrolled_entry<T, UK, 8, 32>(),
+    };
+}
@@ -1,6 +1,25 @@
+// Unrolled matmul: unroll-and-jam register tiles from matmul_unrolled.hpp
+// with the k loop unrolled UNROLL times (any positive factor, fixed at
+// compile time). The default 1x1 tile is the plain single-accumulator
+// k-unrolled loop.
+//
+//   --tile=RIxRJ         register tile, one of the variants (default 1x1)
+//   --type=int|float|double
+//   --sweep              time every tile, report the best and save it to
+//                        the tuning database ($TUNEDB)
+//   --tuned              take the tile from the tuning database
 #include <iostream>
+#include <iomanip>
 #include <chrono>
 #include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define TUNEDB_IMPLEMENTATION
+#include "tunedb.h"
+#include "matmul_unrolled.hpp"
+#include "matrix_init.hpp"
 
 using namespace std;
 
@@ -9,78 +28,96 @@ using namespace std;
 #endif
 
 #ifndef UNROLL
-#define UNROLL 4  // supported: 4 or 8
+#define UNROLL 4
 #endif
 
-int main() {
-    // const int N = 1024; // Start small (e.g., 512) and scale up later
-    cout << "Matrix size: " << N << "x" << N << endl;
-    cout << "Unroll factor: " << UNROLL << endl;
-    int* A = new int[N * N];
-    int* B = new int[N * N];
-    int* C = new int[N * N]();
-
-    for (int i = 0; i < N * N; ++i) {
-        A[i] = rand() % 100;
-        B[i] = rand() % 100;
-    }
-
+template <typename T>
+static double time_run(const matmul_unrolled_variant<T>& v, const T* A, const T* B, T* C) {
     auto start = chrono::high_resolution_clock::now();
+    v.fn(A, B, C, N);
+    auto end = chrono::high_resolution_clock::now();
+    return chrono::duration<double>(end - start).count();
+}
 
-    // Matrix multiplication with manual unrolling over k
-    for (int i = 0; i < N; ++i) {
-        const int* Ai = &A[i * N];
-        int* Ci = &C[i * N];
-        for (int j = 0; j < N; ++j) {
-            int sum = 0;
-            int k = 0;
+template <typename T>
+static int run(const string& type, string tile, bool sweep, bool tuned) {
+    vector<matmul_unrolled_variant<T>> variants = matmul_unrolled_variants<T, UNROLL>();
+    vector<T> A((size_t)N * N), B((size_t)N * N), C((size_t)N * N);
+    uint64_t seed = matrix_default_seed();
+    matrix_random(A.data(), A.size(), seed, 0);
+    matrix_random(B.data(), B.size(), seed, 1);
 
-#if UNROLL == 8
-            for (; k + 7 < N; k += 8) {
-                sum += Ai[k + 0] * B[(k + 0) * N + j];
-                sum += Ai[k + 1] * B[(k + 1) * N + j];
-                sum += Ai[k + 2] * B[(k + 2) * N + j];
-                sum += Ai[k + 3] * B[(k + 3) * N + j];
-                sum += Ai[k + 4] * B[(k + 4) * N + j];
-                sum += Ai[k + 5] * B[(k + 5) * N + j];
-                sum += Ai[k + 6] * B[(k + 6) * N + j];
-                sum += Ai[k + 7] * B[(k + 7) * N + j];
-            }
-            for (; k + 3 < N; k += 4) {
-                sum += Ai[k + 0] * B[(k + 0) * N + j];
-                sum += Ai[k + 1] * B[(k + 1) * N + j];
-                sum += Ai[k + 2] * B[(k + 2) * N + j];
-                sum += Ai[k + 3] * B[(k + 3) * N + j];
-            }
-#elif UNROLL == 4
-            for (; k + 3 < N; k += 4) {
-                sum += Ai[k + 0] * B[(k + 0) * N + j];
-                sum += Ai[k + 1] * B[(k + 1) * N + j];
-                sum += Ai[k + 2] * B[(k + 2) * N + j];
-                sum += Ai[k + 3] * B[(k + 3) * N + j];
-            }
-#else
-#warning "UNROLL must be 4 or 8; falling back to scalar loop"
-#endif
-            for (; k < N; ++k) {
-                sum += Ai[k] * B[k * N + j];
-            }
-            Ci[j] = sum;
+    char host[TUNEDB_FIELD];
+    tunedb_host_key(host, sizeof(host));
+    string problem = "N=" + to_string(N) + " type=" + type + " unroll=" + to_string(UNROLL);
+
+    if (sweep) {
+        cout << setw(8) << "tile" << setw(12) << "time s" << endl;
+        int best = 0;
+        vector<double> times;
+        for (const auto& v : variants) {
+            double t = min(time_run(v, A.data(), B.data(), C.data()),
+                           time_run(v, A.data(), B.data(), C.data()));
+            times.push_back(t);
+            if (t < times[best]) best = (int)times.size() - 1;
+            cout << setw(8) << v.name() << setw(12) << t << endl;
         }
+        const auto& b = variants[best];
+        cout << "Best tile for " << type << ": " << b.name() << endl;
+        string params = "ri=" + to_string(b.ri) + " rj=" + to_string(b.rj);
+        if (tunedb_append(tunedb_default_path(), host, "matmul_unrolling", problem.c_str(),
+                          params.c_str(), times[best]) == 0)
+            cout << "Saved tuning result to " << tunedb_default_path() << endl;
+        tile = b.name();
+    } else if (tuned) {
+        char params[TUNEDB_FIELD];
+        if (tunedb_lookup(tunedb_default_path(), host, "matmul_unrolling", problem.c_str(),
+                          params, sizeof(params)) >= 0)
+            tile = to_string(tunedb_param_int(params, "ri", 1)) + "x" +
+                   to_string(tunedb_param_int(params, "rj", 1));
+        else
+            cout << "No tuning result in " << tunedb_default_path() << ", using defaults" << endl;
     }
 
-    auto end = chrono::high_resolution_clock::now();
+    const matmul_unrolled_variant<T>* v = nullptr;
+    for (const auto& x : variants)
+        if (x.name() == tile) v = &x;
+    if (!v) {
+        cerr << "Error: no register tile " << tile << "; available:";
+        for (const auto& x : variants) cerr << " " << x.name();
+        cerr << endl;
+        return 1;
+    }
+    cout << "Register tile: " << v->name() << endl;
 
-    double time_taken = chrono::duration<double>(end - start).count();
+    double time_taken = time_run(*v, A.data(), B.data(), C.data());
     cout << "Execution time: " << time_taken << " seconds" << endl;
 
-    double checksum = 0;
-    for (int i = 0; i < N * N; ++i)
-        checksum += C[i];
-
-    cout << "Checksum: " << checksum << endl;
+    freivalds_result r = freivalds_check(A.data(), B.data(), C.data(), N);
+    cout << "Verification: " << (r.ok ? "passed" : "FAILED") << " (Freivalds, " << r.rounds
+         << " rounds)" << endl;
+    return r.ok ? 0 : 1;
+}
 
-    delete[] A;
-    delete[] B;
-    delete[] C;
-}
\ No newline at end of file
+int main(int argc, char** argv) {
+    string type = "int", tile = "1x1";
+    bool sweep = false, tuned = false;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (strncmp(a, "--tile=", 7) == 0) tile = a + 7;
+        else if (strncmp(a, "--type=", 7) == 0) type = a + 7;
+        else if (strcmp(a, "--sweep") == 0) sweep = true;
+        else if (strcmp(a, "--tuned") == 0) tuned = true;
+        else {
+            cerr << "Unknown argument: " << a << endl;
+            return 1;
+        }
+    }
+    cout << "Matrix size: " << N << "x" << N << endl;
+    cout << "Unroll factor: " << UNROLL << ", type: " << type << endl;
+    if (type == "int") return run<int>(type, tile, sweep, tuned);
+    if (type == "float") return run<float>(type, tile, sweep, tuned);
+    if (type == "double") return run<double>(type, tile, sweep, tuned);
+    cerr << "Error: --type must be int, float or double" << endl;
+    return 1;
+}
@@ -0,0 +1,134 @@
+// Reproducible random matrices and a fast result check for the matmul
+// programs.
+//
+//     uint64_t seed = matrix_default_seed();          // $MATMUL_SEED or 1
+//     matrix_random(A, n * n, seed, 0);               // stream 0 = A, 1 = B, ...
+//     matrix_random(B, n * n, seed, 1);
+//     ...
+//     freivalds_result v = freivalds_check(A, B, C, n);
+//
+// matrix_random is counter based: element e of stream s is a SplitMix64
+// hash of (seed, s, e), so the matrix is the same for any thread count,
+// libc or fill order, and the fill runs on all hardware threads. Values
+// are integers in [0, range), range 100 by default like the rand() % 100
+// the programs used before.
+//
+// freivalds_check verifies C == A * B in O(n^2) per round: for random
+// 0/1 vectors r it compares A (B r) with C r. A wrong C passes a round
+// with probability at most 1/2, so 'rounds' rounds miss an error with
+// probability at most 2^-rounds. The rounds are batched into one pass
+// over A, B and C. Integer types are compared exactly (64-bit
+// accumulators); floating-point types against a bound relative to
+// |A| (|B| r).
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// 64 random bits for element e of stream 'stream'.
+inline uint64_t matrix_random_bits(uint64_t seed, uint64_t stream, uint64_t e) {
+    uint64_t key = splitmix64(seed ^ splitmix64(stream));
+    return splitmix64(key + e * 0x9e3779b97f4a7c15ull);
+}
+
+// $MATMUL_SEED, or 1.
+inline uint64_t matrix_default_seed() {
+    const char* s = getenv("MATMUL_SEED");
+    return s && *s ? strtoull(s, nullptr, 0) : 1;
+}
+
+// M[0 .. count) = integers in [0, range). threads <= 0 uses every
+// hardware thread.
+template <typename T>
+void matrix_random(T* M, size_t count, uint64_t seed, uint64_t stream, int threads = 0,
+                   uint32_t range = 100) {
+    auto fill = [=](size_t begin, size_t end) {
+        for (size_t e = begin; e < end; ++e)
+            M[e] = (T)(((matrix_random_bits(seed, stream, e) >> 32) * range) >> 32);
+    };
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = (int)std::min<size_t>(threads, count / 65536 + 1);
+    if (threads <= 1) {
+        fill(0, count);
+        return;
+    }
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t)
+        pool.emplace_back(fill, count * t / threads, count * (t + 1) / threads);
+    for (auto& th : pool) th.join();
+}
+
+struct freivalds_result {
+    bool ok;
+    int rounds;
+    double max_err;   // largest |A B r - C r|, relative to the bound for floats
+};
+
+// Check C == A * B for n x n row-major matrices.
+template <typename T>
+freivalds_result freivalds_check(const T* A, const T* B, const T* C, int n, int rounds = 16,
+                                 uint64_t seed = 1) {
+    using acc = typename std::conditional<std::is_integral<T>::value, int64_t, double>::type;
+    constexpr bool exact = std::is_integral<T>::value;
+    rounds = std::max(1, std::min(rounds, 64));
+    const int R = rounds;
+    // r[j][t] = bit j of vector t.
+    std::vector<acc> r((size_t)n * R), y((size_t)n * R), ya((size_t)n * R);
+    for (int j = 0; j < n; ++j) {
+        uint64_t bits = matrix_random_bits(seed, 0x46726569ull, (uint64_t)j);
+        for (int t = 0; t < R; ++t) r[(size_t)j * R + t] = (acc)((bits >> t) & 1);
+    }
+    // y = B r and, for floats, ya = |B| r.
+    for (int k = 0; k < n; ++k) {
+        acc* yk = &y[(size_t)k * R];
+        acc* yak = &ya[(size_t)k * R];
+        for (int j = 0; j < n; ++j) {
+            acc b = (acc)B[(size_t)k * n + j];
+            const acc* rj = &r[(size_t)j * R];
+            for (int t = 0; t < R; ++t) yk[t] += b * rj[t];
+            if (!exact)
+                for (int t = 0; t < R; ++t) yak[t] += std::fabs((double)b) * rj[t];
+        }
+    }
+    freivalds_result res = {true, R, 0.0};
+    const double tol = exact ? 0.0 : 4.0 * n * std::numeric_limits<T>::epsilon();
+    std::vector<acc> z(R), w(R), za(R);
+    for (int i = 0; i < n; ++i) {
+        std::fill(z.begin(), z.end(), acc(0));
+        std::fill(w.begin(), w.end(), acc(0));
+        std::fill(za.begin(), za.end(), acc(0));
+        for (int k = 0; k < n; ++k) {
+            acc a = (acc)A[(size_t)i * n + k], c = (acc)C[(size_t)i * n + k];
+            const acc* yk = &y[(size_t)k * R];
+            const acc* rk = &r[(size_t)k * R];
+            for (int t = 0; t < R; ++t) {
+                z[t] += a * yk[t];
+                w[t] += c * rk[t];
+            }
+            if (!exact) {
+                const acc* yak = &ya[(size_t)k * R];
+                for (int t = 0; t < R; ++t) za[t] += std::fabs((double)a) * yak[t];
+            }
+        }
+        for (int t = 0; t < R; ++t) {
+            double d = std::fabs((double)(z[t] - w[t]));
+            if (!exact) d /= std::max((double)za[t], std::numeric_limits<double>::min());
+            if (!(d <= tol)) res.ok = false;   // also catches NaN
+            res.max_err = std::max(res.max_err, d);
+        }
+    }
+    return res;
+}
@@ -0,0 +1,281 @@
+// Sparse matrices and sparse x dense products for operands that are
+// mostly zeros. Three compressed formats, all built from the dense
+// row-major arrays the drivers generate (exact zeros are dropped):
+//
+//   csr_matrix   rows of (column, value) pairs: ptr[i] .. ptr[i + 1]
+//   csc_matrix   the same by columns: ptr[j] .. ptr[j + 1] hold rows
+//   bcsr_matrix  CSR over dense br x bc blocks; a block is stored if any
+//                of its elements is nonzero
+//
+// Kernels (C and y are overwritten):
+//
+//   spmm(A csr, B dense)   C[i,:] += a_ip * B[p,:], SIMD over the
+//                          columns of B; rows are split over threads
+//                          with equal numbers of nonzeros
+//   spmm(A dense, B csr)   C[:,j] += b_pj * A[:,p] on RB-row tiles of
+//                          A and C, SIMD over the RB rows
+//   spmm(A dense, B bcsr)  the same, one index per br x bc block
+//   spmv(A csr, x)         one dot product per row, nnz-balanced
+//   spmv(A csc, x)         y += x_j * A[:,j], single-threaded (columns
+//                          scatter into all of y)
+//
+// In the dense x sparse products every row of A costs the same, so
+// their rows are split evenly over threads (in whole tiles).
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+template <typename T>
+struct csr_matrix {
+    int rows = 0, cols = 0;
+    std::vector<int> ptr;   // rows + 1 offsets into idx / val
+    std::vector<int> idx;   // column of each nonzero
+    std::vector<T> val;
+    size_t nnz() const { return val.size(); }
+};
+
+template <typename T>
+struct csc_matrix {
+    int rows = 0, cols = 0;
+    std::vector<int> ptr;   // cols + 1 offsets into idx / val
+    std::vector<int> idx;   // row of each nonzero
+    std::vector<T> val;
+    size_t nnz() const { return val.size(); }
+};
+
+template <typename T>
+struct bcsr_matrix {
+    int rows = 0, cols = 0, br = 1, bc = 1;
+    std::vector<int> ptr;   // block rows + 1 offsets into idx
+    std::vector<int> idx;   // block column of each stored block
+    std::vector<T> val;     // br x bc row-major values per stored block
+    size_t blocks() const { return idx.size(); }
+};
+
+template <typename T>
+csr_matrix<T> csr_from_dense(int rows, int cols, const T* A, int lda) {
+    csr_matrix<T> S;
+    S.rows = rows;
+    S.cols = cols;
+    S.ptr.assign(rows + 1, 0);
+    for (int i = 0; i < rows; ++i) {
+        const T* a = A + (size_t)i * lda;
+        for (int j = 0; j < cols; ++j) {
+            if (a[j] != T(0)) {
+                S.idx.push_back(j);
+                S.val.push_back(a[j]);
+            }
+        }
+        S.ptr[i + 1] = (int)S.val.size();
+    }
+    return S;
+}
+
+template <typename T>
+csc_matrix<T> csc_from_dense(int rows, int cols, const T* A, int lda) {
+    csc_matrix<T> S;
+    S.rows = rows;
+    S.cols = cols;
+    S.ptr.assign(cols + 1, 0);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            if (A[(size_t)i * lda + j] != T(0)) ++S.ptr[j + 1];
+    for (int j = 0; j < cols; ++j) S.ptr[j + 1] += S.ptr[j];
+    S.idx.resize(S.ptr[cols]);
+    S.val.resize(S.ptr[cols]);
+    std::vector<int> next(S.ptr.begin(), S.ptr.end() - 1);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j) {
+            T a = A[(size_t)i * lda + j];
+            if (a != T(0)) {
+                S.idx[next[j]] = i;
+                S.val[next[j]++] = a;
+            }
+        }
+    return S;
+}
+
+// Edge blocks past rows / cols are zero padded.
+template <typename T>
+bcsr_matrix<T> bcsr_from_dense(int rows, int cols, const T* A, int lda, int br, int bc) {
+    bcsr_matrix<T> S;
+    S.rows = rows;
+    S.cols = cols;
+    S.br = br;
+    S.bc = bc;
+    int block_rows = (rows + br - 1) / br, block_cols = (cols + bc - 1) / bc;
+    S.ptr.assign(block_rows + 1, 0);
+    std::vector<T> blk((size_t)br * bc);
+    for (int bi = 0; bi < block_rows; ++bi) {
+        for (int bj = 0; bj < block_cols; ++bj) {
+            bool any = false;
+            for (int r = 0; r < br; ++r)
+                for (int c = 0; c < bc; ++c) {
+                    int i = bi * br + r, j = bj * bc + c;
+                    T a = i < rows && j < cols ? A[(size_t)i * lda + j] : T(0);
+                    blk[r * bc + c] = a;
+                    any |= a != T(0);
+                }
+            if (any) {
+                S.idx.push_back(bj);
+                S.val.insert(S.val.end(), blk.begin(), blk.end());
+            }
+        }
+        S.ptr[bi + 1] = (int)S.idx.size();
+    }
+    return S;
+}
+
+// Split rows [0, rows) into 'threads' ranges holding about the same
+// number of entries of ptr each; bounds has threads + 1 elements.
+inline std::vector<int> sparse_partition(const std::vector<int>& ptr, int rows, int threads) {
+    threads = std::max(1, std::min(threads, rows));
+    std::vector<int> bounds(threads + 1, rows);
+    bounds[0] = 0;
+    long long total = ptr[rows];
+    for (int t = 1; t < threads; ++t) {
+        long long target = total * t / threads;
+        int r = (int)(std::lower_bound(ptr.begin(), ptr.begin() + rows + 1, target) - ptr.begin());
+        bounds[t] = std::max(bounds[t - 1], std::min(r, rows));
+    }
+    return bounds;
+}
+
+// Even split by rows.
+inline std::vector<int> sparse_even_partition(int rows, int threads) {
+    threads = std::max(1, std::min(threads, rows));
+    std::vector<int> bounds(threads + 1);
+    for (int t = 0; t <= threads; ++t) bounds[t] = (int)((long long)rows * t / threads);
+    return bounds;
+}
+
+// Run f(r0, r1) on each range of bounds, one thread per range.
+template <typename F>
+void sparse_for_each_part(const std::vector<int>& bounds, F f) {
+    int parts = (int)bounds.size() - 1;
+    if (parts <= 1) {
+        if (parts == 1) f(bounds[0], bounds[1]);
+        return;
+    }
+    std::vector<std::thread> pool;
+    for (int t = 0; t < parts; ++t) pool.emplace_back([=] { f(bounds[t], bounds[t + 1]); });
+    for (auto& th : pool) th.join();
+}
+
+// C = A * B with sparse A (m x k) and dense B (k x n).
+template <typename T>
+void spmm(const csr_matrix<T>& A, const T* B, int ldb, int n, T* C, int ldc, int threads = 1) {
+    sparse_for_each_part(sparse_partition(A.ptr, A.rows, threads), [&](int r0, int r1) {
+        for (int i = r0; i < r1; ++i) {
+            T* __restrict Ci = C + (size_t)i * ldc;
+            std::fill(Ci, Ci + n, T(0));
+            for (int q = A.ptr[i]; q < A.ptr[i + 1]; ++q) {
+                T a = A.val[q];
+                const T* __restrict Bp = B + (size_t)A.idx[q] * ldb;
+                for (int j = 0; j < n; ++j) Ci[j] += a * Bp[j];
+            }
+        }
+    });
+}
+
+// Dense x sparse: the rows of A are taken RB at a time (two 64-byte
+// vectors of T), transposed so that At[p] holds A[i0..i0+RB, p], and
+// accumulated into a transposed tile Ct[j] of C. Each nonzero b_pj
+// then updates Ct[j] += b_pj * At[p], SIMD over the RB rows, and B is
+// read once per RB rows of A rather than once per row.
+template <typename T>
+struct sparse_row_tile {
+    static constexpr int RB = 128 / sizeof(T);
+    std::vector<T> At, Ct;
+    // Room for k rows of At and n of Ct; rows past those loaded stay 0.
+    sparse_row_tile(int k, int n) : At((size_t)k * RB), Ct((size_t)n * RB) {}
+
+    void load(const T* A, int lda, int i0, int rows, int k) {
+        for (int r = 0; r < RB; ++r)
+            for (int p = 0; p < k; ++p)
+                At[(size_t)p * RB + r] = r < rows ? A[(size_t)(i0 + r) * lda + p] : T(0);
+        std::fill(Ct.begin(), Ct.end(), T(0));
+    }
+    // Ct[j] += b * At[p]
+    void axpy(int j, T b, int p) {
+        T* __restrict c = &Ct[(size_t)j * RB];
+        const T* __restrict a = &At[(size_t)p * RB];
+        for (int r = 0; r < RB; ++r) c[r] += b * a[r];
+    }
+    void store(T* C, int ldc, int i0, int rows, int n) const {
+        for (int r = 0; r < rows; ++r)
+            for (int j = 0; j < n; ++j) C[(size_t)(i0 + r) * ldc + j] = Ct[(size_t)j * RB + r];
+    }
+};
+
+// Even split of m rows in whole RB-row tiles.
+template <typename T, typename F>
+void sparse_for_each_tile(int m, int threads, F f) {
+    constexpr int RB = sparse_row_tile<T>::RB;
+    std::vector<int> bounds = sparse_even_partition((m + RB - 1) / RB, threads);
+    for (int& b : bounds) b = std::min(m, b * RB);
+    sparse_for_each_part(bounds, f);
+}
+
+// C = A * B with dense A (m x B.rows) and sparse B.
+template <typename T>
+void spmm(int m, const T* A, int lda, const csr_matrix<T>& B, T* C, int ldc, int threads = 1) {
+    constexpr int RB = sparse_row_tile<T>::RB;
+    sparse_for_each_tile<T>(m, threads, [&](int r0, int r1) {
+        sparse_row_tile<T> tile(B.rows, B.cols);
+        for (int i0 = r0; i0 < r1; i0 += RB) {
+            int rows = std::min(RB, r1 - i0);
+            tile.load(A, lda, i0, rows, B.rows);
+            for (int p = 0; p < B.rows; ++p)
+                for (int q = B.ptr[p]; q < B.ptr[p + 1]; ++q) tile.axpy(B.idx[q], B.val[q], p);
+            tile.store(C, ldc, i0, rows, B.cols);
+        }
+    });
+}
+
+template <typename T>
+void spmm(int m, const T* A, int lda, const bcsr_matrix<T>& B, T* C, int ldc, int threads = 1) {
+    constexpr int RB = sparse_row_tile<T>::RB;
+    const int br = B.br, bc = B.bc;
+    int block_rows = (B.rows + br - 1) / br;
+    // The tile is padded to whole blocks; padded rows of At are zero.
+    int k_pad = block_rows * br, n_pad = (B.cols + bc - 1) / bc * bc;
+    sparse_for_each_tile<T>(m, threads, [&](int r0, int r1) {
+        sparse_row_tile<T> tile(k_pad, n_pad);
+        for (int i0 = r0; i0 < r1; i0 += RB) {
+            int rows = std::min(RB, r1 - i0);
+            tile.load(A, lda, i0, rows, B.rows);
+            for (int bi = 0; bi < block_rows; ++bi)
+                for (int q = B.ptr[bi]; q < B.ptr[bi + 1]; ++q) {
+                    const T* blk = &B.val[(size_t)q * br * bc];
+                    for (int r = 0; r < br; ++r)
+                        for (int c = 0; c < bc; ++c)
+                            tile.axpy(B.idx[q] * bc + c, blk[r * bc + c], bi * br + r);
+                }
+            tile.store(C, ldc, i0, rows, B.cols);
+        }
+    });
+}
+
+// y = A * x.
+template <typename T>
+void spmv(const csr_matrix<T>& A, const T* x, T* y, int threads = 1) {
+    sparse_for_each_part(sparse_partition(A.ptr, A.rows, threads), [&](int r0, int r1) {
+        for (int i = r0; i < r1; ++i) {
+            T sum = T(0);
+            for (int q = A.ptr[i]; q < A.ptr[i + 1]; ++q) sum += A.val[q] * x[A.idx[q]];
+            y[i] = sum;
+        }
+    });
+}
+
+template <typename T>
+void spmv(const csc_matrix<T>& A, const T* x, T* y) {
+    std::fill(y, y + A.rows, T(0));
+    for (int j = 0; j < A.cols; ++j) {
+        T xj = x[j];
+        for (int q = A.ptr[j]; q < A.ptr[j + 1]; ++q) y[A.idx[q]] += A.val[q] * xj;
+    }
+}
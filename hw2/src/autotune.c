@@ -0,0 +1,117 @@
+// HW2 - Autotuner for the direct convolution loops.
+
+#define TUNEDB_IMPLEMENTATION
+#include "tunedb.h"
+
+#include "autotune.h"
+#include "convolve.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define TUNE_KERNEL "conv_direct"
+
+static const int tile_grid[] = { 8, 16, 32, 64, 128 };
+static const int unroll_grid[] = { 2, 4, 8, 16 };
+
+typedef struct {
+    const unsigned char *in;
+    unsigned char *out;
+    int w, h, ch;
+    const conv_kernel_t *kernel;
+    conv_tune_t *cands;
+} tune_ctx_t;
+
+static double now_sec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+// Run one candidate on the first 'budget' fraction of the rows and
+// scale the time to the whole image.
+static double eval_candidate(void *arg, int cand, double budget) {
+    tune_ctx_t *ctx = (tune_ctx_t *)arg;
+    const conv_tune_t *c = &ctx->cands[cand];
+    int rows = (int)(budget * ctx->h + 0.5);
+    if (rows < 2 * c->threads) rows = 2 * c->threads;
+    if (rows > ctx->h) rows = ctx->h;
+
+    double t0 = now_sec();
+    run_pthreads_variant(ctx->in, ctx->out, ctx->w, rows, ctx->ch, ctx->kernel,
+                         c->tile, c->unroll, c->threads);
+    double dt = now_sec() - t0;
+    return dt * ctx->h / rows;
+}
+
+static void problem_key(char *buf, size_t size, int w, int h, int ch,
+                        const conv_kernel_t *kernel) {
+    snprintf(buf, size, "%dx%dx%d k=%dx%d", w, h, ch, kernel->kh, kernel->kw);
+}
+
+int conv_autotune(const unsigned char *in, int w, int h, int ch,
+                  const conv_kernel_t *kernel, int max_threads,
+                  const char *db_path, conv_tune_t *best) {
+    if (max_threads < 1) max_threads = 1;
+
+    // Grid: (baseline | tile t | unroll u) x threads in {1, 2, 4, .., max}.
+    int nthreads = 0, thread_grid[32];
+    for (int t = 1; t < max_threads && nthreads < 31; t *= 2) thread_grid[nthreads++] = t;
+    thread_grid[nthreads++] = max_threads;
+
+    int ntiles = (int)(sizeof(tile_grid) / sizeof(tile_grid[0]));
+    int nunrolls = (int)(sizeof(unroll_grid) / sizeof(unroll_grid[0]));
+    int nvariants = 1 + ntiles + nunrolls;
+    int ncand = nvariants * nthreads;
+    conv_tune_t *cands = (conv_tune_t *)calloc((size_t)ncand, sizeof(conv_tune_t));
+    unsigned char *scratch = (unsigned char *)malloc((size_t)w * h * ch);
+    if (!cands || !scratch) {
+        free(cands);
+        free(scratch);
+        return -1;
+    }
+    int n = 0;
+    for (int t = 0; t < nthreads; ++t) {
+        for (int v = 0; v < nvariants; ++v, ++n) {
+            cands[n].threads = thread_grid[t];
+            if (v >= 1 && v <= ntiles) cands[n].tile = tile_grid[v - 1];
+            if (v > ntiles) cands[n].unroll = unroll_grid[v - 1 - ntiles];
+        }
+    }
+
+    printf("Tuning %d candidates (successive halving)...\n", ncand);
+    tune_ctx_t ctx = { in, scratch, w, h, ch, kernel, cands };
+    double seconds = 0.0;
+    double min_budget = 8.0 / h;
+    int winner = tunedb_successive_halving(ncand, eval_candidate, &ctx, min_budget, &seconds);
+    *best = cands[winner];
+    best->seconds = seconds;
+
+    char host[TUNEDB_FIELD], problem[TUNEDB_FIELD], params[TUNEDB_FIELD];
+    tunedb_host_key(host, sizeof(host));
+    problem_key(problem, sizeof(problem), w, h, ch, kernel);
+    snprintf(params, sizeof(params), "tile=%d unroll=%d threads=%d",
+             best->tile, best->unroll, best->threads);
+    if (db_path && tunedb_append(db_path, host, TUNE_KERNEL, problem, params, seconds) == 0) {
+        printf("Saved tuning result to %s\n", db_path);
+    }
+
+    free(cands);
+    free(scratch);
+    return 0;
+}
+
+int conv_tuned_params(int w, int h, int ch, const conv_kernel_t *kernel,
+                      const char *db_path, conv_tune_t *out) {
+    char host[TUNEDB_FIELD], problem[TUNEDB_FIELD], params[TUNEDB_FIELD];
+    tunedb_host_key(host, sizeof(host));
+    problem_key(problem, sizeof(problem), w, h, ch, kernel);
+    int rc = tunedb_lookup(db_path, host, TUNE_KERNEL, problem, params, sizeof(params));
+    if (rc < 0) return rc;
+    out->tile = tunedb_param_int(params, "tile", 0);
+    out->unroll = tunedb_param_int(params, "unroll", 0);
+    out->threads = tunedb_param_int(params, "threads", 1);
+    out->seconds = 0.0;
+    return rc;
+}
@@ -0,0 +1,31 @@
+// HW2 - Autotuner for the direct convolution loops
+// ------------------------------------------------------------
+// Searches tile size, unroll factor and thread count with successive
+// halving over a grid (see common/tunedb.h) and stores the winner in
+// the tuning database keyed by CPU model and cache sizes. Later runs
+// read the database at startup with --tuned.
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include "conv_kernel.h"
+
+typedef struct {
+    int tile;
+    int unroll;
+    int threads;
+    double seconds;    // estimated full-image time
+} conv_tune_t;
+
+// Tune on the given image and append the result to 'db_path'.
+// Returns 0 on success and fills *best.
+int conv_autotune(const unsigned char *in, int w, int h, int ch,
+                  const conv_kernel_t *kernel, int max_threads,
+                  const char *db_path, conv_tune_t *best);
+
+// Look up tuned parameters for this host and problem. Returns 0 for an
+// exact match, 1 for a result from another problem size, -1 if none.
+int conv_tuned_params(int w, int h, int ch, const conv_kernel_t *kernel,
+                      const char *db_path, conv_tune_t *out);
+
+#endif // AUTOTUNE_H
@@ -0,0 +1,427 @@
+// HW2 - Convolution kernels: generators, file loader and analysis.
+// See conv_kernel.h for the spec syntax and file formats.
+
+#include "conv_kernel.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+int conv_kernel_init(conv_kernel_t *k, int kh, int kw) {
+    memset(k, 0, sizeof(*k));
+    if (kh <= 0 || kw <= 0 || (kh % 2) == 0 || (kw % 2) == 0) {
+        fprintf(stderr, "Error: kernel size %dx%d must be positive and odd\n", kh, kw);
+        return -1;
+    }
+    k->kh = kh;
+    k->kw = kw;
+    k->data = (double *)calloc((size_t)kh * (size_t)kw, sizeof(double));
+    k->col = (double *)calloc((size_t)kh, sizeof(double));
+    k->row = (double *)calloc((size_t)kw, sizeof(double));
+    if (!k->data || !k->col || !k->row) {
+        fprintf(stderr, "Error: could not allocate %dx%d kernel\n", kh, kw);
+        conv_kernel_free(k);
+        return -1;
+    }
+    return 0;
+}
+
+void conv_kernel_free(conv_kernel_t *k) {
+    free(k->data);
+    free(k->col);
+    free(k->row);
+    k->data = NULL;
+    k->col = NULL;
+    k->row = NULL;
+}
+
+void conv_kernel_analyze(conv_kernel_t *k) {
+    int n = k->kh * k->kw;
+    double maxabs = 0.0;
+    int py = 0, px = 0;
+    for (int i = 0; i < n; ++i) {
+        if (fabs(k->data[i]) > maxabs) {
+            maxabs = fabs(k->data[i]);
+            py = i / k->kw;
+            px = i % k->kw;
+        }
+    }
+    double eps = 1e-9 * (maxabs > 0.0 ? maxabs : 1.0);
+
+    k->constant = 1;
+    k->integer = 1;
+    k->symmetric = 1;
+    for (int i = 0; i < n; ++i) {
+        double v = k->data[i];
+        if (fabs(v - k->data[0]) > eps) k->constant = 0;
+        if (fabs(v - nearbyint(v)) > 1e-12) k->integer = 0;
+        if (fabs(v - k->data[n - 1 - i]) > eps) k->symmetric = 0;
+    }
+
+    // Rank-1 test: take the row and column through the largest tap as
+    // factors and check that their outer product reproduces every tap.
+    k->separable = 1;
+    if (maxabs == 0.0) {
+        for (int y = 0; y < k->kh; ++y) k->col[y] = 0.0;
+        for (int x = 0; x < k->kw; ++x) k->row[x] = 0.0;
+        return;
+    }
+    double pivot = k->data[py * k->kw + px];
+    for (int y = 0; y < k->kh; ++y) k->col[y] = k->data[y * k->kw + px];
+    for (int x = 0; x < k->kw; ++x) k->row[x] = k->data[py * k->kw + x] / pivot;
+    for (int y = 0; y < k->kh && k->separable; ++y) {
+        for (int x = 0; x < k->kw; ++x) {
+            if (fabs(k->data[y * k->kw + x] - k->col[y] * k->row[x]) > eps) {
+                k->separable = 0;
+                break;
+            }
+        }
+    }
+}
+
+// Same rule OpenCV uses to derive sigma from the window size.
+static double default_sigma(int size) {
+    return 0.3 * ((size - 1) * 0.5 - 1.0) + 0.8;
+}
+
+static void gaussian_1d(double *g, int size, double sigma) {
+    int r = size / 2;
+    double s = 0.0;
+    for (int i = 0; i < size; ++i) {
+        double d = i - r;
+        g[i] = exp(-(d * d) / (2.0 * sigma * sigma));
+        s += g[i];
+    }
+    for (int i = 0; i < size; ++i) g[i] /= s;
+}
+
+// Binomial smoothing row of length n (1, 2, 1 for n = 3).
+static void binomial_1d(double *b, int n) {
+    b[0] = 1.0;
+    for (int i = 1; i < n; ++i) {
+        b[i] = 0.0;
+        for (int j = i; j > 0; --j) b[j] += b[j - 1];
+    }
+}
+
+// Sobel derivative row of length n: binomial(n - 2) convolved with
+// (-1, 0, 1), giving (-1, 0, 1) for n = 3 and (-1, -2, 0, 2, 1) for n = 5.
+static void sobel_deriv_1d(double *d, int n) {
+    double b[64];
+    binomial_1d(b, n - 2);
+    for (int i = 0; i < n; ++i) d[i] = 0.0;
+    for (int i = 0; i < n - 2; ++i) {
+        d[i] -= b[i];
+        d[i + 2] += b[i];
+    }
+}
+
+static void outer_product(conv_kernel_t *k, const double *col, const double *row) {
+    for (int y = 0; y < k->kh; ++y)
+        for (int x = 0; x < k->kw; ++x)
+            k->data[y * k->kw + x] = col[y] * row[x];
+}
+
+// Example 3x3 edge-detection kernel (Sobel-like, horizontal edges).
+// This matches the style of the example in the homework handout.
+int make_edge_kernel_3x3(conv_kernel_t *k) {
+    static const double taps[9] = {
+        -1, 0, 1,
+        -2, 0, 2,
+        -1, 0, 1
+    };
+    if (conv_kernel_init(k, 3, 3) != 0) return -1;
+    memcpy(k->data, taps, sizeof(taps));
+    snprintf(k->name, sizeof(k->name), "edge 3x3");
+    conv_kernel_analyze(k);
+    return 0;
+}
+
+// Generic kh x kw normalized box blur kernel.
+// For 15x15, this is the "large" kernel the homework wants.
+int make_box_blur_kernel(conv_kernel_t *k, int kh, int kw) {
+    if (conv_kernel_init(k, kh, kw) != 0) return -1;
+    double v = 1.0 / (kh * kw);
+    for (int i = 0; i < kh * kw; ++i) k->data[i] = v;
+    snprintf(k->name, sizeof(k->name), "box %dx%d", kh, kw);
+    conv_kernel_analyze(k);
+    return 0;
+}
+
+int make_gaussian_kernel(conv_kernel_t *k, int kh, int kw, double sigma) {
+    if (conv_kernel_init(k, kh, kw) != 0) return -1;
+    double sy = sigma > 0.0 ? sigma : default_sigma(kh);
+    double sx = sigma > 0.0 ? sigma : default_sigma(kw);
+    gaussian_1d(k->col, kh, sy);
+    gaussian_1d(k->row, kw, sx);
+    outer_product(k, k->col, k->row);
+    snprintf(k->name, sizeof(k->name), "gaussian %dx%d sigma=%.2f,%.2f", kh, kw, sy, sx);
+    conv_kernel_analyze(k);
+    return 0;
+}
+
+// Laplacian of Gaussian, sampled on the grid and shifted to zero sum so
+// flat regions map to 0. Uses the mathematical sign (negative centre).
+int make_log_kernel(conv_kernel_t *k, int kh, int kw, double sigma) {
+    if (conv_kernel_init(k, kh, kw) != 0) return -1;
+    int ry = kh / 2, rx = kw / 2;
+    int rmax = ry > rx ? ry : rx;
+    double s = sigma > 0.0 ? sigma : (rmax > 1 ? rmax / 3.0 : 0.5);
+    double s2 = s * s;
+    double mean = 0.0;
+    for (int y = -ry; y <= ry; ++y) {
+        for (int x = -rx; x <= rx; ++x) {
+            double q = (x * x + y * y) / (2.0 * s2);
+            double v = -1.0 / (M_PI * s2 * s2) * (1.0 - q) * exp(-q);
+            k->data[(y + ry) * kw + (x + rx)] = v;
+            mean += v;
+        }
+    }
+    mean /= (kh * kw);
+    for (int i = 0; i < kh * kw; ++i) k->data[i] -= mean;
+    snprintf(k->name, sizeof(k->name), "log %dx%d sigma=%.2f", kh, kw, s);
+    conv_kernel_analyze(k);
+    return 0;
+}
+
+// Sobel derivative along x (dir_y = 0) or y (dir_y = 1). The derivative
+// axis needs at least 3 taps; the other axis is binomial smoothing.
+int make_sobel_kernel(conv_kernel_t *k, int kh, int kw, int dir_y) {
+    int dlen = dir_y ? kh : kw;
+    if (dlen < 3 || kh > 63 || kw > 63) {
+        fprintf(stderr, "Error: sobel kernel needs 3..63 taps along the derivative axis\n");
+        return -1;
+    }
+    if (conv_kernel_init(k, kh, kw) != 0) return -1;
+    if (dir_y) {
+        sobel_deriv_1d(k->col, kh);
+        binomial_1d(k->row, kw);
+    } else {
+        binomial_1d(k->col, kh);
+        sobel_deriv_1d(k->row, kw);
+    }
+    outer_product(k, k->col, k->row);
+    snprintf(k->name, sizeof(k->name), "sobel%c %dx%d", dir_y ? 'y' : 'x', kh, kw);
+    conv_kernel_analyze(k);
+    return 0;
+}
+
+// Sharpening. The 3x3 case with amount 1 is the classic integer
+// (0 -1 0 / -1 5 -1 / 0 -1 0) filter; every other size is an unsharp
+// mask (1 + amount) * identity - amount * gaussian.
+int make_sharpen_kernel(conv_kernel_t *k, int kh, int kw, double amount) {
+    if (amount <= 0.0) amount = 1.0;
+    if (kh == 3 && kw == 3 && amount == 1.0) {
+        static const double taps[9] = {
+             0, -1,  0,
+            -1,  5, -1,
+             0, -1,  0
+        };
+        if (conv_kernel_init(k, 3, 3) != 0) return -1;
+        memcpy(k->data, taps, sizeof(taps));
+    } else {
+        if (make_gaussian_kernel(k, kh, kw, 0.0) != 0) return -1;
+        for (int i = 0; i < kh * kw; ++i) k->data[i] *= -amount;
+        k->data[(kh / 2) * kw + kw / 2] += 1.0 + amount;
+    }
+    snprintf(k->name, sizeof(k->name), "sharpen %dx%d amount=%.2f", kh, kw, amount);
+    conv_kernel_analyze(k);
+    return 0;
+}
+
+// Linear motion blur: a line through the centre at angle_deg (0 =
+// horizontal), clipped to the kernel window and normalized.
+int make_motion_blur_kernel(conv_kernel_t *k, int kh, int kw, double angle_deg) {
+    if (conv_kernel_init(k, kh, kw) != 0) return -1;
+    int ry = kh / 2, rx = kw / 2;
+    double len = ry > rx ? ry : rx;
+    double a = angle_deg * M_PI / 180.0;
+    double ca = cos(a), sa = sin(a);
+    for (double t = -len; t <= len + 1e-9; t += 0.25) {
+        int x = (int)lround(t * ca);
+        int y = (int)lround(-t * sa);
+        if (x < -rx || x > rx || y < -ry || y > ry) continue;
+        k->data[(y + ry) * kw + (x + rx)] = 1.0;
+    }
+    int count = 0;
+    for (int i = 0; i < kh * kw; ++i) count += k->data[i] != 0.0;
+    for (int i = 0; i < kh * kw; ++i) k->data[i] /= count;
+    snprintf(k->name, sizeof(k->name), "motion %dx%d angle=%.1f", kh, kw, angle_deg);
+    conv_kernel_analyze(k);
+    return 0;
+}
+
+// Largest kh or kw accepted from a kernel file, so kh * kw and the tap
+// indices stay far from int overflow.
+#define FILE_MAX_DIM 4095
+
+static int load_binary(conv_kernel_t *k, FILE *f, const char *path) {
+    int32_t dims[2];
+    if (fread(dims, sizeof(int32_t), 2, f) != 2) {
+        fprintf(stderr, "Error: truncated kernel header in '%s'\n", path);
+        return -1;
+    }
+    if (dims[0] <= 0 || dims[1] <= 0 || dims[0] > FILE_MAX_DIM || dims[1] > FILE_MAX_DIM) {
+        fprintf(stderr, "Error: kernel size %d x %d in '%s' is not in 1 .. %d\n",
+                (int)dims[0], (int)dims[1], path, FILE_MAX_DIM);
+        return -1;
+    }
+    if (conv_kernel_init(k, dims[0], dims[1]) != 0) return -1;
+    size_t n = (size_t)dims[0] * (size_t)dims[1];
+    if (fread(k->data, sizeof(double), n, f) != n) {
+        fprintf(stderr, "Error: expected %zu taps in '%s'\n", n, path);
+        conv_kernel_free(k);
+        return -1;
+    }
+    return 0;
+}
+
+static int load_text(conv_kernel_t *k, FILE *f, const char *path) {
+    // Read the whole file and blank out comments, then parse numbers.
+    size_t cap = 4096, len = 0;
+    char *buf = (char *)malloc(cap);
+    if (!buf) return -1;
+    int c, in_comment = 0;
+    while ((c = fgetc(f)) != EOF) {
+        if (c == '#') in_comment = 1;
+        if (c == '\n') in_comment = 0;
+        if (len + 1 >= cap) {
+            char *nb = (char *)realloc(buf, cap * 2);
+            if (!nb) {
+                free(buf);
+                return -1;
+            }
+            buf = nb;
+            cap *= 2;
+        }
+        buf[len++] = in_comment ? ' ' : (char)c;
+    }
+    buf[len] = '\0';
+
+    char *p = buf, *end;
+    long kh = strtol(p, &end, 10);
+    p = end;
+    long kw = strtol(p, &end, 10);
+    if (end == p || kh <= 0 || kw <= 0 || kh > FILE_MAX_DIM || kw > FILE_MAX_DIM) {
+        fprintf(stderr, "Error: '%s' must start with \"kh kw\" (1 .. %d)\n", path, FILE_MAX_DIM);
+        free(buf);
+        return -1;
+    }
+    if (conv_kernel_init(k, (int)kh, (int)kw) != 0) {
+        free(buf);
+        return -1;
+    }
+    p = end;
+    for (long i = 0; i < kh * kw; ++i) {
+        k->data[i] = strtod(p, &end);
+        if (end == p) {
+            fprintf(stderr, "Error: expected %ld taps in '%s', found %ld\n", kh * kw, path, i);
+            conv_kernel_free(k);
+            free(buf);
+            return -1;
+        }
+        p = end;
+    }
+    free(buf);
+    return 0;
+}
+
+int conv_kernel_load(conv_kernel_t *k, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Error: could not open kernel file '%s'\n", path);
+        return -1;
+    }
+    char magic[4];
+    int rc;
+    if (fread(magic, 1, 4, f) == 4 && memcmp(magic, "CKRN", 4) == 0) {
+        rc = load_binary(k, f, path);
+    } else {
+        rewind(f);
+        rc = load_text(k, f, path);
+    }
+    fclose(f);
+    if (rc != 0) return rc;
+
+    const char *base = strrchr(path, '/');
+    snprintf(k->name, sizeof(k->name), "file %s", base ? base + 1 : path);
+    conv_kernel_analyze(k);
+    return 0;
+}
+
+// Parse "k" or "khxkw" into *kh, *kw; returns a pointer past the size.
+static const char *parse_size(const char *s, int *kh, int *kw) {
+    char *end;
+    long a = strtol(s, &end, 10);
+    if (end == s) return NULL;
+    long b = a;
+    if (*end == 'x' || *end == 'X') {
+        const char *q = end + 1;
+        b = strtol(q, &end, 10);
+        if (end == q) return NULL;
+    }
+    *kh = (int)a;
+    *kw = (int)b;
+    return end;
+}
+
+int conv_kernel_from_spec(conv_kernel_t *k, const char *spec) {
+    const char *p = spec;
+    while (isdigit((unsigned char)*p)) ++p;
+    if (p != spec && *p == '\0') {
+        int n = atoi(spec);
+        if (n == 3) return make_edge_kernel_3x3(k);
+        return make_box_blur_kernel(k, n, n);
+    }
+
+    const char *colon = strchr(spec, ':');
+    size_t nlen = colon ? (size_t)(colon - spec) : strlen(spec);
+    if (nlen == 4 && strncmp(spec, "file", 4) == 0 && colon) {
+        return conv_kernel_load(k, colon + 1);
+    }
+
+    int kh = 3, kw = 3;
+    double param = 0.0;
+    if (colon) {
+        const char *rest = parse_size(colon + 1, &kh, &kw);
+        if (!rest || (*rest != '\0' && *rest != ':')) {
+            fprintf(stderr, "Error: bad kernel size in spec '%s'\n", spec);
+            return -1;
+        }
+        if (*rest == ':') param = atof(rest + 1);
+    }
+
+#define SPEC_IS(s) (nlen == sizeof(s) - 1 && strncmp(spec, s, nlen) == 0)
+    if (SPEC_IS("box"))      return make_box_blur_kernel(k, kh, kw);
+    if (SPEC_IS("edge"))     return make_edge_kernel_3x3(k);
+    if (SPEC_IS("gaussian")) return make_gaussian_kernel(k, kh, kw, param);
+    if (SPEC_IS("log"))      return make_log_kernel(k, kh, kw, param);
+    if (SPEC_IS("sobelx"))   return make_sobel_kernel(k, kh, kw, 0);
+    if (SPEC_IS("sobely"))   return make_sobel_kernel(k, kh, kw, 1);
+    if (SPEC_IS("sharpen"))  return make_sharpen_kernel(k, kh, kw, param);
+    if (SPEC_IS("motion"))   return make_motion_blur_kernel(k, kh, kw, param);
+#undef SPEC_IS
+
+    // A bare existing path is accepted as a kernel file too.
+    FILE *f = fopen(spec, "rb");
+    if (f) {
+        fclose(f);
+        return conv_kernel_load(k, spec);
+    }
+    fprintf(stderr, "Error: unknown kernel spec '%s'\n", spec);
+    return -1;
+}
+
+void conv_kernel_describe(const conv_kernel_t *k, FILE *f) {
+    fprintf(f, "Kernel: %s (%dx%d%s%s%s%s)\n", k->name, k->kh, k->kw,
+            k->separable ? ", separable" : "",
+            k->symmetric ? ", symmetric" : "",
+            k->integer ? ", integer" : "",
+            k->constant ? ", constant" : "");
+}
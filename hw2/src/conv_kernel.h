@@ -0,0 +1,74 @@
+// HW2 - Convolution kernels
+// ------------------------------------------------------------
+// A kernel is a kh x kw grid of taps (both dimensions odd) plus a
+// few properties that the convolution engine uses to choose a fast
+// path automatically:
+//   - separable: the taps are an outer product col (kh) x row (kw),
+//                so the 2D convolution can run as two 1D passes.
+//   - symmetric: the taps are point-symmetric around the centre,
+//                so correlation and convolution give the same result.
+//   - integer:   every tap is a whole number, so the sum can be
+//                accumulated exactly in integer arithmetic.
+//   - constant:  every tap has the same value (box filter).
+//
+// Kernels are built from a short text spec (see conv_kernel_from_spec)
+// or loaded from a text / binary file.
+
+#ifndef CONV_KERNEL_H
+#define CONV_KERNEL_H
+
+#include <stdio.h>
+
+typedef struct {
+    int kh, kw;          // kernel height and width (odd)
+    double *data;        // kh * kw taps, row-major
+    double *col;         // kh vertical factors (valid if separable)
+    double *row;         // kw horizontal factors (valid if separable)
+    int separable;
+    int symmetric;
+    int integer;
+    int constant;
+    char name[64];       // human readable description
+} conv_kernel_t;
+
+// Allocate a zeroed kh x kw kernel. Returns 0 on success.
+int  conv_kernel_init(conv_kernel_t *k, int kh, int kw);
+void conv_kernel_free(conv_kernel_t *k);
+
+// Recompute the separable / symmetric / integer / constant flags
+// (and the rank-1 factors) from the current taps.
+void conv_kernel_analyze(conv_kernel_t *k);
+
+// Generators. All of them allocate the kernel, fill it and analyze it.
+// Sizes must be positive and odd; sigma <= 0 picks a default from the
+// size. Return 0 on success.
+int make_edge_kernel_3x3(conv_kernel_t *k);
+int make_box_blur_kernel(conv_kernel_t *k, int kh, int kw);
+int make_gaussian_kernel(conv_kernel_t *k, int kh, int kw, double sigma);
+int make_log_kernel(conv_kernel_t *k, int kh, int kw, double sigma);
+int make_sobel_kernel(conv_kernel_t *k, int kh, int kw, int dir_y);
+int make_sharpen_kernel(conv_kernel_t *k, int kh, int kw, double amount);
+int make_motion_blur_kernel(conv_kernel_t *k, int kh, int kw, double angle_deg);
+
+// Load a kernel from a file. Two formats are accepted:
+//   text:   "kh kw" followed by kh*kw numbers ('#' starts a comment)
+//   binary: the 4 bytes "CKRN", int32 kh, int32 kw, kh*kw doubles
+int conv_kernel_load(conv_kernel_t *k, const char *path);
+
+// Build a kernel from a command line spec:
+//   <n>                      legacy: 3 = edge kernel, other = n x n box blur
+//   box:<size>               normalized box blur
+//   gaussian:<size>[:sigma]  Gaussian blur
+//   log:<size>[:sigma]       Laplacian of Gaussian
+//   sobelx:<size>            Sobel derivative along x
+//   sobely:<size>            Sobel derivative along y
+//   sharpen:<size>[:amount]  sharpening filter
+//   motion:<size>[:angle]    linear motion blur (angle in degrees)
+//   file:<path>              load from file (see conv_kernel_load)
+// <size> is either "k" (k x k) or "khxkw", e.g. "gaussian:9x5:2.0".
+int conv_kernel_from_spec(conv_kernel_t *k, const char *spec);
+
+// Print the kernel name, size and flags on one line.
+void conv_kernel_describe(const conv_kernel_t *k, FILE *f);
+
+#endif // CONV_KERNEL_H
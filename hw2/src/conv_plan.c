@@ -0,0 +1,248 @@
+// HW2 - Convolution planner: cost model, calibration and wisdom file.
+
+#include "conv_plan.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define WISDOM_MAGIC "# conv wisdom v1"
+
+static const char *alg_names[CONV_ALG_COUNT] = {
+    "direct", "integer", "separable", "sat", "fft", "winograd"
+};
+
+const char *conv_alg_name(conv_alg_t alg) {
+    return alg_names[alg];
+}
+
+conv_rows_fn conv_alg_rows(conv_alg_t alg) {
+    switch (alg) {
+    case CONV_ALG_INTEGER:   return convolve_int_rows;
+    case CONV_ALG_SEPARABLE: return convolve_separable_rows;
+    case CONV_ALG_SAT:       return convolve_sat_rows;
+    case CONV_ALG_FFT:       return convolve_fft_rows;
+    case CONV_ALG_WINOGRAD:  return convolve_winograd_rows;
+    default:                 return convolve_baseline_rows;
+    }
+}
+
+// Largest |sum| convolve_int_rows can reach: 255 * sum |tap|, which must
+// fit its int accumulator.
+static double int_sum_bound(const conv_kernel_t *kernel) {
+    double s = 0.0;
+    for (int i = 0; i < kernel->kh * kernel->kw; ++i) s += fabs(round(kernel->data[i]));
+    return 255.0 * s;
+}
+
+int conv_alg_applicable(conv_alg_t alg, const conv_kernel_t *kernel) {
+    switch (alg) {
+    case CONV_ALG_DIRECT:    return 1;
+    case CONV_ALG_INTEGER:   return kernel->integer && int_sum_bound(kernel) <= INT_MAX;
+    case CONV_ALG_SEPARABLE: return kernel->separable && kernel->kh > 1 && kernel->kw > 1;
+    case CONV_ALG_SAT:       return kernel->constant && 255.0 * kernel->kh * kernel->kw < 4294967296.0;
+    case CONV_ALG_FFT:       return kernel->kh > 1 || kernel->kw > 1;
+    case CONV_ALG_WINOGRAD:  return kernel->kh == 3 && kernel->kw == 3;
+    default:                 return 0;
+    }
+}
+
+double conv_alg_ops(conv_alg_t alg, int w, int h, int ch, const conv_kernel_t *kernel) {
+    double pixels = (double)w * h * ch;
+    switch (alg) {
+    case CONV_ALG_DIRECT:
+    case CONV_ALG_INTEGER:
+        return pixels * kernel->kh * kernel->kw;
+    case CONV_ALG_SEPARABLE:
+        return pixels * (kernel->kh + kernel->kw);
+    case CONV_ALG_SAT:
+    case CONV_ALG_WINOGRAD:
+        return pixels;
+    case CONV_ALG_FFT: {
+        int t = conv_fft_tile_size(kernel->kh, kernel->kw);
+        double tiles = ceil((double)h / (t - kernel->kh + 1)) *
+                       ceil((double)w / (t - kernel->kw + 1));
+        // Two real jobs per complex transform, forward + inverse.
+        return tiles * ch * (double)t * t * log2((double)t * t);
+    }
+    default:
+        return 0.0;
+    }
+}
+
+static void read_host(char *host, size_t size) {
+    snprintf(host, size, "unknown");
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    if (!f) return;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "model name", 10) == 0) {
+            char *p = strchr(line, ':');
+            if (p) {
+                p += 1 + strspn(p + 1, " \t");
+                p[strcspn(p, "\n")] = '\0';
+                snprintf(host, size, "%s", p);
+            }
+            break;
+        }
+    }
+    fclose(f);
+}
+
+void conv_wisdom_defaults(conv_wisdom_t *wis) {
+    // Rough costs (seconds per counted op) measured once on an -O2
+    // x86-64 build; calibration replaces them with local numbers.
+    static const double defaults[CONV_ALG_COUNT] = {
+        2.5e-9,   // direct: clamped load + fma per tap
+        0.8e-9,   // integer: unclamped int multiply-add per tap
+        0.6e-9,   // separable: vectorizable fma per tap
+        6.0e-9,   // sat: table build + 4 lookups per pixel
+        1.2e-9,   // fft: per butterfly-ish element step
+        12.0e-9,  // winograd: transforms per pixel
+    };
+    memcpy(wis->sec_per_op, defaults, sizeof(defaults));
+    wis->calibrated = 0;
+    read_host(wis->host, sizeof(wis->host));
+}
+
+int conv_wisdom_load(conv_wisdom_t *wis, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+
+    conv_wisdom_t tmp;
+    conv_wisdom_defaults(&tmp);
+    char host[128];
+    read_host(host, sizeof(host));
+
+    char line[256];
+    int ok = fgets(line, sizeof(line), f) && strncmp(line, WISDOM_MAGIC, strlen(WISDOM_MAGIC)) == 0;
+    while (ok && fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\n")] = '\0';
+        if (strncmp(line, "host ", 5) == 0) {
+            snprintf(tmp.host, sizeof(tmp.host), "%.127s", line + 5);
+            continue;
+        }
+        char name[32];
+        double v;
+        if (sscanf(line, "%31s %lf", name, &v) != 2) continue;
+        for (int a = 0; a < CONV_ALG_COUNT; ++a)
+            if (strcmp(name, alg_names[a]) == 0 && v > 0.0) tmp.sec_per_op[a] = v;
+    }
+    fclose(f);
+
+    if (!ok || strcmp(tmp.host, host) != 0) return -1;
+    tmp.calibrated = 1;
+    *wis = tmp;
+    return 0;
+}
+
+int conv_wisdom_save(const conv_wisdom_t *wis, const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Warning: could not write wisdom file '%s'\n", path);
+        return -1;
+    }
+    fprintf(f, "%s\n", WISDOM_MAGIC);
+    fprintf(f, "host %s\n", wis->host);
+    for (int a = 0; a < CONV_ALG_COUNT; ++a)
+        fprintf(f, "%s %.6e\n", alg_names[a], wis->sec_per_op[a]);
+    fclose(f);
+    return 0;
+}
+
+static double now_sec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+void conv_wisdom_calibrate(conv_wisdom_t *wis) {
+    // One representative kernel per algorithm, timed (best of 3) on a
+    // 256 x 256 x 3 pseudo-random image.
+    static const char *specs[CONV_ALG_COUNT] = {
+        "log:7", "sobelx:7", "gaussian:9", "box:15", "log:31", "log:3"
+    };
+    const int w = 256, h = 256, ch = 3;
+    size_t n = (size_t)w * h * ch;
+    unsigned char *in = (unsigned char *)malloc(n);
+    unsigned char *out = (unsigned char *)malloc(n);
+    if (!in || !out) {
+        free(in);
+        free(out);
+        return;
+    }
+    unsigned int seed = 12345u;
+    for (size_t i = 0; i < n; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        in[i] = (unsigned char)(seed >> 16);
+    }
+
+    for (int a = 0; a < CONV_ALG_COUNT; ++a) {
+        conv_kernel_t k;
+        if (conv_kernel_from_spec(&k, specs[a]) != 0) continue;
+        conv_rows_fn fn = conv_alg_rows((conv_alg_t)a);
+        double best = 1e30;
+        for (int rep = 0; rep < 3; ++rep) {
+            double t0 = now_sec();
+            fn(in, out, w, h, ch, &k, 0, h);
+            double dt = now_sec() - t0;
+            if (dt < best) best = dt;
+        }
+        double ops = conv_alg_ops((conv_alg_t)a, w, h, ch, &k);
+        if (ops > 0.0 && best > 0.0) wis->sec_per_op[a] = best / ops;
+        conv_kernel_free(&k);
+    }
+    wis->calibrated = 1;
+    read_host(wis->host, sizeof(wis->host));
+
+    free(in);
+    free(out);
+}
+
+static double predict(const conv_wisdom_t *wis, conv_alg_t alg,
+                      int w, int h, int ch, const conv_kernel_t *kernel,
+                      int threads) {
+    int t = threads < 1 ? 1 : (threads > h ? h : threads);
+    return conv_alg_ops(alg, w, h, ch, kernel) * wis->sec_per_op[alg] / t;
+}
+
+conv_plan_t conv_plan_create(const conv_wisdom_t *wis,
+                             int w, int h, int ch,
+                             const conv_kernel_t *kernel,
+                             int threads) {
+    conv_plan_t plan;
+    plan.alg = CONV_ALG_DIRECT;
+    plan.threads = threads;
+    plan.predicted = predict(wis, CONV_ALG_DIRECT, w, h, ch, kernel, threads);
+    for (int a = 1; a < CONV_ALG_COUNT; ++a) {
+        if (!conv_alg_applicable((conv_alg_t)a, kernel)) continue;
+        double p = predict(wis, (conv_alg_t)a, w, h, ch, kernel, threads);
+        if (p < plan.predicted) {
+            plan.alg = (conv_alg_t)a;
+            plan.predicted = p;
+        }
+    }
+    plan.fn = conv_alg_rows(plan.alg);
+    return plan;
+}
+
+void conv_plan_print(const conv_plan_t *plan, const conv_wisdom_t *wis,
+                     int w, int h, int ch, const conv_kernel_t *kernel,
+                     FILE *f) {
+    fprintf(f, "Plan: %s, %d thread(s), predicted %.6f s (%s costs)\n",
+            conv_alg_name(plan->alg), plan->threads, plan->predicted,
+            wis->calibrated ? "calibrated" : "default");
+    for (int a = 0; a < CONV_ALG_COUNT; ++a) {
+        if (!conv_alg_applicable((conv_alg_t)a, kernel)) {
+            fprintf(f, "  %-10s n/a\n", alg_names[a]);
+            continue;
+        }
+        fprintf(f, "  %-10s %12.0f ops  %.3e s/op  predicted %.6f s%s\n",
+                alg_names[a], conv_alg_ops((conv_alg_t)a, w, h, ch, kernel),
+                wis->sec_per_op[a],
+                predict(wis, (conv_alg_t)a, w, h, ch, kernel, plan->threads),
+                a == (int)plan->alg ? "  <=" : "");
+    }
+}
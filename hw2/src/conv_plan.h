@@ -0,0 +1,77 @@
+// HW2 - Convolution planner
+// ------------------------------------------------------------
+// Chooses the convolution algorithm for a given image size, channel
+// count, kernel and thread count from a simple cost model:
+//
+//     predicted_seconds = ops(alg) * seconds_per_op(alg) / threads
+//
+// ops() counts the dominant operation of each algorithm (taps for the
+// direct loops, taps of both passes for separable, table lookups for
+// SAT, butterflies for FFT, ...). The per-op costs start from built-in
+// estimates and are refined by a calibration run whose results are
+// stored in a "wisdom" file (like FFTW's) and reused on later runs.
+
+#ifndef CONV_PLAN_H
+#define CONV_PLAN_H
+
+#include <stdio.h>
+
+#include "conv_kernel.h"
+#include "convolve.h"
+
+typedef enum {
+    CONV_ALG_DIRECT = 0,
+    CONV_ALG_INTEGER,
+    CONV_ALG_SEPARABLE,
+    CONV_ALG_SAT,
+    CONV_ALG_FFT,
+    CONV_ALG_WINOGRAD,
+    CONV_ALG_COUNT
+} conv_alg_t;
+
+typedef struct {
+    double sec_per_op[CONV_ALG_COUNT];
+    int calibrated;        // 1 if the costs came from a calibration run
+    char host[128];        // CPU the costs were measured on
+} conv_wisdom_t;
+
+typedef struct {
+    conv_alg_t alg;
+    conv_rows_fn fn;
+    int threads;
+    double predicted;      // seconds
+} conv_plan_t;
+
+const char *conv_alg_name(conv_alg_t alg);
+conv_rows_fn conv_alg_rows(conv_alg_t alg);
+
+// 1 if 'alg' can compute this kernel exactly (up to rounding).
+int conv_alg_applicable(conv_alg_t alg, const conv_kernel_t *kernel);
+
+// Dominant operation count of 'alg' for one w x h x ch image.
+double conv_alg_ops(conv_alg_t alg, int w, int h, int ch, const conv_kernel_t *kernel);
+
+// Built-in per-op costs for the current host (not calibrated).
+void conv_wisdom_defaults(conv_wisdom_t *wis);
+
+// Read a wisdom file. Returns 0 if it exists and was measured on this
+// CPU, -1 otherwise (wis is then left at its previous contents).
+int conv_wisdom_load(conv_wisdom_t *wis, const char *path);
+int conv_wisdom_save(const conv_wisdom_t *wis, const char *path);
+
+// Time every algorithm on a small synthetic image and store the
+// measured seconds per op in 'wis'.
+void conv_wisdom_calibrate(conv_wisdom_t *wis);
+
+// Cheapest applicable algorithm under the cost model.
+conv_plan_t conv_plan_create(const conv_wisdom_t *wis,
+                             int w, int h, int ch,
+                             const conv_kernel_t *kernel,
+                             int threads);
+
+// Print the chosen plan and the predicted cost of every candidate.
+void conv_plan_print(const conv_plan_t *plan, const conv_wisdom_t *wis,
+                     int w, int h, int ch, const conv_kernel_t *kernel,
+                     FILE *f);
+
+#endif // CONV_PLAN_H
@@ -0,0 +1,636 @@
+// HW2 - Parallel 2D Convolution using Pthreads
+// Convolution engines: baseline, loop orders, tiling, unrolling,
+// kernel-specific fast paths and the pthreads band driver.
+
+#include "convolve.h"
+#include "topology.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Safe pixel access with clamped boundary conditions.
+// If (x, y) is outside the image, it is clamped to the nearest
+// valid coordinate.
+static unsigned char get_pixel(const unsigned char *img,
+                               int w, int h, int ch,
+                               int x, int y, int c) {
+    if (x < 0) x = 0;
+    if (x >= w) x = w - 1;
+    if (y < 0) y = 0;
+    if (y >= h) y = h - 1;
+    if (c < 0) c = 0;
+    if (c >= ch) c = ch - 1;
+
+    int idx = (y * w + x) * ch + c;
+    return img[idx];
+}
+
+// Generic 2D convolution for an image with "ch" channels.
+// - in:  input image buffer (width * height * channels)
+// - out: output image buffer (same size as input)
+// - w, h, ch: image width, height, and number of channels
+// - kernel: kh x kw convolution kernel (both odd, e.g. 3, 5, 15, ...)
+void convolve_baseline_rows(const unsigned char *in,
+                            unsigned char *out,
+                            int w, int h, int ch,
+                            const conv_kernel_t *kernel,
+                            int y_start, int y_end) {
+    int ry = kernel->kh / 2; // vertical radius
+    int rx = kernel->kw / 2; // horizontal radius
+    int kw = kernel->kw;
+    const double *taps = kernel->data;
+    if (y_start < 0) y_start = 0;
+    if (y_end > h) y_end = h;
+
+    for (int y = y_start; y < y_end; ++y) {
+        for (int x = 0; x < w; ++x) {
+            for (int c = 0; c < ch; ++c) {
+                double sum = 0.0;
+
+                for (int ky = -ry; ky <= ry; ++ky) {
+                    for (int kx = -rx; kx <= rx; ++kx) {
+                        int sx = x + kx;
+                        int sy = y + ky;
+                        unsigned char p = get_pixel(in, w, h, ch, sx, sy, c);
+                        double kval = taps[(ky + ry) * kw + (kx + rx)];
+                        sum += p * kval;
+                    }
+                }
+
+                int iv = (int)lround(sum);
+                out[(y * w + x) * ch + c] = clamp_u8(iv);
+            }
+        }
+    }
+}
+
+// Separable path: a horizontal pass with kernel->row into a ring of
+// kh rows, then a vertical pass with kernel->col over that ring. Each
+// source row is filtered horizontally exactly once per band.
+void convolve_separable_rows(const unsigned char *in,
+                             unsigned char *out,
+                             int w, int h, int ch,
+                             const conv_kernel_t *kernel,
+                             int y_start, int y_end) {
+    int kh = kernel->kh, kw = kernel->kw;
+    int ry = kh / 2, rx = kw / 2;
+    size_t stride = (size_t)w * ch;
+    if (y_start < 0) y_start = 0;
+    if (y_end > h) y_end = h;
+    if (y_start >= y_end) return;
+
+    double *ring = (double *)malloc((size_t)kh * stride * sizeof(double));
+    double *line = (double *)malloc((size_t)(w + 2 * rx) * ch * sizeof(double));
+    double *acc = (double *)malloc(stride * sizeof(double));
+    if (!ring || !line || !acc) {
+        free(ring);
+        free(line);
+        free(acc);
+        convolve_baseline_rows(in, out, w, h, ch, kernel, y_start, y_end);
+        return;
+    }
+
+    int v0 = y_start - ry;
+    for (int v = v0; v < y_end + ry; ++v) {
+        // Horizontal pass on (clamped) source row v into ring slot.
+        const unsigned char *src = in + (size_t)clamp_int(v, 0, h - 1) * stride;
+        for (int x = -rx; x < w + rx; ++x) {
+            const unsigned char *p = src + (size_t)clamp_int(x, 0, w - 1) * ch;
+            for (int c = 0; c < ch; ++c) line[(x + rx) * ch + c] = p[c];
+        }
+        double *dst = ring + (size_t)((v - v0) % kh) * stride;
+        for (size_t i = 0; i < stride; ++i) dst[i] = 0.0;
+        for (int kx = 0; kx < kw; ++kx) {
+            double kval = kernel->row[kx];
+            const double *l = line + (size_t)kx * ch;
+            for (size_t i = 0; i < stride; ++i) dst[i] += kval * l[i];
+        }
+
+        // Vertical pass once the ring holds rows y - ry .. y + ry.
+        int y = v - ry;
+        if (y < y_start) continue;
+        for (size_t i = 0; i < stride; ++i) acc[i] = 0.0;
+        for (int ky = 0; ky < kh; ++ky) {
+            double kval = kernel->col[ky];
+            const double *r = ring + (size_t)((y - y_start + ky) % kh) * stride;
+            for (size_t i = 0; i < stride; ++i) acc[i] += kval * r[i];
+        }
+        unsigned char *o = out + (size_t)y * stride;
+        for (size_t i = 0; i < stride; ++i) o[i] = clamp_u8((int)lround(acc[i]));
+    }
+
+    free(ring);
+    free(line);
+    free(acc);
+}
+
+// Integer path: taps are whole numbers, so accumulate exactly in int
+// and skip the lround. Only border pixels pay for clamping.
+void convolve_int_rows(const unsigned char *in,
+                       unsigned char *out,
+                       int w, int h, int ch,
+                       const conv_kernel_t *kernel,
+                       int y_start, int y_end) {
+    int kh = kernel->kh, kw = kernel->kw;
+    int ry = kh / 2, rx = kw / 2;
+    size_t stride = (size_t)w * ch;
+    int *taps = (int *)malloc((size_t)kh * kw * sizeof(int));
+    const unsigned char **rows = (const unsigned char **)malloc((size_t)kh * sizeof(*rows));
+    if (!taps || !rows) {
+        free(taps);
+        free(rows);
+        convolve_baseline_rows(in, out, w, h, ch, kernel, y_start, y_end);
+        return;
+    }
+    for (int i = 0; i < kh * kw; ++i) taps[i] = (int)lround(kernel->data[i]);
+    if (y_start < 0) y_start = 0;
+    if (y_end > h) y_end = h;
+
+    for (int y = y_start; y < y_end; ++y) {
+        for (int ky = 0; ky < kh; ++ky)
+            rows[ky] = in + (size_t)clamp_int(y + ky - ry, 0, h - 1) * stride;
+        for (int x = 0; x < w; ++x) {
+            int interior = (x >= rx && x < w - rx);
+            for (int c = 0; c < ch; ++c) {
+                int sum = 0;
+                for (int ky = 0; ky < kh; ++ky) {
+                    const int *t = taps + ky * kw;
+                    const unsigned char *r = rows[ky];
+                    if (interior) {
+                        const unsigned char *p = r + (size_t)(x - rx) * ch + c;
+                        for (int kx = 0; kx < kw; ++kx) sum += t[kx] * p[kx * ch];
+                    } else {
+                        for (int kx = 0; kx < kw; ++kx) {
+                            int sx = clamp_int(x + kx - rx, 0, w - 1);
+                            sum += t[kx] * r[(size_t)sx * ch + c];
+                        }
+                    }
+                }
+                out[(size_t)y * stride + (size_t)x * ch + c] = clamp_u8(sum);
+            }
+        }
+    }
+
+    free(taps);
+    free(rows);
+}
+
+void convolve_baseline(const unsigned char *in,
+                       unsigned char *out,
+                       int w, int h, int ch,
+                       const conv_kernel_t *kernel) {
+    convolve_baseline_rows(in, out, w, h, ch, kernel, 0, h);
+}
+
+// Loop-order variant.
+// 'order' switches between different loop nestings.
+void convolve_looporder(const unsigned char *in,
+                        unsigned char *out,
+                        int w, int h, int ch,
+                        const conv_kernel_t *kernel,
+                        int order) {
+    int ry = kernel->kh / 2;
+    int rx = kernel->kw / 2;
+    int kw = kernel->kw;
+    const double *taps = kernel->data;
+
+    if (order == 1) {
+        // Order: x, y, c, ky, kx
+        for (int x = 0; x < w; ++x) {
+            for (int y = 0; y < h; ++y) {
+                for (int c = 0; c < ch; ++c) {
+                    double sum = 0.0;
+                    for (int ky = -ry; ky <= ry; ++ky) {
+                        for (int kx = -rx; kx <= rx; ++kx) {
+                            int sx = x + kx;
+                            int sy = y + ky;
+                            unsigned char p = get_pixel(in, w, h, ch, sx, sy, c);
+                            double kval = taps[(ky + ry) * kw + (kx + rx)];
+                            sum += p * kval;
+                        }
+                    }
+                    int iv = (int)lround(sum);
+                    out[(y * w + x) * ch + c] = clamp_u8(iv);
+                }
+            }
+        }
+    } else if (order == 2) {
+        // Order: c, y, x, ky, kx
+        for (int c = 0; c < ch; ++c) {
+            for (int y = 0; y < h; ++y) {
+                for (int x = 0; x < w; ++x) {
+                    double sum = 0.0;
+                    for (int ky = -ry; ky <= ry; ++ky) {
+                        for (int kx = -rx; kx <= rx; ++kx) {
+                            int sx = x + kx;
+                            int sy = y + ky;
+                            unsigned char p = get_pixel(in, w, h, ch, sx, sy, c);
+                            double kval = taps[(ky + ry) * kw + (kx + rx)];
+                            sum += p * kval;
+                        }
+                    }
+                    int iv = (int)lround(sum);
+                    out[(y * w + x) * ch + c] = clamp_u8(iv);
+                }
+            }
+        }
+    } else {
+        // Fallback to baseline order (y, x, c, ky, kx)
+        convolve_baseline(in, out, w, h, ch, kernel);
+    }
+}
+
+// Tiled variant.
+// 'tile_y' and 'tile_x' control the tile size; only rows
+// [y_start, y_end) are produced.
+void convolve_tiled_rows(const unsigned char *in,
+                         unsigned char *out,
+                         int w, int h, int ch,
+                         const conv_kernel_t *kernel,
+                         int tile_y, int tile_x,
+                         int y_start, int y_end) {
+    int ry = kernel->kh / 2;
+    int rx = kernel->kw / 2;
+    int kw = kernel->kw;
+    const double *taps = kernel->data;
+    if (tile_y <= 0 || tile_x <= 0) {
+        convolve_baseline_rows(in, out, w, h, ch, kernel, y_start, y_end);
+        return;
+    }
+    if (y_start < 0) y_start = 0;
+    if (y_end > h) y_end = h;
+
+    for (int by = y_start; by < y_end; by += tile_y) {
+        int by_end = by + tile_y;
+        if (by_end > y_end) by_end = y_end;
+
+        for (int bx = 0; bx < w; bx += tile_x) {
+            int x_end = bx + tile_x;
+            if (x_end > w) x_end = w;
+            // Tile index in row-major tile order.
+            TRACE_SCOPE_ARG("tile", (long)(by / tile_y) * ((w + tile_x - 1) / tile_x) + bx / tile_x);
+
+            for (int y = by; y < by_end; ++y) {
+                for (int x = bx; x < x_end; ++x) {
+                    for (int c = 0; c < ch; ++c) {
+                        double sum = 0.0;
+                        for (int ky = -ry; ky <= ry; ++ky) {
+                            for (int kx = -rx; kx <= rx; ++kx) {
+                                int sx = x + kx;
+                                int sy = y + ky;
+                                unsigned char p = get_pixel(in, w, h, ch, sx, sy, c);
+                                double kval = taps[(ky + ry) * kw + (kx + rx)];
+                                sum += p * kval;
+                            }
+                        }
+                        int iv = (int)lround(sum);
+                        out[(y * w + x) * ch + c] = clamp_u8(iv);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void convolve_tiled(const unsigned char *in,
+                    unsigned char *out,
+                    int w, int h, int ch,
+                    const conv_kernel_t *kernel,
+                    int tile_y, int tile_x) {
+    convolve_tiled_rows(in, out, w, h, ch, kernel, tile_y, tile_x, 0, h);
+}
+
+// Unrolled variant.
+// 'unroll_factor' unrolls the inner x-loop; only rows
+// [y_start, y_end) are produced.
+void convolve_unrolled_rows(const unsigned char *in,
+                            unsigned char *out,
+                            int w, int h, int ch,
+                            const conv_kernel_t *kernel,
+                            int unroll_factor,
+                            int y_start, int y_end) {
+    int ry = kernel->kh / 2;
+    int rx = kernel->kw / 2;
+    int kw = kernel->kw;
+    const double *taps = kernel->data;
+    if (unroll_factor <= 1) {
+        convolve_baseline_rows(in, out, w, h, ch, kernel, y_start, y_end);
+        return;
+    }
+    if (unroll_factor > 32) {
+        unroll_factor = 32;
+    }
+    if (y_start < 0) y_start = 0;
+    if (y_end > h) y_end = h;
+
+    for (int y = y_start; y < y_end; ++y) {
+        int x = 0;
+        int limit = w - (w % unroll_factor);
+
+        // Unrolled part
+        for (x = 0; x < limit; x += unroll_factor) {
+            for (int c = 0; c < ch; ++c) {
+                double sum[32]; // supports unroll_factor up to 32 safely
+                for (int i = 0; i < unroll_factor; ++i) {
+                    sum[i] = 0.0;
+                }
+
+                for (int ky = -ry; ky <= ry; ++ky) {
+                    for (int kx = -rx; kx <= rx; ++kx) {
+                        int sx_base = x + kx;
+                        int sy = y + ky;
+                        double kval = taps[(ky + ry) * kw + (kx + rx)];
+                        for (int i = 0; i < unroll_factor; ++i) {
+                            int sx = sx_base + i;
+                            unsigned char p = get_pixel(in, w, h, ch, sx, sy, c);
+                            sum[i] += p * kval;
+                        }
+                    }
+                }
+
+                for (int i = 0; i < unroll_factor; ++i) {
+                    int iv = (int)lround(sum[i]);
+                    int xx = x + i;
+                    out[(y * w + xx) * ch + c] = clamp_u8(iv);
+                }
+            }
+        }
+
+        // Remainder (tail) part
+        for (; x < w; ++x) {
+            for (int c = 0; c < ch; ++c) {
+                double sum = 0.0;
+                for (int ky = -ry; ky <= ry; ++ky) {
+                    for (int kx = -rx; kx <= rx; ++kx) {
+                        int sx = x + kx;
+                        int sy = y + ky;
+                        unsigned char p = get_pixel(in, w, h, ch, sx, sy, c);
+                        double kval = taps[(ky + ry) * kw + (kx + rx)];
+                        sum += p * kval;
+                    }
+                }
+                int iv = (int)lround(sum);
+                out[(y * w + x) * ch + c] = clamp_u8(iv);
+            }
+        }
+    }
+}
+
+void convolve_unrolled(const unsigned char *in,
+                       unsigned char *out,
+                       int w, int h, int ch,
+                       const conv_kernel_t *kernel,
+                       int unroll_factor) {
+    convolve_unrolled_rows(in, out, w, h, ch, kernel, unroll_factor, 0, h);
+}
+
+// One band of work. 'fn' is used when set; otherwise the tiled or
+// unrolled loop transform selected by 'tile' / 'unroll' runs.
+typedef struct {
+    conv_rows_fn fn;
+    int tile, unroll;
+    const unsigned char *in;
+    unsigned char *out;
+    int w, h, ch;
+    const conv_kernel_t *kernel;
+    int y_start, y_end;
+    int y_step;   // rows from one band of this thread to its next, 0 = one band
+    int cpu;
+} thread_args_t;
+
+// Process-wide band affinity (conv_set_affinity).
+static int *band_cpus = NULL;
+static int band_ncpus = 0;
+
+void conv_set_affinity(const int *cpus, int n) {
+    free(band_cpus);
+    band_cpus = NULL;
+    band_ncpus = 0;
+    if (!cpus || n <= 0) {
+        return;
+    }
+    band_cpus = (int *)malloc(sizeof(int) * n);
+    if (band_cpus) {
+        memcpy(band_cpus, cpus, sizeof(int) * n);
+        band_ncpus = n;
+    }
+}
+
+// Process-wide band height (conv_set_band_rows), 0 = one band per thread.
+static int band_rows = 0;
+
+void conv_set_band_rows(int rows) {
+    band_rows = rows > 0 ? rows : 0;
+}
+
+static void run_rows(const thread_args_t *t) {
+    TRACE_SCOPE_ARG("band", t->y_start);
+    if (t->fn) {
+        t->fn(t->in, t->out, t->w, t->h, t->ch,
+              t->kernel, t->y_start, t->y_end);
+    } else if (t->tile > 0) {
+        convolve_tiled_rows(t->in, t->out, t->w, t->h, t->ch, t->kernel,
+                            t->tile, t->tile, t->y_start, t->y_end);
+    } else {
+        convolve_unrolled_rows(t->in, t->out, t->w, t->h, t->ch, t->kernel,
+                               t->unroll, t->y_start, t->y_end);
+    }
+}
+
+// Run the thread's bands: [y_start, y_end), then the same number of
+// rows every y_step rows until the end of the image.
+static void run_band(const thread_args_t *t) {
+    thread_args_t b = *t;
+    int rows = t->y_end - t->y_start;
+    for (int y = t->y_start; y < t->h; y += t->y_step) {
+        b.y_start = y;
+        b.y_end = y + rows < t->h ? y + rows : t->h;
+        run_rows(&b);
+        if (t->y_step <= 0) {
+            break;
+        }
+    }
+}
+
+static void *thread_func(void *arg) {
+    const thread_args_t *t = (const thread_args_t *)arg;
+    if (t->cpu >= 0 && topo_pin_thread(t->cpu) != 0) {
+        fprintf(stderr, "Warning: could not pin thread to CPU %d\n", t->cpu);
+    }
+    if (trace_on) {
+        char name[32];
+        if (t->y_step > 0) {
+            snprintf(name, sizeof(name), "rows %d-%d every %d", t->y_start, t->y_end, t->y_step);
+        } else {
+            snprintf(name, sizeof(name), "rows %d-%d", t->y_start, t->y_end);
+        }
+        trace_thread_name(name);
+    }
+    run_band(t);
+    return NULL;
+}
+
+// Split [0, h) into 'threads' contiguous bands and run 'proto' (with
+// its y range replaced) on each of them. With a band height set and
+// more bands than threads, thread i instead takes bands i, i + threads,
+// ... of band_rows rows each.
+static void run_bands(const thread_args_t *proto, int threads) {
+    int h = proto->h;
+    thread_args_t whole = *proto;
+    whole.y_start = 0;
+    whole.y_end = h;
+    whole.y_step = 0;
+    if (threads <= 1) {
+        run_band(&whole);
+        return;
+    }
+    if (threads > h) {
+        threads = h;
+    }
+
+    pthread_t *tids = (pthread_t *)malloc(sizeof(pthread_t) * threads);
+    thread_args_t *args = (thread_args_t *)malloc(sizeof(thread_args_t) * threads);
+    if (!tids || !args) {
+        fprintf(stderr, "Warning: could not allocate thread structures, falling back to single-threaded run.\n");
+        free(tids);
+        free(args);
+        run_band(&whole);
+        return;
+    }
+
+    int interleave = band_rows > 0 && (h + band_rows - 1) / band_rows > threads;
+    int rows_per_thread = h / threads;
+    int remainder = h % threads;
+    int y = 0;
+
+    for (int i = 0; i < threads; ++i) {
+        int extra = (i < remainder) ? 1 : 0;
+        int y_start = interleave ? i * band_rows : y;
+        int y_end = interleave ? y_start + band_rows : y_start + rows_per_thread + extra;
+
+        args[i] = *proto;
+        args[i].y_start = y_start;
+        args[i].y_end = y_end;
+        args[i].y_step = interleave ? threads * band_rows : 0;
+        args[i].cpu = band_ncpus ? band_cpus[i % band_ncpus] : -1;
+
+        if (pthread_create(&tids[i], NULL, thread_func, &args[i]) != 0) {
+            fprintf(stderr, "Warning: pthread_create failed for thread %d, falling back to single-threaded run.\n", i);
+            for (int j = 0; j < i; ++j) {
+                pthread_join(tids[j], NULL);
+            }
+            free(tids);
+            free(args);
+            run_band(&whole);
+            return;
+        }
+
+        y = y_end;
+    }
+
+    for (int i = 0; i < threads; ++i) {
+        pthread_join(tids[i], NULL);
+    }
+
+    free(tids);
+    free(args);
+}
+
+void run_pthreads_rows(conv_rows_fn fn,
+                       const unsigned char *in,
+                       unsigned char *out,
+                       int w, int h, int ch,
+                       const conv_kernel_t *kernel,
+                       int threads) {
+    thread_args_t proto = { fn, 0, 0, in, out, w, h, ch, kernel, 0, h, 0, -1 };
+    run_bands(&proto, threads);
+}
+
+void run_pthreads_variant(const unsigned char *in,
+                          unsigned char *out,
+                          int w, int h, int ch,
+                          const conv_kernel_t *kernel,
+                          int tile, int unroll,
+                          int threads) {
+    conv_rows_fn fn = (tile <= 0 && unroll <= 1) ? convolve_baseline_rows : NULL;
+    thread_args_t proto = { fn, tile, unroll, in, out, w, h, ch, kernel, 0, h, 0, -1 };
+    run_bands(&proto, threads);
+}
+
+void run_pthreads_baseline(const unsigned char *in,
+                           unsigned char *out,
+                           int w, int h, int ch,
+                           const conv_kernel_t *kernel,
+                           int threads) {
+    run_pthreads_rows(convolve_baseline_rows, in, out, w, h, ch, kernel, threads);
+}
+
+// conv_rows_fn that first-touches rows [y_start, y_end) of 'out'.
+static void touch_rows(const unsigned char *in, unsigned char *out,
+                       int w, int h, int ch, const conv_kernel_t *kernel,
+                       int y_start, int y_end) {
+    (void)h;
+    (void)kernel;
+    size_t row = (size_t)w * ch;
+    size_t off = (size_t)y_start * row;
+    size_t len = (size_t)(y_end - y_start) * row;
+    if (in) {
+        memcpy(out + off, in + off, len);
+    } else {
+        memset(out + off, 0, len);
+    }
+}
+
+unsigned char *conv_alloc_banded(arena_t *arena, const unsigned char *src,
+                                 int w, int h, int ch, int threads) {
+    size_t size = (size_t)w * h * ch;
+    unsigned char *buf = arena ? (unsigned char *)arena_alloc(arena, size)
+                               : (unsigned char *)malloc(size);
+    if (buf) {
+        run_pthreads_rows(touch_rows, src, buf, w, h, ch, NULL, threads);
+    }
+    return buf;
+}
+
+#ifdef _OPENMP
+void convolve_baseline_omp(const unsigned char *in,
+                           unsigned char *out,
+                           int w, int h, int ch,
+                           const conv_kernel_t *kernel,
+                           int threads) {
+    int ry = kernel->kh / 2;
+    int rx = kernel->kw / 2;
+    int kw = kernel->kw;
+    const double *taps = kernel->data;
+    if (threads <= 0) {
+        threads = 1;
+    }
+
+#pragma omp parallel for collapse(2) num_threads(threads)
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            for (int c = 0; c < ch; ++c) {
+                double sum = 0.0;
+                for (int ky = -ry; ky <= ry; ++ky) {
+                    for (int kx = -rx; kx <= rx; ++kx) {
+                        int sx = x + kx;
+                        int sy = y + ky;
+                        unsigned char p = get_pixel(in, w, h, ch, sx, sy, c);
+                        double kval = taps[(ky + ry) * kw + (kx + rx)];
+                        sum += p * kval;
+                    }
+                }
+                int iv = (int)lround(sum);
+                out[(y * w + x) * ch + c] = clamp_u8(iv);
+            }
+        }
+    }
+}
+#endif
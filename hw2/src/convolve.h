@@ -0,0 +1,139 @@
+// HW2 - Convolution engines
+// ------------------------------------------------------------
+// All engines compute out = in (*) kernel on an interleaved
+// w x h x ch 8-bit image with clamped borders. The "rows" variants
+// only produce output rows [y_start, y_end) so they can be handed to
+// threads as horizontal bands.
+
+#ifndef CONVOLVE_H
+#define CONVOLVE_H
+
+#include "conv_kernel.h"
+#include "arena.h"
+
+// Clamp integer value to [0, 255]
+static inline unsigned char clamp_u8(int v) {
+    if (v < 0) return 0;
+    if (v > 255) return 255;
+    return (unsigned char)v;
+}
+
+static inline int clamp_int(int v, int lo, int hi) {
+    if (v < lo) return lo;
+    if (v > hi) return hi;
+    return v;
+}
+
+typedef void (*conv_rows_fn)(const unsigned char *in,
+                             unsigned char *out,
+                             int w, int h, int ch,
+                             const conv_kernel_t *kernel,
+                             int y_start, int y_end);
+
+// Direct kh x kw loop over every tap (the reference implementation).
+void convolve_baseline_rows(const unsigned char *in, unsigned char *out,
+                            int w, int h, int ch,
+                            const conv_kernel_t *kernel,
+                            int y_start, int y_end);
+
+// Two 1D passes (kh + kw taps per pixel). Requires kernel->separable.
+void convolve_separable_rows(const unsigned char *in, unsigned char *out,
+                             int w, int h, int ch,
+                             const conv_kernel_t *kernel,
+                             int y_start, int y_end);
+
+// Direct loop with exact int32 accumulation. Requires kernel->integer.
+void convolve_int_rows(const unsigned char *in, unsigned char *out,
+                       int w, int h, int ch,
+                       const conv_kernel_t *kernel,
+                       int y_start, int y_end);
+
+// Box filter from a summed-area table of each block of rows (4 lookups
+// per pixel, independent of the kernel size). Requires kernel->constant.
+void convolve_sat_rows(const unsigned char *in, unsigned char *out,
+                       int w, int h, int ch,
+                       const conv_kernel_t *kernel,
+                       int y_start, int y_end);
+
+// Overlap-save FFT convolution on T x T tiles (see conv_fft_tile_size).
+// Best for large dense kernels.
+void convolve_fft_rows(const unsigned char *in, unsigned char *out,
+                       int w, int h, int ch,
+                       const conv_kernel_t *kernel,
+                       int y_start, int y_end);
+
+// Winograd F(2x2, 3x3): 16 multiplies per 2x2 outputs instead of 36.
+// Requires a 3x3 kernel.
+void convolve_winograd_rows(const unsigned char *in, unsigned char *out,
+                            int w, int h, int ch,
+                            const conv_kernel_t *kernel,
+                            int y_start, int y_end);
+
+// FFT tile edge (a power of two) that minimizes work per output pixel.
+int conv_fft_tile_size(int kh, int kw);
+
+void convolve_baseline(const unsigned char *in, unsigned char *out,
+                       int w, int h, int ch, const conv_kernel_t *kernel);
+
+void convolve_looporder(const unsigned char *in, unsigned char *out,
+                        int w, int h, int ch, const conv_kernel_t *kernel,
+                        int order);
+
+void convolve_tiled(const unsigned char *in, unsigned char *out,
+                    int w, int h, int ch, const conv_kernel_t *kernel,
+                    int tile_y, int tile_x);
+
+void convolve_tiled_rows(const unsigned char *in, unsigned char *out,
+                         int w, int h, int ch, const conv_kernel_t *kernel,
+                         int tile_y, int tile_x, int y_start, int y_end);
+
+void convolve_unrolled(const unsigned char *in, unsigned char *out,
+                       int w, int h, int ch, const conv_kernel_t *kernel,
+                       int unroll_factor);
+
+void convolve_unrolled_rows(const unsigned char *in, unsigned char *out,
+                            int w, int h, int ch, const conv_kernel_t *kernel,
+                            int unroll_factor, int y_start, int y_end);
+
+// Split the rows into one contiguous band per thread (or into bands of
+// conv_set_band_rows rows, dealt round-robin) and run 'fn' on each
+// band. Falls back to a single-threaded call on failure.
+void run_pthreads_rows(conv_rows_fn fn,
+                       const unsigned char *in, unsigned char *out,
+                       int w, int h, int ch, const conv_kernel_t *kernel,
+                       int threads);
+
+// Same band split for the loop transforms: tiled when tile > 0,
+// otherwise unrolled when unroll > 1, otherwise the baseline loop.
+void run_pthreads_variant(const unsigned char *in, unsigned char *out,
+                          int w, int h, int ch, const conv_kernel_t *kernel,
+                          int tile, int unroll, int threads);
+
+void run_pthreads_baseline(const unsigned char *in, unsigned char *out,
+                           int w, int h, int ch, const conv_kernel_t *kernel,
+                           int threads);
+
+// Pin band thread i of the drivers above to cpus[i % n] (see
+// topo_affinity_cpus). NULL / 0 turns pinning off.
+void conv_set_affinity(const int *cpus, int n);
+
+// Rows per band of the drivers above (e.g. topo_conv_band_rows): with
+// more bands than threads, thread i runs bands i, i + threads, ...
+// 0 (the default) gives each thread one contiguous band.
+void conv_set_band_rows(int rows);
+
+// Allocate a w x h x ch image (from 'arena' when given, else malloc)
+// whose rows are first touched by the (pinned) thread that computes the
+// same band in run_pthreads_rows, so each band's pages land on that
+// thread's NUMA node. The rows of 'src' are copied in when given,
+// otherwise the buffer is zeroed.
+unsigned char *conv_alloc_banded(arena_t *arena, const unsigned char *src,
+                                 int w, int h, int ch, int threads);
+
+#ifdef _OPENMP
+void convolve_baseline_omp(const unsigned char *in, unsigned char *out,
+                           int w, int h, int ch, const conv_kernel_t *kernel,
+                           int threads);
+#endif
+
+#endif // CONVOLVE_H
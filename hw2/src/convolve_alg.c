@@ -0,0 +1,383 @@
+// HW2 - Parallel 2D Convolution using Pthreads
+// Algorithmic engines that change the amount of work rather than the
+// loop structure: summed-area tables (box kernels), overlap-save FFT
+// (large dense kernels) and Winograd F(2x2, 3x3) (3x3 kernels).
+// All of them follow the rows interface from convolve.h.
+
+#include "convolve.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// ------------------------------------------------------------
+// Summed-area table
+// ------------------------------------------------------------
+
+// Output rows are processed in blocks so the table stays small. The
+// table uses uint32 and relies on modular arithmetic: individual
+// entries may wrap, but the 4-corner difference is exact as long as
+// one box sum (255 * kh * kw) fits in 32 bits.
+#define SAT_BLOCK_ROWS 64
+
+void convolve_sat_rows(const unsigned char *in,
+                       unsigned char *out,
+                       int w, int h, int ch,
+                       const conv_kernel_t *kernel,
+                       int y_start, int y_end) {
+    int kh = kernel->kh, kw = kernel->kw;
+    int ry = kh / 2, rx = kw / 2;
+    double value = kernel->data[0];
+    int pw = w + 2 * rx;                 // padded width
+    size_t sat_stride = (size_t)(pw + 1) * ch;
+    if (y_start < 0) y_start = 0;
+    if (y_end > h) y_end = h;
+
+    uint32_t *sat = (uint32_t *)calloc((size_t)(SAT_BLOCK_ROWS + kh + 1) * sat_stride,
+                                       sizeof(uint32_t));
+    uint32_t *run = (uint32_t *)malloc((size_t)ch * sizeof(uint32_t));
+    if (!sat || !run) {
+        free(sat);
+        free(run);
+        convolve_baseline_rows(in, out, w, h, ch, kernel, y_start, y_end);
+        return;
+    }
+
+    for (int yb = y_start; yb < y_end; yb += SAT_BLOCK_ROWS) {
+        int ye = yb + SAT_BLOCK_ROWS;
+        if (ye > y_end) ye = y_end;
+        int rows = ye - yb + 2 * ry;
+
+        // Row 0 and column 0 of the table stay zero.
+        for (int r = 0; r < rows; ++r) {
+            const unsigned char *src = in + (size_t)clamp_int(yb - ry + r, 0, h - 1) * w * ch;
+            uint32_t *prev = sat + (size_t)r * sat_stride;
+            uint32_t *cur = prev + sat_stride;
+            for (int c = 0; c < ch; ++c) run[c] = 0;
+            for (int j = 0; j < pw; ++j) {
+                const unsigned char *p = src + (size_t)clamp_int(j - rx, 0, w - 1) * ch;
+                for (int c = 0; c < ch; ++c) {
+                    run[c] += p[c];
+                    cur[(j + 1) * ch + c] = prev[(j + 1) * ch + c] + run[c];
+                }
+            }
+        }
+
+        for (int y = yb; y < ye; ++y) {
+            const uint32_t *top = sat + (size_t)(y - yb) * sat_stride;
+            const uint32_t *bot = top + (size_t)kh * sat_stride;
+            unsigned char *o = out + (size_t)y * w * ch;
+            for (int x = 0; x < w; ++x) {
+                for (int c = 0; c < ch; ++c) {
+                    size_t j0 = (size_t)x * ch + c;
+                    size_t j1 = (size_t)(x + kw) * ch + c;
+                    uint32_t s = bot[j1] - top[j1] - bot[j0] + top[j0];
+                    o[(size_t)x * ch + c] = clamp_u8((int)lround(s * value));
+                }
+            }
+        }
+    }
+
+    free(sat);
+    free(run);
+}
+
+// ------------------------------------------------------------
+// FFT (overlap-save)
+// ------------------------------------------------------------
+
+typedef struct {
+    int n;
+    int *rev;        // bit-reversal permutation
+    double *cosv;    // twiddles cos(2 pi k / n), k < n / 2
+    double *sinv;
+} fft_plan_t;
+
+static void fft_plan_free(fft_plan_t *p) {
+    free(p->rev);
+    free(p->cosv);
+    free(p->sinv);
+}
+
+static int fft_plan_init(fft_plan_t *p, int n) {
+    int bits = 0;
+    while ((1 << bits) < n) ++bits;
+    p->n = n;
+    p->rev = (int *)malloc((size_t)n * sizeof(int));
+    p->cosv = (double *)malloc((size_t)(n / 2) * sizeof(double));
+    p->sinv = (double *)malloc((size_t)(n / 2) * sizeof(double));
+    if (!p->rev || !p->cosv || !p->sinv) {
+        fft_plan_free(p);
+        return -1;
+    }
+    for (int i = 0; i < n; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b)
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        p->rev[i] = r;
+    }
+    for (int k = 0; k < n / 2; ++k) {
+        p->cosv[k] = cos(2.0 * M_PI * k / n);
+        p->sinv[k] = sin(2.0 * M_PI * k / n);
+    }
+    return 0;
+}
+
+// In-place iterative radix-2 FFT of one contiguous line. The inverse
+// transform is unscaled.
+static void fft_line(const fft_plan_t *p, double *re, double *im, int inverse) {
+    int n = p->n;
+    for (int i = 0; i < n; ++i) {
+        int j = p->rev[i];
+        if (j > i) {
+            double t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+    double sign = inverse ? 1.0 : -1.0;
+    for (int len = 2; len <= n; len <<= 1) {
+        int half = len >> 1;
+        int step = n / len;
+        for (int i = 0; i < n; i += len) {
+            for (int k = 0; k < half; ++k) {
+                double wr = p->cosv[k * step];
+                double wi = sign * p->sinv[k * step];
+                int a = i + k, b = a + half;
+                double xr = re[b] * wr - im[b] * wi;
+                double xi = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - xr;
+                im[b] = im[a] - xi;
+                re[a] += xr;
+                im[a] += xi;
+            }
+        }
+    }
+}
+
+// 2D FFT of an n x n row-major grid (rows, then columns via a scratch
+// line so every 1D transform runs on contiguous memory).
+static void fft_2d(const fft_plan_t *p, double *re, double *im,
+                   double *col_re, double *col_im, int inverse) {
+    int n = p->n;
+    for (int y = 0; y < n; ++y)
+        fft_line(p, re + (size_t)y * n, im + (size_t)y * n, inverse);
+    for (int x = 0; x < n; ++x) {
+        for (int y = 0; y < n; ++y) {
+            col_re[y] = re[(size_t)y * n + x];
+            col_im[y] = im[(size_t)y * n + x];
+        }
+        fft_line(p, col_re, col_im, inverse);
+        for (int y = 0; y < n; ++y) {
+            re[(size_t)y * n + x] = col_re[y];
+            im[(size_t)y * n + x] = col_im[y];
+        }
+    }
+}
+
+int conv_fft_tile_size(int kh, int kw) {
+    int kmax = kh > kw ? kh : kw;
+    int best = 0;
+    double best_cost = 0.0;
+    for (int t = 16; t <= 1024; t <<= 1) {
+        if (t < 2 * kmax) continue;
+        double valid = (double)(t - kh + 1) * (t - kw + 1);
+        double cost = (double)t * t * log2((double)t * t) / valid;
+        if (best == 0 || cost < best_cost) {
+            best = t;
+            best_cost = cost;
+        }
+    }
+    return best ? best : 2048;
+}
+
+// Each (tile, channel) pair is one real-valued job. Two jobs share one
+// complex transform: job A goes in the real part, job B in the
+// imaginary part, and since the kernel is real the product with its
+// spectrum keeps them separate (result = A * K + i B * K).
+void convolve_fft_rows(const unsigned char *in,
+                       unsigned char *out,
+                       int w, int h, int ch,
+                       const conv_kernel_t *kernel,
+                       int y_start, int y_end) {
+    int kh = kernel->kh, kw = kernel->kw;
+    int ry = kh / 2, rx = kw / 2;
+    if (y_start < 0) y_start = 0;
+    if (y_end > h) y_end = h;
+    if (y_start >= y_end) return;
+
+    int t = conv_fft_tile_size(kh, kw);
+    int vh = t - kh + 1, vw = t - kw + 1;   // valid outputs per tile
+    size_t tt = (size_t)t * t;
+
+    fft_plan_t plan;
+    if (fft_plan_init(&plan, t) != 0) {
+        convolve_baseline_rows(in, out, w, h, ch, kernel, y_start, y_end);
+        return;
+    }
+    double *buf = (double *)malloc((4 * tt + 2 * (size_t)t) * sizeof(double));
+    if (!buf) {
+        fft_plan_free(&plan);
+        convolve_baseline_rows(in, out, w, h, ch, kernel, y_start, y_end);
+        return;
+    }
+    double *hre = buf, *him = buf + tt;
+    double *re = buf + 2 * tt, *im = buf + 3 * tt;
+    double *col_re = buf + 4 * tt, *col_im = col_re + t;
+
+    // Correlation = IFFT(FFT(tile) * conj(FFT(kernel at the origin))).
+    memset(hre, 0, 2 * tt * sizeof(double));
+    for (int y = 0; y < kh; ++y)
+        for (int x = 0; x < kw; ++x)
+            hre[(size_t)y * t + x] = kernel->data[y * kw + x];
+    fft_2d(&plan, hre, him, col_re, col_im, 0);
+    double scale = 1.0 / (double)tt;
+    for (size_t i = 0; i < tt; ++i) {
+        hre[i] *= scale;
+        him[i] = -him[i] * scale;
+    }
+
+    int tiles_y = (y_end - y_start + vh - 1) / vh;
+    int tiles_x = (w + vw - 1) / vw;
+    long jobs = (long)tiles_y * tiles_x * ch;
+
+    for (long j = 0; j < jobs; j += 2) {
+        for (int half = 0; half < 2; ++half) {
+            double *dst = half ? im : re;
+            long job = j + half;
+            if (job >= jobs) {
+                memset(dst, 0, tt * sizeof(double));
+                continue;
+            }
+            int c = (int)(job % ch);
+            long tile = job / ch;
+            int ty = y_start + (int)(tile / tiles_x) * vh;
+            int tx = (int)(tile % tiles_x) * vw;
+            for (int y = 0; y < t; ++y) {
+                const unsigned char *src = in + (size_t)clamp_int(ty - ry + y, 0, h - 1) * w * ch;
+                double *d = dst + (size_t)y * t;
+                for (int x = 0; x < t; ++x)
+                    d[x] = src[(size_t)clamp_int(tx - rx + x, 0, w - 1) * ch + c];
+            }
+        }
+
+        fft_2d(&plan, re, im, col_re, col_im, 0);
+        for (size_t i = 0; i < tt; ++i) {
+            double a = re[i], b = im[i];
+            re[i] = a * hre[i] - b * him[i];
+            im[i] = a * him[i] + b * hre[i];
+        }
+        fft_2d(&plan, re, im, col_re, col_im, 1);
+
+        for (int half = 0; half < 2 && j + half < jobs; ++half) {
+            const double *src = half ? im : re;
+            long job = j + half;
+            int c = (int)(job % ch);
+            long tile = job / ch;
+            int ty = y_start + (int)(tile / tiles_x) * vh;
+            int tx = (int)(tile % tiles_x) * vw;
+            for (int y = 0; y < vh && ty + y < y_end; ++y) {
+                unsigned char *o = out + ((size_t)(ty + y) * w) * ch;
+                for (int x = 0; x < vw && tx + x < w; ++x)
+                    o[(size_t)(tx + x) * ch + c] = clamp_u8((int)lround(src[(size_t)y * t + x]));
+            }
+        }
+    }
+
+    free(buf);
+    fft_plan_free(&plan);
+}
+
+// ------------------------------------------------------------
+// Winograd F(2x2, 3x3)
+// ------------------------------------------------------------
+
+// Y = A^T [ (G g G^T) .* (B^T d B) ] A with
+//   B^T = [1 0 -1 0; 0 1 1 0; 0 -1 1 0; 0 1 0 -1]
+//   G   = [1 0 0; 1/2 1/2 1/2; 1/2 -1/2 1/2; 0 0 1]
+//   A^T = [1 1 1 0; 0 1 -1 -1]
+// which computes the correlation used everywhere else in this program.
+void convolve_winograd_rows(const unsigned char *in,
+                            unsigned char *out,
+                            int w, int h, int ch,
+                            const conv_kernel_t *kernel,
+                            int y_start, int y_end) {
+    if (kernel->kh != 3 || kernel->kw != 3) {
+        convolve_baseline_rows(in, out, w, h, ch, kernel, y_start, y_end);
+        return;
+    }
+    if (y_start < 0) y_start = 0;
+    if (y_end > h) y_end = h;
+
+    // U = G g G^T (4x4), computed once.
+    const double *g = kernel->data;
+    double gt[4][3], u[4][4];
+    for (int j = 0; j < 3; ++j) {
+        gt[0][j] = g[0 * 3 + j];
+        gt[1][j] = 0.5 * (g[0 * 3 + j] + g[1 * 3 + j] + g[2 * 3 + j]);
+        gt[2][j] = 0.5 * (g[0 * 3 + j] - g[1 * 3 + j] + g[2 * 3 + j]);
+        gt[3][j] = g[2 * 3 + j];
+    }
+    for (int i = 0; i < 4; ++i) {
+        u[i][0] = gt[i][0];
+        u[i][1] = 0.5 * (gt[i][0] + gt[i][1] + gt[i][2]);
+        u[i][2] = 0.5 * (gt[i][0] - gt[i][1] + gt[i][2]);
+        u[i][3] = gt[i][2];
+    }
+
+    size_t stride = (size_t)w * ch;
+    for (int y0 = y_start; y0 < y_end; y0 += 2) {
+        const unsigned char *rows[4];
+        for (int i = 0; i < 4; ++i)
+            rows[i] = in + (size_t)clamp_int(y0 - 1 + i, 0, h - 1) * stride;
+
+        for (int x0 = 0; x0 < w; x0 += 2) {
+            int cols[4];
+            for (int j = 0; j < 4; ++j) cols[j] = clamp_int(x0 - 1 + j, 0, w - 1) * ch;
+
+            for (int c = 0; c < ch; ++c) {
+                double d[4][4], t[4][4], m[4][4];
+                for (int i = 0; i < 4; ++i)
+                    for (int j = 0; j < 4; ++j)
+                        d[i][j] = rows[i][cols[j] + c];
+
+                // t = B^T d
+                for (int j = 0; j < 4; ++j) {
+                    t[0][j] = d[0][j] - d[2][j];
+                    t[1][j] = d[1][j] + d[2][j];
+                    t[2][j] = d[2][j] - d[1][j];
+                    t[3][j] = d[1][j] - d[3][j];
+                }
+                // m = (t B) .* U
+                for (int i = 0; i < 4; ++i) {
+                    m[i][0] = (t[i][0] - t[i][2]) * u[i][0];
+                    m[i][1] = (t[i][1] + t[i][2]) * u[i][1];
+                    m[i][2] = (t[i][2] - t[i][1]) * u[i][2];
+                    m[i][3] = (t[i][1] - t[i][3]) * u[i][3];
+                }
+                // Y = A^T m A
+                double r0[4], r1[4];
+                for (int j = 0; j < 4; ++j) {
+                    r0[j] = m[0][j] + m[1][j] + m[2][j];
+                    r1[j] = m[1][j] - m[2][j] - m[3][j];
+                }
+                double y00 = r0[0] + r0[1] + r0[2];
+                double y01 = r0[1] - r0[2] - r0[3];
+                double y10 = r1[0] + r1[1] + r1[2];
+                double y11 = r1[1] - r1[2] - r1[3];
+
+                unsigned char *o = out + (size_t)y0 * stride + (size_t)x0 * ch + c;
+                o[0] = clamp_u8((int)lround(y00));
+                if (x0 + 1 < w) o[ch] = clamp_u8((int)lround(y01));
+                if (y0 + 1 < y_end) {
+                    o[stride] = clamp_u8((int)lround(y10));
+                    if (x0 + 1 < w) o[stride + ch] = clamp_u8((int)lround(y11));
+                }
+            }
+        }
+    }
+}
@@ -1,9 +1,12 @@
 // HW2 - Parallel 2D Convolution using Pthreads
-// Part 1: Baseline single-threaded convolution using stb_image
+// Driver: image I/O with stb_image, command line parsing and timing.
 // ------------------------------------------------------------
-// This file currently implements only the sequential version of
-// convolution. Later parts of the homework (pthreads, loop order,
-// tiling, unrolling, etc.) will extend this.
+// The convolution engines live in convolve.c / convolve_alg.c, the
+// kernels (generators, file loader, metadata) in conv_kernel.c and the
+// algorithm planner in conv_plan.c.
+
+// sched_setaffinity / move_pages for thread pinning (topology.h).
+#define _GNU_SOURCE
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -11,395 +14,127 @@
 #include "stb_image.h"
 #include "stb_image_write.h"
 
+#include "conv_kernel.h"
+#include "convolve.h"
+#include "conv_plan.h"
+#include "autotune.h"
+#include "tunedb.h"
+#define TOPOLOGY_IMPLEMENTATION
+#include "topology.h"
+#define ARENA_IMPLEMENTATION
+#include "arena.h"
+#define ROOFLINE_IMPLEMENTATION
+#include "roofline.h"
+#define TRACE_IMPLEMENTATION
+#include "trace.h"
+
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
+#include <string.h>
 #include <sys/time.h>
-#include <pthread.h>
-#ifdef _OPENMP
-#include <omp.h>
-#endif
-
-// Clamp integer value to [0, 255]
-static unsigned char clamp_u8(int v) {
-    if (v < 0) return 0;
-    if (v > 255) return 255;
-    return (unsigned char)v;
-}
-
-// Safe pixel access with clamped boundary conditions.
-// If (x, y) is outside the image, it is clamped to the nearest
-// valid coordinate.
-static unsigned char get_pixel(const unsigned char *img,
-                               int w, int h, int ch,
-                               int x, int y, int c) {
-    if (x < 0) x = 0;
-    if (x >= w) x = w - 1;
-    if (y < 0) y = 0;
-    if (y >= h) y = h - 1;
-    if (c < 0) c = 0;
-    if (c >= ch) c = ch - 1;
-
-    int idx = (y * w + x) * ch + c;
-    return img[idx];
-}
-
-// Generic 2D convolution for an image with "ch" channels. 
-// - in:  input image buffer (width * height * channels)
-// - out: output image buffer (same size as input)
-// - w, h, ch: image width, height, and number of channels
-// - kernel: ksize x ksize convolution kernel
-// - ksize: odd kernel size (e.g., 3, 5, 15, ...)
-static void convolve_baseline_rows(const unsigned char *in,
-                                   unsigned char *out,
-                                   int w, int h, int ch,
-                                   const double *kernel,
-                                   int ksize,
-                                   int y_start, int y_end) {
-    int r = ksize / 2; // radius
-    if (y_start < 0) y_start = 0;
-    if (y_end > h) y_end = h;
-
-    for (int y = y_start; y < y_end; ++y) {
-        for (int x = 0; x < w; ++x) {
-            for (int c = 0; c < ch; ++c) {
-                double sum = 0.0;
-
-                for (int ky = -r; ky <= r; ++ky) {
-                    for (int kx = -r; kx <= r; ++kx) {
-                        int sx = x + kx;
-                        int sy = y + ky;
-                        unsigned char p = get_pixel(in, w, h, ch, sx, sy, c);
-                        double kval = kernel[(ky + r) * ksize + (kx + r)];
-                        sum += p * kval;
-                    }
-                }
-
-                int iv = (int)lround(sum);
-                out[(y * w + x) * ch + c] = clamp_u8(iv);
-            }
-        }
-    }
-}
 
-static void convolve_baseline(const unsigned char *in,
-                              unsigned char *out,
-                              int w, int h, int ch,
-                              const double *kernel,
-                              int ksize) {
-    convolve_baseline_rows(in, out, w, h, ch, kernel, ksize, 0, h);
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage:\n");
+    fprintf(stderr, "  %s [options] input_image output_image [kernel]\n", prog);
+    fprintf(stderr, "  %s [options] input_image output_image threads kernel order tile unroll\n", prog);
+    fprintf(stderr, "Kernel: an odd size (3 = edge, other = box blur) or a spec such as\n");
+    fprintf(stderr, "  box:15  gaussian:7[:sigma]  log:9[:sigma]  sobelx:5  sobely:5\n");
+    fprintf(stderr, "  sharpen:3[:amount]  motion:9[:angle]  file:kernel.txt\n");
+    fprintf(stderr, "  sizes may be non-square, e.g. gaussian:9x5\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --direct       always use the generic direct loop (no planner)\n");
+    fprintf(stderr, "  --plan         print the chosen algorithm and the predicted costs\n");
+    fprintf(stderr, "  --wisdom=FILE  load planner costs from FILE; calibrate and save if missing\n");
+    fprintf(stderr, "  --calibrate    re-run the planner calibration (and update --wisdom)\n");
+    fprintf(stderr, "  --tune         search tile / unroll / threads, save to the tuning db, use the best\n");
+    fprintf(stderr, "  --tuned        read tile / unroll / threads from the tuning db ($TUNEDB or\n");
+    fprintf(stderr, "                 results/tuning.db)\n");
+    fprintf(stderr, "  --topo         print the cache topology and the defaults derived from it\n");
+    fprintf(stderr, "  --affinity=P   pin band threads: compact, scatter (default), none or a CPU\n");
+    fprintf(stderr, "                 list (0,2,4-7)\n");
+    fprintf(stderr, "  --band=R       rows per band, dealt round-robin to the threads (-1 = derived\n");
+    fprintf(stderr, "                 from the L2 size, default 0 = one band per thread)\n");
+    fprintf(stderr, "  --huge         put the image buffers in a 2 MiB huge-page arena\n");
+    fprintf(stderr, "  --roofline[=CSV]  place the run on the roofline of this host (roofs from\n");
+    fprintf(stderr, "                 $ROOFLINE or results/roofline.txt, measured if missing);\n");
+    fprintf(stderr, "                 optionally append the point to CSV\n");
+    fprintf(stderr, "  --trace=FILE   write a Chrome / Perfetto trace of the phases and band\n");
+    fprintf(stderr, "                 threads to FILE (default $TRACE, off if unset)\n");
+    fprintf(stderr, "threads = 0 uses one thread per physical core, tile = -1 derives the tile\n");
+    fprintf(stderr, "size from the L1d size.\n");
+    fprintf(stderr, "Example: %s input.jpg output.png gaussian:7\n", prog);
 }
 
-// Loop-order variant: currently just calls baseline.
-// 'order' can be used later to switch between different loop nestings.
-static void convolve_looporder(const unsigned char *in,
-                               unsigned char *out,
-                               int w, int h, int ch,
-                               const double *kernel,
-                               int ksize,
-                               int order) {
-    int r = ksize / 2;
-
-    if (order == 1) {
-        // Order: x, y, c, ky, kx
-        for (int x = 0; x < w; ++x) {
-            for (int y = 0; y < h; ++y) {
-                for (int c = 0; c < ch; ++c) {
-                    double sum = 0.0;
-                    for (int ky = -r; ky <= r; ++ky) {
-                        for (int kx = -r; kx <= r; ++kx) {
-                            int sx = x + kx;
-                            int sy = y + ky;
-                            unsigned char p = get_pixel(in, w, h, ch, sx, sy, c);
-                            double kval = kernel[(ky + r) * ksize + (kx + r)];
-                            sum += p * kval;
-                        }
-                    }
-                    int iv = (int)lround(sum);
-                    out[(y * w + x) * ch + c] = clamp_u8(iv);
-                }
-            }
-        }
-    } else if (order == 2) {
-        // Order: c, y, x, ky, kx
-        for (int c = 0; c < ch; ++c) {
-            for (int y = 0; y < h; ++y) {
-                for (int x = 0; x < w; ++x) {
-                    double sum = 0.0;
-                    for (int ky = -r; ky <= r; ++ky) {
-                        for (int kx = -r; kx <= r; ++kx) {
-                            int sx = x + kx;
-                            int sy = y + ky;
-                            unsigned char p = get_pixel(in, w, h, ch, sx, sy, c);
-                            double kval = kernel[(ky + r) * ksize + (kx + r)];
-                            sum += p * kval;
-                        }
-                    }
-                    int iv = (int)lround(sum);
-                    out[(y * w + x) * ch + c] = clamp_u8(iv);
-                }
-            }
-        }
+// Release the image buffers: 'img' is the stb_image buffer (NULL once
+// it has been copied into 'in'), 'pool' the arena holding in / out.
+static void free_buffers(arena_t *pool, unsigned char *img,
+                         unsigned char *in, unsigned char *out) {
+    if (pool) {
+        arena_release(pool);
     } else {
-        // Fallback to baseline order (y, x, c, ky, kx)
-        convolve_baseline(in, out, w, h, ch, kernel, ksize);
-    }
-}
-
-// Tiled variant: currently just calls baseline.
-// 'tile_y' and 'tile_x' control tile size and can be used later.
-static void convolve_tiled(const unsigned char *in,
-                           unsigned char *out,
-                           int w, int h, int ch,
-                           const double *kernel,
-                           int ksize,
-                           int tile_y, int tile_x) {
-    int r = ksize / 2;
-    if (tile_y <= 0 || tile_x <= 0) {
-        convolve_baseline(in, out, w, h, ch, kernel, ksize);
-        return;
-    }
-
-    for (int by = 0; by < h; by += tile_y) {
-        int y_end = by + tile_y;
-        if (y_end > h) y_end = h;
-
-        for (int bx = 0; bx < w; bx += tile_x) {
-            int x_end = bx + tile_x;
-            if (x_end > w) x_end = w;
-
-            for (int y = by; y < y_end; ++y) {
-                for (int x = bx; x < x_end; ++x) {
-                    for (int c = 0; c < ch; ++c) {
-                        double sum = 0.0;
-                        for (int ky = -r; ky <= r; ++ky) {
-                            for (int kx = -r; kx <= r; ++kx) {
-                                int sx = x + kx;
-                                int sy = y + ky;
-                                unsigned char p = get_pixel(in, w, h, ch, sx, sy, c);
-                                double kval = kernel[(ky + r) * ksize + (kx + r)];
-                                sum += p * kval;
-                            }
-                        }
-                        int iv = (int)lround(sum);
-                        out[(y * w + x) * ch + c] = clamp_u8(iv);
-                    }
-                }
-            }
-        }
-    }
-}
-
-// Unrolled variant: currently just calls baseline.
-// 'unroll_factor' can be used later to unroll the inner x-loop.
-static void convolve_unrolled(const unsigned char *in,
-                              unsigned char *out,
-                              int w, int h, int ch,
-                              const double *kernel,
-                              int ksize,
-                              int unroll_factor) {
-    int r = ksize / 2;
-    if (unroll_factor <= 1) {
-        convolve_baseline(in, out, w, h, ch, kernel, ksize);
-        return;
-    }
-
-    for (int y = 0; y < h; ++y) {
-        int x = 0;
-        int limit = w - (w % unroll_factor);
-
-        // Unrolled part
-        for (x = 0; x < limit; x += unroll_factor) {
-            for (int c = 0; c < ch; ++c) {
-                double sum[32]; // supports unroll_factor up to 32 safely
-                for (int i = 0; i < unroll_factor; ++i) {
-                    sum[i] = 0.0;
-                }
-
-                for (int ky = -r; ky <= r; ++ky) {
-                    for (int kx = -r; kx <= r; ++kx) {
-                        int sx_base = x + kx;
-                        int sy = y + ky;
-                        double kval = kernel[(ky + r) * ksize + (kx + r)];
-                        for (int i = 0; i < unroll_factor; ++i) {
-                            int sx = sx_base + i;
-                            unsigned char p = get_pixel(in, w, h, ch, sx, sy, c);
-                            sum[i] += p * kval;
-                        }
-                    }
-                }
-
-                for (int i = 0; i < unroll_factor; ++i) {
-                    int iv = (int)lround(sum[i]);
-                    int xx = x + i;
-                    out[(y * w + xx) * ch + c] = clamp_u8(iv);
-                }
-            }
-        }
-
-        // Remainder (tail) part
-        for (; x < w; ++x) {
-            for (int c = 0; c < ch; ++c) {
-                double sum = 0.0;
-                for (int ky = -r; ky <= r; ++ky) {
-                    for (int kx = -r; kx <= r; ++kx) {
-                        int sx = x + kx;
-                        int sy = y + ky;
-                        unsigned char p = get_pixel(in, w, h, ch, sx, sy, c);
-                        double kval = kernel[(ky + r) * ksize + (kx + r)];
-                        sum += p * kval;
-                    }
-                }
-                int iv = (int)lround(sum);
-                out[(y * w + x) * ch + c] = clamp_u8(iv);
-            }
-        }
-    }
-}
-
-typedef struct {
-    const unsigned char *in;
-    unsigned char *out;
-    int w, h, ch;
-    const double *kernel;
-    int ksize;
-    int y_start, y_end;
-} thread_args_t;
-
-static void *thread_func(void *arg) {
-    thread_args_t *t = (thread_args_t *)arg;
-    convolve_baseline_rows(t->in, t->out, t->w, t->h, t->ch,
-                           t->kernel, t->ksize, t->y_start, t->y_end);
-    return NULL;
-}
-
-static void run_pthreads_baseline(const unsigned char *in,
-                                  unsigned char *out,
-                                  int w, int h, int ch,
-                                  const double *kernel,
-                                  int ksize,
-                                  int threads) {
-    if (threads <= 1) {
-        convolve_baseline(in, out, w, h, ch, kernel, ksize);
-        return;
-    }
-    if (threads > h) {
-        threads = h;
-    }
-
-    pthread_t *tids = (pthread_t *)malloc(sizeof(pthread_t) * threads);
-    thread_args_t *args = (thread_args_t *)malloc(sizeof(thread_args_t) * threads);
-    if (!tids || !args) {
-        fprintf(stderr, "Warning: could not allocate thread structures, falling back to single-threaded baseline.\n");
-        free(tids);
-        free(args);
-        convolve_baseline(in, out, w, h, ch, kernel, ksize);
-        return;
-    }
-
-    int rows_per_thread = h / threads;
-    int remainder = h % threads;
-    int y = 0;
-
-    for (int i = 0; i < threads; ++i) {
-        int extra = (i < remainder) ? 1 : 0;
-        int y_start = y;
-        int y_end = y_start + rows_per_thread + extra;
-
-        args[i].in = in;
-        args[i].out = out;
-        args[i].w = w;
-        args[i].h = h;
-        args[i].ch = ch;
-        args[i].kernel = kernel;
-        args[i].ksize = ksize;
-        args[i].y_start = y_start;
-        args[i].y_end = y_end;
-
-        if (pthread_create(&tids[i], NULL, thread_func, &args[i]) != 0) {
-            fprintf(stderr, "Warning: pthread_create failed for thread %d, falling back to single-threaded baseline.\n", i);
-            for (int j = 0; j < i; ++j) {
-                pthread_join(tids[j], NULL);
-            }
-            free(tids);
-            free(args);
-            convolve_baseline(in, out, w, h, ch, kernel, ksize);
-            return;
-        }
-
-        y = y_end;
-    }
-
-    for (int i = 0; i < threads; ++i) {
-        pthread_join(tids[i], NULL);
+        free(out);
+        if (in != img) free(in);
     }
-
-    free(tids);
-    free(args);
+    if (img) stbi_image_free(img);
 }
 
-#ifdef _OPENMP
-static void convolve_baseline_omp(const unsigned char *in,
-                                  unsigned char *out,
-                                  int w, int h, int ch,
-                                  const double *kernel,
-                                  int ksize,
-                                  int threads) {
-    int r = ksize / 2;
-    if (threads <= 0) {
-        threads = 1;
-    }
-
-#pragma omp parallel for collapse(2) num_threads(threads)
-    for (int y = 0; y < h; ++y) {
-        for (int x = 0; x < w; ++x) {
-            for (int c = 0; c < ch; ++c) {
-                double sum = 0.0;
-                for (int ky = -r; ky <= r; ++ky) {
-                    for (int kx = -r; kx <= r; ++kx) {
-                        int sx = x + kx;
-                        int sy = y + ky;
-                        unsigned char p = get_pixel(in, w, h, ch, sx, sy, c);
-                        double kval = kernel[(ky + r) * ksize + (kx + r)];
-                        sum += p * kval;
-                    }
-                }
-                int iv = (int)lround(sum);
-                out[(y * w + x) * ch + c] = clamp_u8(iv);
-            }
+int main(int argc, char **argv) {
+    // Options may appear anywhere; strip them before the positional
+    // arguments are interpreted.
+    int direct = 0;
+    int print_plan = 0;
+    int calibrate = 0;
+    const char *wisdom_path = NULL;
+    int tune = 0;
+    int tuned = 0;
+    int print_topo = 0;
+    const char *affinity = NULL;
+    int band = 0;
+    int huge = 0;
+    int roofline = 0;
+    const char *roofline_csv = NULL;
+    const char *trace_path = NULL;
+    int nargs = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--direct") == 0) {
+            direct = 1;
+        } else if (strcmp(argv[i], "--plan") == 0) {
+            print_plan = 1;
+        } else if (strcmp(argv[i], "--calibrate") == 0) {
+            calibrate = 1;
+        } else if (strcmp(argv[i], "--tune") == 0) {
+            tune = 1;
+        } else if (strcmp(argv[i], "--tuned") == 0) {
+            tuned = 1;
+        } else if (strcmp(argv[i], "--topo") == 0) {
+            print_topo = 1;
+        } else if (strcmp(argv[i], "--huge") == 0) {
+            huge = 1;
+        } else if (strcmp(argv[i], "--roofline") == 0) {
+            roofline = 1;
+        } else if (strncmp(argv[i], "--roofline=", 11) == 0) {
+            roofline = 1;
+            roofline_csv = argv[i] + 11;
+        } else if (strncmp(argv[i], "--trace=", 8) == 0) {
+            trace_path = argv[i] + 8;
+        } else if (strncmp(argv[i], "--affinity=", 11) == 0) {
+            affinity = argv[i] + 11;
+        } else if (strncmp(argv[i], "--band=", 7) == 0) {
+            band = atoi(argv[i] + 7);
+        } else if (strncmp(argv[i], "--wisdom=", 9) == 0) {
+            wisdom_path = argv[i] + 9;
+        } else if (strncmp(argv[i], "--", 2) == 0) {
+            fprintf(stderr, "Error: unknown option '%s'\n", argv[i]);
+            usage(argv[0]);
+            return 1;
+        } else {
+            argv[nargs++] = argv[i];
         }
     }
-}
-#endif
-
-// Example 3x3 edge-detection kernel (Sobel-like, horizontal edges).
-// This matches the style of the example in the homework handout.
-static void make_edge_kernel_3x3(double *kernel, int *ksize_out) {
-    *ksize_out = 3;
-    double k[9] = {
-        -1, 0, 1,
-        -2, 0, 2,
-        -1, 0, 1
-    };
-    for (int i = 0; i < 9; ++i) {
-        kernel[i] = k[i];
-    }
-}
-
-// Generic ksize x ksize normalized box blur kernel.
-// For ksize = 15, this is the "large" kernel the homework wants.
-static void make_box_blur_kernel(double *kernel, int ksize) {
-    double v = 1.0 / (ksize * ksize);
-    int n = ksize * ksize;
-    for (int i = 0; i < n; ++i) {
-        kernel[i] = v;
-    }
-}
+    argc = nargs;
 
-int main(int argc, char **argv) {
     if (argc < 3) {
-        fprintf(stderr, "Usage: %s input_image output_image [ksize]\n", argv[0]);
-        fprintf(stderr, "Example: %s input.jpg output.png 3\n", argv[0]);
+        usage(argv[0]);
         return 1;
     }
 
@@ -407,12 +142,12 @@ int main(int argc, char **argv) {
     const char *output_path = argv[2];
 
     // Parameters controlling the convolution variant.
-    // ksize: kernel size (3 or 15 as required by the homework)
-    // threads: number of threads (not used yet, for future pthreads work)
+    // kernel_spec: kernel size or spec (see conv_kernel_from_spec)
+    // threads: number of threads (0 = one per physical core)
     // order: loop-order selection (0 = baseline)
-    // tile: tile size (0 = no tiling)
+    // tile: tile size (0 = no tiling, -1 = derived from the L1d size)
     // unroll: unroll factor (0 = no unrolling)
-    int ksize  = 3;
+    const char *kernel_spec = "3";
     int threads = 1;
     int order  = 0;
     int tile   = 0;
@@ -420,121 +155,290 @@ int main(int argc, char **argv) {
 
     // Supported argument patterns:
     //  1) prog input output
-    //  2) prog input output ksize
-    //  3) prog input output threads ksize order tile unroll  (used by run_exp target)
+    //  2) prog input output kernel
+    //  3) prog input output threads kernel order tile unroll  (used by run_exp target)
     if (argc == 3) {
         // defaults already set
     } else if (argc == 4) {
-        ksize = atoi(argv[3]);
+        kernel_spec = argv[3];
     } else if (argc == 8) {
-        threads = atoi(argv[3]);
-        ksize   = atoi(argv[4]);
-        order   = atoi(argv[5]);
-        tile    = atoi(argv[6]);
-        unroll  = atoi(argv[7]);
+        threads     = atoi(argv[3]);
+        kernel_spec = argv[4];
+        order       = atoi(argv[5]);
+        tile        = atoi(argv[6]);
+        unroll      = atoi(argv[7]);
     } else {
-        fprintf(stderr, "Usage:\n");
-        fprintf(stderr, "  %s input_image output_image [ksize]\n", argv[0]);
-        fprintf(stderr, "  %s input_image output_image threads ksize order tile unroll\n", argv[0]);
+        usage(argv[0]);
         return 1;
     }
 
-    if (ksize <= 0 || (ksize % 2) == 0) {
-        fprintf(stderr, "Error: ksize must be a positive odd integer (e.g. 3 or 15)\n");
-        return 1;
+    topo_t topo;
+    topo_discover(&topo);
+    if (threads <= 0) {
+        threads = topo_default_threads(&topo);
     }
 
-    if (threads <= 0) {
-        threads = 1;
+    // CPUs for every band thread the run (or --tune) may start; the
+    // placement of thread i does not depend on the thread count. Without
+    // --affinity the threads follow the topology's default placement.
+    {
+        const char *placement = affinity ? affinity : "scatter";
+        int ncpus = threads > topo.logical_cpus ? threads : topo.logical_cpus;
+        int *cpus = (int *)malloc((size_t)ncpus * sizeof(int));
+        int rc = cpus ? topo_affinity_cpus(&topo, placement, ncpus, cpus) : -1;
+        if (rc < 0) {
+            fprintf(stderr, "Error: bad affinity '%s'\n", placement);
+            free(cpus);
+            topo_free(&topo);
+            return 1;
+        }
+        if (rc == 0) {
+            conv_set_affinity(cpus, ncpus);
+            if (affinity || threads > 1) {
+                printf("Affinity %s%s: CPUs", placement, affinity ? "" : " (default)");
+                for (int i = 0; i < threads; ++i) printf(" %d", cpus[i]);
+                printf("\n");
+            }
+        }
+        free(cpus);
+    }
+
+    conv_kernel_t kernel;
+    if (conv_kernel_from_spec(&kernel, kernel_spec) != 0) {
+        fprintf(stderr, "Error: could not build kernel '%s'\n", kernel_spec);
+        topo_free(&topo);
+        return 1;
     }
+    conv_kernel_describe(&kernel, stdout);
 
+    trace_init(trace_path);
     int width, height, channels;
+    trace_scope_t load = trace_begin("load");
     unsigned char *img = stbi_load(input_path, &width, &height, &channels, 0);
+    trace_end(&load);
     if (!img) {
         fprintf(stderr, "Error: could not load image '%s'\n", input_path);
+        conv_kernel_free(&kernel);
+        topo_free(&topo);
         return 1;
     }
 
     printf("Loaded %s (%d x %d, %d channels)\n", input_path, width, height, channels);
 
+    if (tile < 0) {
+        tile = topo_conv_tile(&topo, channels, kernel.kh, kernel.kw);
+    }
+    if (band < 0) {
+        band = topo_conv_band_rows(&topo, width, channels, kernel.kh);
+    }
+    if (print_topo) {
+        int *cpus = (int *)malloc((size_t)threads * sizeof(int));
+        topo_print(&topo, stdout);
+        printf("Defaults: tile=%d threads=%d\n",
+               topo_conv_tile(&topo, channels, kernel.kh, kernel.kw), threads);
+        printf("Derived: band=%d rows (--band=-1), default placement CPUs",
+               topo_conv_band_rows(&topo, width, channels, kernel.kh));
+        if (cpus) {
+            topo_default_placement(&topo, threads, cpus);
+            for (int i = 0; i < threads; ++i) printf(" %d", cpus[i]);
+            free(cpus);
+        }
+        printf("\n");
+    }
+
+    // Tuned loop parameters replace the command line ones.
+    if (tune || tuned) {
+        conv_tune_t best;
+        int rc = -1;
+        if (tune) {
+            rc = conv_autotune(img, width, height, channels, &kernel,
+                               topo.logical_cpus, tunedb_default_path(), &best);
+        } else {
+            rc = conv_tuned_params(width, height, channels, &kernel, tunedb_default_path(), &best);
+            if (rc < 0) {
+                printf("No tuning result for this host in %s, using command line parameters\n",
+                       tunedb_default_path());
+            }
+        }
+        if (rc >= 0) {
+            threads = best.threads;
+            tile = best.tile;
+            unroll = best.unroll;
+            order = 0;
+            // The tuner timed tile = unroll = 0 as the direct loop, so
+            // that winner runs the direct loop, not the planner's engine.
+            if (tile == 0 && unroll == 0) {
+                direct = 1;
+            }
+            printf("Tuned%s: tile=%d unroll=%d threads=%d%s\n",
+                   rc == 1 ? " (from another problem size)" : "", tile, unroll, threads,
+                   direct ? " (direct loop)" : "");
+        }
+    }
+
+    // With several threads, the input is copied and the output zeroed
+    // band by band by the threads that will compute those bands
+    // (first touch), so on NUMA machines each band is node-local.
+    // --huge takes both buffers from a huge-page arena.
+    if (band > 0) {
+        conv_set_band_rows(band);
+        printf("Bands: %d rows, dealt round-robin to %d thread(s)\n", band, threads);
+    }
     size_t num_pixels = (size_t)width * (size_t)height;
     size_t buf_size = num_pixels * (size_t)channels;
-
-    unsigned char *out = (unsigned char *)malloc(buf_size);
-    if (!out) {
-        fprintf(stderr, "Error: could not allocate output buffer\n");
-        stbi_image_free(img);
+    arena_t arena;
+    arena_t *pool = NULL;
+    if (huge) {
+        if (arena_init(&arena, 2 * (buf_size + ARENA_ALIGN), ARENA_HUGE) == 0) {
+            pool = &arena;
+        } else {
+            fprintf(stderr, "Warning: could not map a huge-page arena, using malloc\n");
+        }
+    }
+    unsigned char *in = img;
+    unsigned char *out = NULL;
+    if (threads > 1 || pool) {
+        in = conv_alloc_banded(pool, img, width, height, channels, threads);
+        out = conv_alloc_banded(pool, NULL, width, height, channels, threads);
+    } else {
+        out = (unsigned char *)malloc(buf_size);
+    }
+    if (!in || !out) {
+        fprintf(stderr, "Error: could not allocate image buffers\n");
+        conv_kernel_free(&kernel);
+        topo_free(&topo);
+        free_buffers(pool, img, in, out);
         return 1;
     }
-
-    // Build the kernel depending on ksize.
-    int kernel_elems = ksize * ksize;
-    double *kernel = (double *)malloc(kernel_elems * sizeof(double));
-    if (!kernel) {
-        fprintf(stderr, "Error: could not allocate kernel (ksize = %d)\n", ksize);
-        free(out);
+    if (in != img) {
         stbi_image_free(img);
-        return 1;
+        img = NULL;
+    }
+    if (pool) {
+        printf("Pages: %s, %zu MiB on huge pages\n", arena_pages_name(pool),
+               arena_huge_bytes(pool) >> 20);
+    }
+    if (affinity || print_topo) {
+        topo_print_buffer_nodes(&topo, "in", in, buf_size, stdout);
+        topo_print_buffer_nodes(&topo, "out", out, buf_size, stdout);
     }
 
-    if (ksize == 3) {
-        int dummy_ksize_out = 0;
-        make_edge_kernel_3x3(kernel, &dummy_ksize_out);   // 3x3 edge detection
-    } else if (ksize == 15) {
-        make_box_blur_kernel(kernel, ksize);              // 15x15 box blur
-    } else {
-        fprintf(stderr, "Error: unsupported ksize = %d (use 3 or 15 for now)\n", ksize);
-        free(kernel);
-        free(out);
-        stbi_image_free(img);
-        return 1;
+    // The default engine is chosen by the planner from the kernel
+    // metadata and the (possibly calibrated) cost model; --direct keeps
+    // the reference loop.
+    trace_scope_t planning = trace_begin("plan");
+    conv_wisdom_t wisdom;
+    conv_wisdom_defaults(&wisdom);
+    if (wisdom_path && !calibrate && conv_wisdom_load(&wisdom, wisdom_path) != 0) {
+        printf("No usable wisdom in %s, calibrating...\n", wisdom_path);
+        calibrate = 1;
+    }
+    if (calibrate) {
+        conv_wisdom_calibrate(&wisdom);
+        if (wisdom_path && conv_wisdom_save(&wisdom, wisdom_path) == 0) {
+            printf("Saved wisdom to %s\n", wisdom_path);
+        }
+    }
+    conv_plan_t plan = conv_plan_create(&wisdom, width, height, channels, &kernel, threads);
+    if (direct) {
+        plan.alg = CONV_ALG_DIRECT;
+        plan.fn = convolve_baseline_rows;
     }
+    if (print_plan) {
+        conv_plan_print(&plan, &wisdom, width, height, channels, &kernel, stdout);
+    }
+    trace_end(&planning);
 
     // Run convolution (single-threaded or multi-threaded) and measure time.
     struct timeval t0, t1;
+    trace_scope_t convolve = trace_begin("convolve");
     gettimeofday(&t0, NULL);
 
-    if (threads > 1 && order == 0 && tile == 0 && unroll == 0) {
+    if (order == 0 && tile == 0 && unroll == 0) {
 #ifdef _OPENMP
-        // OpenMP-parallel baseline
-        convolve_baseline_omp(img, out, width, height, channels, kernel, ksize, threads);
-#else
-        // Pthreads-parallel baseline
-        run_pthreads_baseline(img, out, width, height, channels, kernel, ksize, threads);
+        if (direct && threads > 1) {
+            // OpenMP-parallel baseline
+            convolve_baseline_omp(in, out, width, height, channels, &kernel, threads);
+        } else
 #endif
-    } else if (tile > 0) {
-        // Tiled version (single-threaded)
-        convolve_tiled(img, out, width, height, channels, kernel, ksize, tile, tile);
-    } else if (unroll > 0) {
-        // Unrolled version (single-threaded)
-        convolve_unrolled(img, out, width, height, channels, kernel, ksize, unroll);
+        {
+            // Pthreads-parallel (or single-threaded) default engine
+            printf("Engine: %s, %d thread(s)\n", conv_alg_name(plan.alg), threads);
+            run_pthreads_rows(plan.fn, in, out, width, height, channels, &kernel, threads);
+        }
+    } else if (tile > 0 || unroll > 0) {
+        // Tiled or unrolled version, split into row bands when threads > 1
+        run_pthreads_variant(in, out, width, height, channels, &kernel, tile, unroll, threads);
     } else if (order != 0) {
         // Loop-order variant (single-threaded)
-        convolve_looporder(img, out, width, height, channels, kernel, ksize, order);
+        convolve_looporder(in, out, width, height, channels, &kernel, order);
     } else {
         // Baseline version (single-threaded)
-        convolve_baseline(img, out, width, height, channels, kernel, ksize);
+        convolve_baseline(in, out, width, height, channels, &kernel);
     }
 
     gettimeofday(&t1, NULL);
+    trace_end(&convolve);
     double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_usec - t0.tv_usec) / 1e6;
     printf("CONV_TIME %f\n", elapsed);
 
+    if (roofline) {
+        // Each counted op (tap, pass or butterfly) is taken as one
+        // multiply-add; the traffic is the compulsory one, reading the
+        // input and writing the output once, from the level they fit in.
+        // The loop-order variant runs on one thread.
+        int variant = order != 0 || tile > 0 || unroll > 0;
+        int roof_threads = (order != 0 && tile <= 0 && unroll <= 0) ? 1 : threads;
+        char name[64];
+        if (variant) {
+            snprintf(name, sizeof(name), "order%d tile%d unroll%d", order, tile, unroll);
+        } else {
+            snprintf(name, sizeof(name), "%s", conv_alg_name(plan.alg));
+        }
+        roof_point_t pt;
+        pt.name = name;
+        pt.flops = 2.0 * conv_alg_ops(variant ? CONV_ALG_DIRECT : plan.alg, width, height,
+                                      channels, &kernel);
+        pt.bytes = 2.0 * (double)buf_size;
+        pt.seconds = elapsed;
+        pt.level = roof_level_for(&topo, pt.bytes);
+        pt.f32 = 0;
+        roof_machine_t m;
+        roof_get(&m, &topo, roof_threads, roof_default_path(), 0);
+        roof_print_machine(&m, stdout);
+        roof_report(&m, &pt, 1, stdout);
+        if (roofline_csv) {
+            FILE *f = fopen(roofline_csv, "a");
+            if (f) {
+                roof_write_csv(&m, &pt, 1, f);
+                fclose(f);
+                printf("Appended roofline point to %s\n", roofline_csv);
+            } else {
+                fprintf(stderr, "Warning: could not append to '%s'\n", roofline_csv);
+            }
+        }
+    }
+
     // Save output image as PNG. You can also use JPG if you want, but
     // PNG is lossless and avoids compression artifacts.
     int stride_in_bytes = width * channels;
-    if (!stbi_write_png(output_path, width, height, channels, out, stride_in_bytes)) {
+    trace_scope_t saving = trace_begin("write");
+    int written = stbi_write_png(output_path, width, height, channels, out, stride_in_bytes);
+    trace_end(&saving);
+    trace_finish();
+    if (!written) {
         fprintf(stderr, "Error: could not write output image '%s'\n", output_path);
-        free(kernel);
-        free(out);
-        stbi_image_free(img);
+        conv_kernel_free(&kernel);
+        topo_free(&topo);
+        free_buffers(pool, img, in, out);
         return 1;
     }
 
     printf("Wrote %s\n", output_path);
 
-    free(kernel);
-    free(out);
-    stbi_image_free(img);
+    conv_kernel_free(&kernel);
+    topo_free(&topo);
+    free_buffers(pool, img, in, out);
+    conv_set_affinity(NULL, 0);
     return 0;
-}
\ No newline at end of file
+}